@@ -5,6 +5,7 @@
 
 #include "OpenGL/OGLRenderData.hpp"
 #include "Model/ModelAndInstanceData.hpp"
+#include "Model/AssimpAnimClip.hpp"
 
 class UserInterface {
   public:
@@ -33,6 +34,9 @@ class UserInterface {
     std::vector<float> mMatrixGenerationValues{};
     int mNumMatrixGenerationValues = 90;
 
+    std::vector<float> mAnimUpdateValues{};
+    int mNumAnimUpdateValues = 90;
+
     std::vector<float> mMatrixUploadValues{};
     int mNumMatrixUploadValues = 90;
 
@@ -49,9 +53,17 @@ class UserInterface {
     int mFrameTimeOffset = 0;
     int mModelUploadOffset = 0;
     int mMatrixGenOffset = 0;
+    int mAnimUpdateOffset = 0;
     int mMatrixUploadOffset = 0;
     int mUiGenOffset = 0;
     int mUiDrawOffset = 0;
 
     int mManyInstanceCreateNum = 1;
+
+    /* applied to the selected model on request, re-packing all clips takes a while */
+    AnimCompressionSettings mAnimCompressionSettings{};
+
+    /* crossfade time of clip changes in seconds, and the blend layer shown for the selected instance */
+    float mAnimCrossFadeTime = 0.25f;
+    int mAnimLayerNr = 0;
 };
@@ -0,0 +1,57 @@
+/* blend stack of the instances, the crossfades and layers of many instances are sampled in batches per clip */
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "Model/AssimpModel.hpp"
+#include "Model/InstanceSettings.hpp"
+#include "OpenGL/OGLRenderData.hpp"
+
+/* one sampled layer of one instance */
+struct AnimBlendJob {
+  /* 0 is the crossfade, the layers follow in order */
+  unsigned int abjLevel = 0;
+  unsigned int abjClipNr = 0;
+  float abjTime = 0.0f;
+  float abjWeight = 0.0f;
+  animBlendMode abjMode = animBlendMode::replace;
+  int abjBoneMask = -1;
+  NodeTransformData* abjPose = nullptr;
+};
+
+struct AnimBlendStats {
+  unsigned int absBlendedInstances = 0;
+  unsigned int absSampledLayers = 0;
+};
+
+class AssimpAnimBlender {
+  public:
+    /* the statistics are kept */
+    void clear();
+
+    /* collects the crossfade and the active layers of the instance, 'pose' already contains the base clip */
+    void addInstance(const InstanceSettings& settings, NodeTransformData* pose);
+
+    /* samples the collected layers, one batch per stack level and clip, and blends them into the poses of the instances.
+     * the levels are done one after another, the cost grows with the number of active layers only.
+     * returns the processing time summed over all threads in milliseconds */
+    float blendLayers(const std::shared_ptr<AssimpModel>& model, size_t numBones, bool useNlerp = false);
+
+    const AnimBlendStats& getStatistics();
+    void resetStatistics();
+
+    /* blends 'layerPose' into 'pose'. the reference pose is only used by additive layers, the bone mask may be nullptr */
+    static void blendPose(NodeTransformData* pose, const NodeTransformData* layerPose, size_t numBones, float weight,
+      animBlendMode mode, const NodeTransformData* referencePose, const float* boneMask);
+
+  private:
+    /* jobs per parallel task, the same as the sampling of the base clips */
+    static constexpr size_t mBlendGrainSize = 32;
+
+    AnimBlendStats mStats{};
+
+    std::vector<AnimBlendJob> mJobs{};
+    std::vector<float> mTimes{};
+    std::vector<NodeTransformData> mLayerPoses{};
+};
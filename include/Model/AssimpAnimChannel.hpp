@@ -9,20 +9,50 @@
 
 #include <assimp/anim.h>
 
+/* per-instance playback cursor, stores the last key index of every track of a channel */
+struct AnimChannelCursor {
+  unsigned int translationKey = 0;
+  unsigned int rotationKey = 0;
+  unsigned int scaleKey = 0;
+};
+
 class AssimpAnimChannel {
   public:
     void loadChannelData(aiNodeAnim* nodeAnim);
     std::string getTargetNodeName();
     float getMaxTime();
 
+    /* binary search for the key on every call */
     glm::vec4 getTranslation(float time); // last element is ignored
     glm::vec4 getScaling(float time); // last element is ignored
     glm::vec4 getRotation(float time); // is a quaternion, but return vec4 for shader
 
+    /* start the key search at the cursor position, and update the cursor */
+    glm::vec4 getTranslation(float time, unsigned int& cursor);
+    glm::vec4 getScaling(float time, unsigned int& cursor);
+    glm::vec4 getRotation(float time, unsigned int& cursor);
+
     int getBoneId();
     void setBoneId(unsigned int id);
 
+    unsigned int getPreState();
+    unsigned int getPostState();
+
+    /* raw key data, used to build the packed clip data */
+    const std::vector<float>& getTranslationTimings();
+    const std::vector<glm::vec3>& getTranslations();
+    const std::vector<float>& getRotationTimings();
+    const std::vector<glm::quat>& getRotations();
+    const std::vector<float>& getScaleTimings();
+    const std::vector<glm::vec3>& getScalings();
+
+    /* returns the index of the key section containing 'time', needs at least two keys */
+    static unsigned int findKeyIndex(const float* timings, unsigned int numKeys, float time, unsigned int& cursor);
+
   private:
+    /* number of keys the cursor may move forward before we fall back to a binary search */
+    static constexpr unsigned int mMaxCursorSteps = 4;
+
     std::string mNodeName;
 
     /* use separate timinigs vectors, just in case not all keys have the same time */
@@ -3,16 +3,155 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
 
 #include <assimp/anim.h>
 
 #include "AssimpAnimChannel.hpp"
 #include "Model/AssimpBone.hpp"
 
+/* key timings of one track type for all channels of a clip, in a single array */
+struct PackedAnimTrack {
+  /* first key and number of keys of every channel */
+  std::vector<unsigned int> keyOffsets{};
+  std::vector<unsigned int> keyCounts{};
+
+  std::vector<float> timings{};
+  /* same index as the timings, the entry for the last key of a channel is unused */
+  std::vector<float> inverseTimeDiffs{};
+
+  /* channels collapsed to their first key (and their last key for the time range, depending on the post state).
+   * the first key is used between the first and the last key time, the pre and post states still apply */
+  std::vector<unsigned char> constantChannels{};
+
+  /* resampled clips only, the time of the first and the last original key of every channel */
+  std::vector<glm::vec2> keyRanges{};
+};
+
+/* lossy key compression, applied when the packed clip is created.
+ * the errors are the maximum allowed distance of a removed key to the interpolation
+ * of the remaining keys, in model units (translation, scale) and radians (rotation) */
+struct AnimCompressionSettings {
+  bool enabled = true;
+  float translationError = 0.001f;
+  float rotationError = 0.001f;
+  float scaleError = 0.001f;
+  /* 48 bit smallest-three rotations, 16 bit range-quantized translations */
+  bool quantize = true;
+  /* resample all tracks at a fixed rate (in keys per second), replaces the key reduction.
+   * the keys of all tracks share the same times, the key index is calculated instead of searched */
+  bool resample = false;
+  float resampleRate = 30.0f;
+};
+
+struct AnimCompressionStats {
+  unsigned int rawKeys = 0;
+  unsigned int packedKeys = 0;
+  unsigned int constantTracks = 0;
+  size_t rawSize = 0;
+  size_t packedSize = 0;
+  /* resampling: size of the key values added, and size of the key timings no longer needed */
+  size_t resampleGrowth = 0;
+  size_t resampleSavings = 0;
+};
+
+/* all key frames of a clip, indexed by channel number */
+struct PackedAnimClip {
+  unsigned int numChannels = 0;
+  std::vector<int> boneIds{};
+  std::vector<unsigned int> preStates{};
+  std::vector<unsigned int> postStates{};
+
+  PackedAnimTrack translationTrack{};
+  std::vector<glm::vec3> translations{};
+
+  PackedAnimTrack rotationTrack{};
+  std::vector<glm::quat> rotations{};
+
+  PackedAnimTrack scaleTrack{};
+  std::vector<glm::vec3> scalings{};
+
+  /* largest angle (in radians) between NLERP and SLERP, measured over all rotation keys */
+  float maxNlerpError = 0.0f;
+
+  /* resampled clip, key n of every track that is not constant is at n / framesPerTick.
+   * the tracks have no timings and no inverse time differences */
+  bool uniform = false;
+  float framesPerTick = 0.0f;
+  unsigned int numFrames = 0;
+
+  /* quantized keys, replace 'translations' and 'rotations' if set */
+  bool quantized = false;
+  /* per channel, value = min + scale * quantized value */
+  std::vector<glm::vec3> translationMins{};
+  std::vector<glm::vec3> translationScales{};
+  /* three values per key */
+  std::vector<uint16_t> quantizedTranslations{};
+  std::vector<uint16_t> quantizedRotations{};
+
+  float getKeyTime(const PackedAnimTrack& track, unsigned int channel, unsigned int key) const {
+    if (!uniform) {
+      return track.timings[key];
+    }
+    return static_cast<float>(key - track.keyOffsets[channel]) / framesPerTick;
+  }
+
+  float getInverseKeyTimeDiff(const PackedAnimTrack& track, unsigned int key) const {
+    if (!uniform) {
+      return track.inverseTimeDiffs[key];
+    }
+    return framesPerTick;
+  }
+
+  glm::vec3 getTranslation(unsigned int channel, unsigned int key) const {
+    if (!quantized) {
+      return translations[key];
+    }
+    const uint16_t* value = &quantizedTranslations[key * 3];
+    return translationMins[channel] + translationScales[channel] * glm::vec3(value[0], value[1], value[2]);
+  }
+
+  /* the two highest bits of the first two values contain the index of the dropped (largest) component */
+  glm::quat getRotation(unsigned int key) const {
+    if (!quantized) {
+      return rotations[key];
+    }
+    const uint16_t* value = &quantizedRotations[key * 3];
+    unsigned int largest = ((value[0] >> 15) << 1) | (value[1] >> 15);
+
+    float components[4];
+    float sumOfSquares = 0.0f;
+    unsigned int index = 0;
+    for (unsigned int i = 0; i < 4; ++i) {
+      if (i == largest) {
+        continue;
+      }
+      /* maps [0, 32767] to [-1/sqrt(2), 1/sqrt(2)] */
+      float component = (static_cast<float>(value[index++] & 0x7fff) / 32767.0f - 0.5f) * 1.41421356f;
+      components[i] = component;
+      sumOfSquares += component * component;
+    }
+    components[largest] = std::sqrt(std::max(1.0f - sumOfSquares, 0.0f));
+
+    return glm::quat(components[3], components[0], components[1], components[2]);
+  }
+};
+
 class AssimpAnimClip {
   public:
-    void addChannels(aiAnimation* animation, std::vector<std::shared_ptr<AssimpBone>> boneList);
+    void addChannels(aiAnimation* animation, const std::vector<std::shared_ptr<AssimpBone>>& boneList,
+      const AnimCompressionSettings& compressionSettings = AnimCompressionSettings{});
+    /* rebuilds the packed clip from the full channel data */
+    void compress(const AnimCompressionSettings& compressionSettings);
+    const AnimCompressionSettings& getCompressionSettings();
+    const AnimCompressionStats& getCompressionStats();
     const std::vector<std::shared_ptr<AssimpAnimChannel>>& getChannels();
+    const PackedAnimClip& getPackedClip();
 
     std::string getClipName();
     float getClipDuration();
@@ -21,10 +160,18 @@ class AssimpAnimClip {
     void setClipName(std::string name);
 
   private:
+    void createPackedClip();
+    void resamplePackedClip();
+    void quantizePackedClip();
+    float measureNlerpError();
+
     std::string mClipName;
     float mClipDuration = 0.0f;
     float mClipTicksPerSecond = 0.0f;
 
     std::vector<std::shared_ptr<AssimpAnimChannel>> mAnimChannels{};
-};
+    PackedAnimClip mPackedClip{};
 
+    AnimCompressionSettings mCompressionSettings{};
+    AnimCompressionStats mCompressionStats{};
+};
@@ -0,0 +1,42 @@
+/* SIMD interpolation kernels for the batched clip sampler */
+#pragma once
+
+#include <cstddef>
+
+enum class simdLevel {
+  scalar = 0,
+  sse,
+  avx2
+};
+
+/* lanes of a batched interpolation, as structure of arrays
+ * vectors use the first three components, quaternions are stored in x/y/z/w order */
+struct AnimInterpolationBatch {
+  static constexpr unsigned int maxLanes = 64;
+  unsigned int numLanes = 0;
+
+  alignas(32) float from[4][maxLanes];
+  alignas(32) float to[4][maxLanes];
+  alignas(32) float factor[maxLanes];
+  alignas(32) float result[4][maxLanes];
+};
+
+class AssimpAnimKernels {
+  public:
+    /* best instruction set supported by the CPU, detected once */
+    static simdLevel getSupportedSimdLevel();
+    /* kernel level in use, can be lowered to compare the implementations */
+    static simdLevel getSimdLevel();
+    static void setSimdLevel(simdLevel level);
+    static const char* getSimdLevelName(simdLevel level);
+
+    /* result = mix(from, to, factor) */
+    static void lerpVec3(AnimInterpolationBatch& batch);
+    /* spherical linear interpolation, normalized result */
+    static void slerpQuat(AnimInterpolationBatch& batch);
+    /* normalized linear interpolation, faster but not constant speed */
+    static void nlerpQuat(AnimInterpolationBatch& batch);
+
+  private:
+    static simdLevel mSimdLevel;
+};
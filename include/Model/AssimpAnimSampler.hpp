@@ -0,0 +1,17 @@
+/* batched key frame sampling, evaluates one clip for many instances */
+#pragma once
+
+#include <memory>
+
+#include "Model/AssimpAnimClip.hpp"
+#include "OpenGL/OGLRenderData.hpp"
+
+class AssimpAnimSampler {
+  public:
+    /* writes the node transforms of instance i to out[i * numBones] ... out[i * numBones + numBones - 1],
+     * the same layout the compute shaders use. 'cursors' may be nullptr, otherwise it contains a pointer
+     * to the channel cursors (one per clip channel) of every instance.
+     * 'useNlerp' replaces the rotation SLERP by the faster NLERP, see PackedAnimClip::maxNlerpError */
+    static void sampleClip(const std::shared_ptr<AssimpAnimClip>& clip, const float* times, size_t numInstances, size_t numBones,
+      NodeTransformData* out, AnimChannelCursor* const* cursors = nullptr, bool useNlerp = false);
+};
@@ -0,0 +1,23 @@
+/* bone hierarchy sorted by depth, and CPU versions of the bone matrix compute shaders */
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+class AssimpBoneHierarchy {
+  public:
+    /* sorts the bones by their depth, the parent of a bone is always in an earlier level.
+     * 'levelOffsets' contains the first entry of every level in 'levelOrder', plus the end */
+    static void createLevelOrder(const std::vector<int32_t>& parentIndices, std::vector<int32_t>& levelOrder, std::vector<int32_t>& levelOffsets);
+
+    /* boneMatrices[i] = global matrix of bone i * offsetMatrices[i], 'localMatrices' are the TRS matrices of the bones */
+    /* walks the parent chain of every bone, same as assimp_instance_matrix_mult.comp */
+    static void computeBoneMatricesParentWalk(const glm::mat4* localMatrices, const int32_t* parentIndices, const glm::mat4* offsetMatrices,
+      size_t numBones, glm::mat4* boneMatrices);
+    /* one multiplication per bone, same as assimp_instance_transform_levels.comp. needs 'numBones' global matrices as scratch space */
+    static void computeBoneMatricesLevelOrder(const glm::mat4* localMatrices, const int32_t* parentIndices, const std::vector<int32_t>& levelOrder,
+      const glm::mat4* offsetMatrices, size_t numBones, glm::mat4* globalMatrices, glm::mat4* boneMatrices);
+};
@@ -10,10 +10,14 @@
 #include "AssimpNode.hpp"
 #include "AssimpBone.hpp"
 #include "InstanceSettings.hpp"
+#include "AssimpInstanceStore.hpp"
+#include "AssimpAnimBlender.hpp"
 
 class AssimpInstance {
   public:
     AssimpInstance(std::shared_ptr<AssimpModel> model, glm::vec3 position = glm::vec3(0.0f), glm::vec3 rotation = glm::vec3(0.0f), float modelScale = 1.0f);
+    /* created by the store, the transform and the state of the base clip are kept in the arrays of the store */
+    AssimpInstance(std::shared_ptr<AssimpModel> model, AssimpInstanceStore* store, InstanceHandle handle);
     std::shared_ptr<AssimpModel> getModel();
     glm::vec3 getWorldPosition();
     glm::mat4 getWorldTransformMatrix();
@@ -28,28 +32,80 @@ class AssimpInstance {
     float getScale();
     bool getSwapYZAxis();
 
-    std::vector<NodeTransformData> getNodeTransformData();
+    const std::vector<NodeTransformData>& getNodeTransformData();
 
     void setInstanceSettings(InstanceSettings settings);
     InstanceSettings getInstanceSettings();
 
+    /* nullptr if the instance is not (or no longer) kept in a store */
+    AssimpInstanceStore* getInstanceStore();
+    InstanceHandle getInstanceHandle();
+    /* called by the store on removal, the instance keeps a copy of its data */
+    void detachFromStore();
+
+    /* position in the list of all instances, kept by the renderer */
+    void setInstanceListIndex(size_t index);
+    size_t getInstanceListIndex();
+
     void updateModelRootMatrix();
     void updateAnimation(float deltaTime);
+    /* writes the node transforms to the caller's memory instead, needs at least one entry per bone */
+    void updateAnimation(float deltaTime, NodeTransformData* nodeTransformData, size_t numNodeTransforms);
+
+    /* only advance the play time, the clip is sampled by the caller */
+    void updateAnimationTime(float deltaTime);
+
+    /* the current clip is faded out while the new clip starts, a running crossfade is cut short */
+    void crossFadeToClip(unsigned int clipNr, float duration);
+    /* true if a crossfade or a layer needs to be blended over the base clip */
+    bool hasAnimBlending();
+    AnimChannelCursor* getAnimChannelCursors();
+
+    /* animation LOD, the last sampled pose is reused on the frames the instance is skipped */
+    void setAnimLod(unsigned int level, bool skipUpdate);
+    unsigned int getAnimLodLevel();
+    bool getAnimLodSkip();
+    /* the stored pose is only valid for the clip it was sampled from */
+    bool hasAnimLodPose();
+    void invalidateAnimLodPose();
+    /* copies one entry per bone */
+    void storeAnimLodPose(const NodeTransformData* nodeTransformData);
+    void loadAnimLodPose(NodeTransformData* nodeTransformData);
 
   private:
-    std::shared_ptr<AssimpModel> mAssimpModel = nullptr;
+    void init();
 
-    InstanceSettings mInstanceSettings{};
+    /* the fields kept in the store, or in the settings and the root matrix if there is no store */
+    glm::vec3& storedPosition();
+    glm::vec3& storedRotation();
+    float& storedScale();
+    unsigned int& storedAnimClipNr();
+    float& storedAnimPlayTimePos();
+    float& storedAnimSpeedFactor();
+    glm::mat4& storedWorldMatrix();
 
-    glm::mat4 mLocalTranslationMatrix = glm::mat4(1.0f);
-    glm::mat4 mLocalRotationMatrix = glm::mat4(1.0f);
-    glm::mat4 mLocalScaleMatrix = glm::mat4(1.0f);
-    glm::mat4 mLocalSwapAxisMatrix = glm::mat4(1.0f);
+    std::shared_ptr<AssimpModel> mAssimpModel = nullptr;
+
+    AssimpInstanceStore* mStore = nullptr;
+    InstanceHandle mHandle{};
+    size_t mInstanceListIndex = 0;
 
-    glm::mat4 mLocalTransformMatrix = glm::mat4(1.0f);
+    /* the fields kept in the store are only valid here without a store */
+    InstanceSettings mInstanceSettings{};
 
     glm::mat4 mInstanceRootMatrix = glm::mat4(1.0f);
     glm::mat4 mModelRootMatrix = glm::mat4(1.0f);
 
     std::vector<NodeTransformData> mNodeTransformData{};
+
+    /* one cursor per channel of the current clip, reset on clip change */
+    std::vector<AnimChannelCursor> mAnimChannelCursors{};
+    unsigned int mAnimCursorClipNr = 0;
+
+    /* blend stack of the single instance update, keeps its buffers between the frames */
+    AssimpAnimBlender mAnimBlender{};
+
+    unsigned int mAnimLodLevel = 0;
+    bool mAnimLodSkip = false;
+    int mAnimLodPoseClipNr = -1;
 };
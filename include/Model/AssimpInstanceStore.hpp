@@ -0,0 +1,109 @@
+/* structure-of-arrays storage of the instances of one model, the instances are addressed by generational handles */
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "Model/InstanceSettings.hpp"
+#include "OpenGL/OGLRenderData.hpp"
+
+class AssimpModel;
+class AssimpInstance;
+
+/* stays valid until the instance is removed, a reused slot gets a new generation */
+struct InstanceHandle {
+  uint32_t ihSlot = 0;
+  uint32_t ihGeneration = 0;
+};
+
+class AssimpInstanceStore {
+  public:
+    AssimpInstanceStore(std::shared_ptr<AssimpModel> model);
+    /* the remaining instances keep a copy of their data */
+    ~AssimpInstanceStore();
+
+    /* the instances point to the store */
+    AssimpInstanceStore(const AssimpInstanceStore&) = delete;
+    AssimpInstanceStore& operator=(const AssimpInstanceStore&) = delete;
+
+    std::shared_ptr<AssimpModel> getModel();
+
+    std::shared_ptr<AssimpInstance> addInstance(glm::vec3 position = glm::vec3(0.0f), glm::vec3 rotation = glm::vec3(0.0f), float scale = 1.0f);
+    /* O(1), the last instance is moved into the gap. the removed instance keeps a copy of its data */
+    bool removeInstance(InstanceHandle handle);
+    void reserve(size_t numInstances);
+
+    bool isValid(InstanceHandle handle) const;
+    /* position in the packed arrays, changes if another instance is removed */
+    size_t getIndex(InstanceHandle handle) const;
+    size_t size() const;
+    bool empty() const;
+
+    /* the packed arrays, all of them have size() entries */
+    const std::vector<std::shared_ptr<AssimpInstance>>& getInstances() const;
+    std::vector<glm::vec3>& getPositions();
+    std::vector<glm::vec3>& getRotations();
+    std::vector<float>& getScales();
+    std::vector<uint8_t>& getSwapYZAxis();
+    std::vector<unsigned int>& getAnimClipNrs();
+    std::vector<float>& getAnimPlayTimes();
+    std::vector<float>& getAnimSpeedFactors();
+    /* only the animated models keep the world matrices up to date */
+    std::vector<glm::mat4>& getWorldMatrices();
+
+    /* copies the fields kept in the store from and to the settings of the instance at 'index'.
+     * writing marks the world matrix as dirty if the transform has changed */
+    void readSettings(size_t index, InstanceSettings& settings) const;
+    void writeSettings(size_t index, const InstanceSettings& settings);
+
+    /* the world matrix of the instance is rebuilt by the next updateWorldMatrices() call */
+    void markDirty(size_t index);
+    bool isDirty(size_t index) const;
+    /* rebuilds the world matrices of the dirty instances only, the dirty list is kept for the upload */
+    void updateWorldMatrices();
+    void updateWorldMatrix(size_t index);
+    /* the static models use the compact records instead of the world matrices, the GPU builds the matrices */
+    void updateTransformRecords();
+    const std::vector<InstanceTransformRecord>& getTransformRecords() const;
+    /* sorted by updateWorldMatrices() or updateTransformRecords(), may contain indices of removed instances */
+    const std::vector<uint32_t>& getDirtyIndices() const;
+    void clearDirty();
+
+    static glm::mat4 createWorldMatrix(glm::vec3 position, glm::vec3 rotation, float scale, bool swapYZAxis, const glm::mat4& modelRootMatrix);
+    /* without the root matrix of the model, the shader adds it */
+    static InstanceTransformRecord createTransformRecord(glm::vec3 position, glm::vec3 rotation, float scale, bool swapYZAxis);
+
+  private:
+    /* dirty instances per job of the matrix rebuild */
+    static constexpr size_t mMatrixGrainSize = 1024;
+
+    void prepareDirtyIndices();
+
+    std::shared_ptr<AssimpModel> mAssimpModel = nullptr;
+    glm::mat4 mModelRootMatrix = glm::mat4(1.0f);
+
+    /* packed, one entry per instance */
+    std::vector<std::shared_ptr<AssimpInstance>> mInstances{};
+    std::vector<InstanceHandle> mHandles{};
+    std::vector<glm::vec3> mPositions{};
+    std::vector<glm::vec3> mRotations{};
+    std::vector<float> mScales{};
+    std::vector<uint8_t> mSwapYZAxis{};
+    std::vector<unsigned int> mAnimClipNrs{};
+    std::vector<float> mAnimPlayTimes{};
+    std::vector<float> mAnimSpeedFactors{};
+    std::vector<glm::mat4> mWorldMatrices{};
+    std::vector<uint8_t> mDirty{};
+    /* static models only, resized by updateTransformRecords() */
+    std::vector<InstanceTransformRecord> mTransformRecords{};
+
+    /* instances with a changed transform since the last clearDirty() call */
+    std::vector<uint32_t> mDirtyIndices{};
+
+    /* one entry per slot, the slots of removed instances are reused */
+    std::vector<uint32_t> mSlotIndices{};
+    std::vector<uint32_t> mSlotGenerations{};
+    std::vector<uint32_t> mFreeSlots{};
+};
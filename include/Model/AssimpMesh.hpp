@@ -12,6 +12,12 @@
 #include "OpenGL/Texture.hpp"
 #include "Model/AssimpBone.hpp"
 
+/* texture file of a material, decoded and uploaded by the model */
+struct PendingTexture {
+  std::string ptFileName;
+  std::shared_ptr<Texture> ptTexture = nullptr;
+};
+
 class AssimpMesh {
   public:
     bool processMesh(aiMesh* mesh, const aiScene* scene, std::string assetDirectory,
@@ -24,6 +30,7 @@ class AssimpMesh {
     OGLMesh getMesh();
     std::vector<uint32_t> getIndices();
     std::vector<std::shared_ptr<AssimpBone>> getBoneList();
+    const std::vector<PendingTexture>& getPendingTextures();
 
   private:
     std::string mMeshName;
@@ -34,4 +41,5 @@ class AssimpMesh {
 
     OGLMesh mMesh{};
     std::vector<std::shared_ptr<AssimpBone>> mBoneList{};
+    std::vector<PendingTexture> mPendingTextures{};
 };
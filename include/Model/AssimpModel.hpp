@@ -24,8 +24,10 @@ class AssimpModel {
     glm::mat4 getRootTranformationMatrix();
 
     void draw();
-    void drawInstanced(int instanceCount);
+    /* pre-skinned draws read the vertex positions and normals from the output of the pre-skinning pass */
+    void drawInstanced(int instanceCount, bool preSkinned = false);
     unsigned int getTriangleCount();
+    unsigned int getVertexCount();
 
     std::string getModelFileName();
     std::string getModelFileNamePath();
@@ -33,6 +35,12 @@ class AssimpModel {
     bool hasAnimations();
     const std::vector<std::shared_ptr<AssimpAnimClip>>& getAnimClips();
 
+    /* rebuilds the packed data of all clips, and the baked animations */
+    void setAnimCompressionSettings(const AnimCompressionSettings& settings);
+    const AnimCompressionSettings& getAnimCompressionSettings();
+    /* sum of all clips */
+    AnimCompressionStats getAnimCompressionStats();
+
     const std::vector<std::shared_ptr<AssimpNode>>& getNodeList();
     const std::unordered_map<std::string, std::shared_ptr<AssimpNode>>& getNodeMap();
 
@@ -41,9 +49,64 @@ class AssimpModel {
     void bindBoneMatrixOffsetBuffer(int bindingPoint);
     void bindBoneParentBuffer(int bindingPoint);
 
+    const std::vector<int32_t>& getBoneParentIndices();
+    const std::vector<glm::mat4>& getBoneOffsetMatrices();
+
+    /* bones sorted by their depth in the hierarchy, see AssimpBoneHierarchy */
+    unsigned int getBoneLevelCount();
+    const std::vector<int32_t>& getBoneLevelOrder();
+    const std::vector<int32_t>& getBoneLevelOffsets();
+
+    /* bounding sphere of all meshes in the bind pose, in model space */
+    glm::vec3 getBoundingSphereCenter();
+    float getBoundingSphereRadius();
+
+    /* key frames of all clips for the sampling in the compute shader. the clip table starts with the offset
+     * of a per clip block, the block contains the channel of every bone, or -1 */
+    const std::vector<int32_t>& getGpuAnimClipTable();
+    const std::vector<GpuAnimChannel>& getGpuAnimChannels();
+    /* key time and inverse time difference to the next key */
+    const std::vector<glm::vec2>& getGpuAnimKeyTimes();
+    const std::vector<glm::vec4>& getGpuAnimKeyValues();
+    /* changes every time the GPU clip data is rebuilt */
+    unsigned int getGpuAnimClipVersion();
+
+    /* pose of the first frame of the clip, one entry per bone. additive layers add the difference to this pose */
+    const NodeTransformData* getAnimReferencePose(unsigned int clipNr);
+
+    /* weight 1 for the bone and all bones below it, 0 for the others. returns the mask number, or -1 if
+     * there is no such bone. a second mask for the same bone returns the existing one */
+    int createBoneMask(std::string boneName);
+    unsigned int getBoneMaskCount();
+    const std::vector<float>& getBoneMask(int maskNr);
+    std::string getBoneMaskName(int maskNr);
+
+    /* final bone matrices of all clips, sampled at a fixed rate. baked the first time the baked animations are switched on */
+    bool hasBakedAnimations();
+    void setUseBakedAnimations(bool value);
+    bool getUseBakedAnimations();
+    float getBakeFramesPerSecond();
+    unsigned int getBakedFrameCount();
+    size_t getBakedAnimationSize();
+    float getBakeTime();
+    /* safe to call from jobs */
+    BakedAnimRecord getBakedAnimRecord(unsigned int clipNr, float playTime);
+    void bindBakedBoneMatrixBuffer(int bindingPoint);
+    void bindBakedClipBuffer(int bindingPoint);
+
+    /* skin the vertices of all instances once per frame in a compute shader, costs a skinned
+     * copy of the vertices per instance, but the passes drawing the model skip the skinning */
+    void setPreSkinning(bool value);
+    bool getPreSkinning();
+    /* the vertices of all meshes, one after another */
+    void bindSkinVertexBuffer(int bindingPoint);
+
     void cleanup();
 private:
     void processNode(std::shared_ptr<AssimpNode> node, aiNode* aNode, const aiScene* scene, std::string assetDirectory);
+    void bakeAnimations();
+    void createGpuAnimClips();
+    void createAnimReferencePoses();
     void createNodeList(std::shared_ptr<AssimpNode> node, std::shared_ptr<AssimpNode> newNode, std::vector<std::shared_ptr<AssimpNode>> &list);
 
     unsigned int mTriangleCount = 0;
@@ -59,17 +122,50 @@ private:
     std::vector<std::shared_ptr<AssimpBone>> mBoneList{};
 
     std::vector<std::shared_ptr<AssimpAnimClip>> mAnimClips{};
+    AnimCompressionSettings mAnimCompressionSettings{};
 
     std::vector<OGLMesh> mModelMeshes{};
+    glm::vec3 mBoundingSphereCenter = glm::vec3(0.0f);
+    float mBoundingSphereRadius = 0.0f;
     std::vector<VertexIndexBuffer> mVertexBuffers{};
+    /* first vertex of every mesh in the skin vertex buffer */
+    std::vector<unsigned int> mMeshVertexOffsets{};
+    ShaderStorageBuffer mSkinVertexBuffer{};
+    bool mPreSkinning = false;
 
+    std::vector<glm::mat4> mBoneOffsetMatrices{};
+    std::vector<int32_t> mBoneParentIndices{};
     ShaderStorageBuffer mShaderBoneParentBuffer{};
+    std::vector<int32_t> mBoneLevelOrder{};
+    std::vector<int32_t> mBoneLevelOffsets{};
     ShaderStorageBuffer mShaderBoneMatrixOffsetBuffer{};
 
+    std::vector<int32_t> mGpuAnimClipTable{};
+    std::vector<GpuAnimChannel> mGpuAnimChannels{};
+    std::vector<glm::vec2> mGpuAnimKeyTimes{};
+    std::vector<glm::vec4> mGpuAnimKeyValues{};
+    unsigned int mGpuAnimClipVersion = 0;
+
+    std::vector<NodeTransformData> mAnimReferencePoses{};
+    std::vector<std::vector<float>> mBoneMasks{};
+    std::vector<std::string> mBoneMaskNames{};
+
+    /* baked animations, the clip table contains the first frame and the number of frames per clip */
+    float mBakeFramesPerSecond = 30.0f;
+    std::vector<glm::uvec2> mBakedClipFrames{};
+    unsigned int mBakedFrameCount = 0;
+    size_t mBakedAnimationSize = 0;
+    float mBakeTime = 0.0f;
+    bool mUseBakedAnimations = false;
+    ShaderStorageBuffer mBakedBoneMatrixBuffer{};
+    ShaderStorageBuffer mBakedClipBuffer{};
+
     // map textures to external or internal texture names
     std::unordered_map<std::string, std::shared_ptr<Texture>> mTextures{};
     std::shared_ptr<Texture> mPlaceholderTexture = nullptr;
     std::shared_ptr<Texture> mWhiteTexture = nullptr;
+    /* texture files of the meshes, only used while loading */
+    std::vector<PendingTexture> mPendingTextures{};
 
     glm::mat4 mRootTransformMatrix = glm::mat4(1.0f);
 
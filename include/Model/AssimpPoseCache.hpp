@@ -0,0 +1,44 @@
+/* shares sampled poses between instances playing the same clip at nearly the same time */
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "Model/AssimpAnimClip.hpp"
+#include "OpenGL/OGLRenderData.hpp"
+
+struct PoseCacheStats {
+  unsigned int pcLookups = 0;
+  /* lookups served by a pose already sampled for another instance */
+  unsigned int pcHits = 0;
+};
+
+class AssimpPoseCache {
+  public:
+    /* in seconds, converted to clip ticks per clip */
+    void setQuantizationStep(float step);
+    float getQuantizationStep();
+
+    /* same output as AssimpAnimSampler::sampleClip(). the play times are rounded to the quantization step,
+     * every pose is sampled once per (clip, quantized time) and copied to all instances using it.
+     * one call handles the instances of one clip of one model, so the model and the clip are part of the key.
+     * returns the processing time summed over all threads in milliseconds */
+    float sampleClip(const std::shared_ptr<AssimpAnimClip>& clip, const float* times, size_t numInstances, size_t numBones,
+      NodeTransformData* out, bool useNlerp = false);
+
+    const PoseCacheStats& getStatistics();
+    void resetStatistics();
+
+  private:
+    float mQuantizationStep = 1.0f / 60.0f;
+    /* very small steps fall back to sampling every instance */
+    static constexpr size_t mMaxBuckets = 65536;
+
+    PoseCacheStats mStats{};
+
+    /* pose index per quantized time, -1 if not sampled yet */
+    std::vector<int> mBucketPoses{};
+    std::vector<float> mPoseTimes{};
+    std::vector<unsigned int> mInstancePoses{};
+    std::vector<NodeTransformData> mPoses{};
+};
@@ -0,0 +1,15 @@
+/* SIMD kernels for the world matrices of the instances, uses the SIMD level of AssimpAnimKernels */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+class AssimpTransformKernels {
+  public:
+    /* closed-form translation * rotation * swap axis * scale * model root, the same result as
+     * AssimpInstanceStore::createWorldMatrix(). the rotations are Euler angles in degrees.
+     * builds the matrices at the given indices, or the first 'numIndices' matrices if 'indices' is nullptr */
+    static void buildWorldMatrices(const glm::vec3* positions, const glm::vec3* rotations, const float* scales, const uint8_t* swapYZAxis,
+      const glm::mat4& modelRootMatrix, const uint32_t* indices, size_t numIndices, glm::mat4* worldMatrices);
+};
@@ -1,10 +1,30 @@
 /* model specific settings */
 #pragma once
 
+#include <array>
 #include <vector>
 #include <memory>
 #include <glm/glm.hpp>
 
+/* replace blends from the pose below towards the layer pose, additive adds the difference
+ * between the layer pose and the first frame of the layer clip */
+enum class animBlendMode : int {
+  replace = 0,
+  additive
+};
+
+/* one layer of the blend stack, played on top of the base clip */
+struct AnimBlendLayer {
+  unsigned int ablClipNr = 0;
+  float ablPlayTimePos = 0.0f;
+  float ablSpeedFactor = 1.0f;
+  /* layers with a weight of zero are not sampled */
+  float ablWeight = 0.0f;
+  animBlendMode ablMode = animBlendMode::replace;
+  /* bone mask of the model, see AssimpModel::createBoneMask(), -1 uses all bones */
+  int ablBoneMask = -1;
+};
+
 struct InstanceSettings {
   glm::vec3 isWorldPosition = glm::vec3(0.0f);
   glm::vec3 isWorldRotation = glm::vec3(0.0f);
@@ -14,4 +34,14 @@ struct InstanceSettings {
   unsigned int isAnimClipNr = 0;
   float isAnimPlayTimePos = 0.0f;
   float isAnimSpeedFactor = 1.0f;
+
+  /* crossfade from the previous clip to isAnimClipNr, the previous clip keeps playing until the fade is done */
+  int isAnimFadeClipNr = -1;
+  float isAnimFadePlayTimePos = 0.0f;
+  float isAnimFadeSpeedFactor = 1.0f;
+  float isAnimFadeTime = 0.0f;
+  float isAnimFadeDuration = 0.0f;
+
+  /* applied in order after the crossfade */
+  std::array<AnimBlendLayer, 4> isAnimLayers{};
 };
@@ -7,9 +7,12 @@
 #include <unordered_set>
 #include <functional>
 
+#include "Tools/Benchmark.hpp"
+
 // forward declaration
 class AssimpModel;
 class AssimpInstance;
+class AssimpInstanceStore;
 
 using modelCheckCallback = std::function<bool(std::string)>;
 using modelAddCallback = std::function<bool(std::string)>;
@@ -20,17 +23,24 @@ using instanceAddManyCallback = std::function<void(std::shared_ptr<AssimpModel>,
 using instanceDeleteCallback = std::function<void(std::shared_ptr<AssimpInstance>)>;
 using instanceCloneCallback = std::function<void(std::shared_ptr<AssimpInstance>)>;
 
+using benchmarkRunCallback = std::function<void(benchmarkType, std::shared_ptr<AssimpModel>)>;
+
 struct ModelAndInstanceData {
   std::vector<std::shared_ptr<AssimpModel>> miModelList{};
   int miSelectedModel = 0;
 
+  /* all instances, for the selection in the UI. the order changes if an instance is deleted */
   std::vector<std::shared_ptr<AssimpInstance>> miAssimpInstances{};
-  std::unordered_map<std::string, std::vector<std::shared_ptr<AssimpInstance>>> miAssimpInstancesPerModel{};
+  /* the instances of every model, in packed arrays */
+  std::unordered_map<std::string, std::shared_ptr<AssimpInstanceStore>> miInstanceStores{};
   int miSelectedInstance = 0;
 
   /* delete models that were loaded during application runtime */
   std::unordered_set<std::shared_ptr<AssimpModel>> miPendingDeleteAssimpModels{};
 
+  /* results of the benchmarks started from the UI, newest last */
+  std::vector<BenchmarkResult> miBenchmarkResults{};
+
   /* callbacks */
   modelCheckCallback miModelCheckCallbackFunction;
   modelAddCallback miModelAddCallbackFunction;
@@ -40,4 +50,6 @@ struct ModelAndInstanceData {
   instanceAddManyCallback miInstanceAddManyCallbackFunction;
   instanceDeleteCallback miInstanceDeleteCallbackFunction;
   instanceCloneCallback miInstanceCloneCallbackFunction;
+
+  benchmarkRunCallback miBenchmarkRunCallbackFunction;
 };
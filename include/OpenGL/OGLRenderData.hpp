@@ -29,6 +29,82 @@ struct NodeTransformData {
   glm::vec4 rotation = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f); // this is a quaternion
 };
 
+/* layout of the final bone matrices written by the compute shaders and read by the skinning shader */
+enum class bonePaletteFormat : int {
+  mat4 = 0,
+  affine3x4,
+  dualQuaternion
+};
+
+/* per instance data of the baked animation mode, blends between 'frame' and the next frame of the clip */
+struct BakedAnimRecord {
+  uint32_t barClip = 0;
+  uint32_t barFrame = 0;
+  float barBlend = 0.0f;
+  uint32_t barPadding = 0;
+};
+
+/* per model data of the batched bone matrix compute pass, the offsets point into the buffers of all animated models.
+ * models sampled on the GPU have no node data, the clip table offset is used instead */
+struct AnimBatchRecord {
+  int32_t abrFirstWorkGroup = 0;
+  int32_t abrNumberOfBones = 0;
+  int32_t abrNumberOfLevels = 0;
+  int32_t abrBoneDataOffset = 0;
+  int32_t abrNodeDataOffset = -1;
+  int32_t abrBoneTableOffset = 0;
+  int32_t abrLevelOrderOffset = 0;
+  int32_t abrLevelOffsetOffset = 0;
+  int32_t abrClipTableOffset = 0;
+  int32_t abrPadding = 0;
+};
+
+/* key ranges of one channel of a clip sampled on the GPU, see PackedAnimClip.
+ * the constant tracks are a bit mask, 1 translation, 2 rotation, 4 scale */
+struct GpuAnimChannel {
+  int32_t gchPreState = 0;
+  int32_t gchPostState = 0;
+  int32_t gchConstantTracks = 0;
+  int32_t gchTranslationKey = 0;
+  int32_t gchTranslationCount = 0;
+  int32_t gchRotationKey = 0;
+  int32_t gchRotationCount = 0;
+  int32_t gchScaleKey = 0;
+  int32_t gchScaleCount = 0;
+};
+
+/* per instance data of the GPU sampling */
+struct AnimInstanceRecord {
+  int32_t airClip = 0;
+  float airTime = 0.0f;
+};
+
+/* transform of a static instance, the vertex shader builds the world matrix. the swap of the
+ * Y and Z axes is a rotation, too, and is part of the quaternion */
+struct InstanceTransformRecord {
+  glm::vec4 itrPositionScale = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+  glm::vec4 itrRotation = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f); // quaternion x, y, z, w
+};
+
+/* per model draw of the animated models, after the batched compute pass */
+struct AnimBatchDraw {
+  size_t abdNumberOfInstances = 0;
+  size_t abdFirstInstance = 0;
+  size_t abdBoneDataOffset = 0;
+  size_t abdNumberOfBones = 0;
+  size_t abdNodeDataOffset = 0;
+  bool abdFused = false;
+  /* first vertex in the pre-skinned vertex buffer, if the model is skinned in the compute shader */
+  size_t abdSkinnedVertexOffset = 0;
+  bool abdPreSkinned = false;
+};
+
+/* output of the pre-skinning compute pass, in world space. the color is still read from the model's vertex buffer */
+struct PreSkinnedVertex {
+  glm::vec4 position = glm::vec4(0.0f); // last float is uv.x
+  glm::vec4 normal = glm::vec4(0.0f); // last float is uv.y
+};
+
 
 struct OGLMesh {
   std::vector<OGLVertex> vertices{};
@@ -46,6 +122,7 @@ struct OGLRenderData {
 
   unsigned int rdTriangleCount = 0;
   unsigned int rdMatricesSize = 0;
+  size_t rdPreSkinnedSize = 0;
 
   std::vector<Light> Lights;
   int rdLightIndex=0;
@@ -53,13 +130,68 @@ struct OGLRenderData {
 
   int rdFieldOfView = 60;
 
+  /* replace the rotation SLERP by the faster NLERP */
+  bool rdAnimUseNlerp = false;
+  /* share sampled poses between instances, play times are rounded to the step (in seconds) */
+  bool rdPoseCacheEnabled = false;
+  float rdPoseCacheStep = 1.0f / 60.0f;
+  unsigned int rdPoseCacheLookups = 0;
+  unsigned int rdPoseCacheHits = 0;
+
+  /* instances with a crossfade or active blend layers, and the number of sampled layers. the layers
+   * are not used by the GPU sampling and the baked animations */
+  unsigned int rdAnimBlendedInstances = 0;
+  unsigned int rdAnimBlendLayers = 0;
+
+  /* animation LOD: instances closer than the near distance are sampled every frame, up to the far
+   * distance every rdAnimLodMidInterval frames, and beyond every rdAnimLodFarInterval frames */
+  bool rdAnimLodEnabled = false;
+  float rdAnimLodNearDistance = 25.0f;
+  float rdAnimLodFarDistance = 75.0f;
+  int rdAnimLodMidInterval = 3;
+  int rdAnimLodFarInterval = 15;
+  /* instances per band, and the instances sampled in the last frame */
+  unsigned int rdAnimLodNearInstances = 0;
+  unsigned int rdAnimLodMidInstances = 0;
+  unsigned int rdAnimLodFarInstances = 0;
+  unsigned int rdAnimLodSampledInstances = 0;
+
+  /* build the TRS matrices and resolve the bone hierarchy level by level in one compute pass,
+   * instead of a TRS pass and a pass walking the parent chain of every bone */
+  bool rdFusedBoneMatrices = true;
+  /* sample the key frames in the fused compute pass, only the clip and the play time are uploaded per instance.
+   * the animation LOD and the pose cache are not used for these models */
+  bool rdGpuAnimSampling = false;
+  /* the affine 3x4 palette needs 48 bytes per bone, the dual quaternion palette 32 bytes, but drops the bone scale */
+  bonePaletteFormat rdBonePaletteFormat = bonePaletteFormat::mat4;
+
+  /* animated instances outside of the view frustum are neither sampled nor drawn. the bind pose
+   * bounding sphere is enlarged by the margin, animated limbs may leave the bind pose bounds */
+  bool rdFrustumCullingEnabled = true;
+  float rdFrustumCullingMargin = 1.5f;
+  unsigned int rdCulledInstances = 0;
+
+  /* instances with a rebuilt world matrix in this frame */
+  unsigned int rdDirtyInstances = 0;
+
+  /* threads of the job system, including the render thread */
+  int rdJobThreadCount = 1;
+  int rdJobMaxThreadCount = 1;
+
   float rdFrameTime = 0.0f;
   float rdMatrixGenerateTime = 0.0f;
+  float rdAnimUpdateTime = 0.0f;
+  /* summed over all animation threads, compared to rdAnimUpdateTime shows the scaling */
+  float rdAnimUpdateWorkTime = 0.0f;
   float rdUploadToVBOTime = 0.0f;
   float rdUploadToUBOTime = 0.0f;
   float rdUIGenerateTime = 0.0f;
   float rdUIDrawTime = 0.0f;
 
+  /* heap allocations of the last frame, and of the animation update only */
+  unsigned int rdFrameAllocations = 0;
+  unsigned int rdAnimAllocations = 0;
+
   int rdMoveForward = 0;
   int rdMoveRight = 0;
   int rdMoveUp = 0;
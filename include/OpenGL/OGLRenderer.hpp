@@ -2,6 +2,7 @@
 #pragma once
 
 #include <vector>
+#include <array>
 #include <string>
 #include <memory>
 #include <map>
@@ -15,15 +16,20 @@
 #include "OGLRenderData.hpp"
 
 #include "Tools/Timer.hpp"
+#include "Tools/Benchmark.hpp"
+#include "Tools/JobSystem.hpp"
 #include "Framebuffer.hpp"
 #include "Texture.hpp"
 #include "LoadShaders.hpp"
 #include "UniformBuffer.hpp"
 #include "ShaderStorageBuffer.hpp"
+#include "ShaderStorageRingBuffer.hpp"
 #include "Interface/UserInterface.hpp"
 #include "Tools/Camera.hpp"
 #include "Model/AssimpModel.hpp"
 #include "Model/AssimpInstance.hpp"
+#include "Model/AssimpPoseCache.hpp"
+#include "Model/AssimpAnimBlender.hpp"
 #include "Model/ModelAndInstanceData.hpp"
 #include "light.hpp"
 class OGLRenderer {
@@ -50,11 +56,19 @@ class OGLRenderer {
     void deleteInstance(std::shared_ptr<AssimpInstance> instance);
     void cloneInstance(std::shared_ptr<AssimpInstance> instance);
 
+    void runBenchmark(benchmarkType type, std::shared_ptr<AssimpModel> model);
+
     void cleanup();
 
   private:
     OGLRenderData mRenderData{};
     ModelAndInstanceData mModelInstData{};
+
+    /* creates the store on the first instance of the model */
+    std::shared_ptr<AssimpInstanceStore> getInstanceStore(std::shared_ptr<AssimpModel> model);
+    void appendInstance(std::shared_ptr<AssimpInstance> instance);
+    /* uploads the changed transform records of a static model, 'regionOffset' is the first record of the model in mWorldPosBuffer */
+    void uploadWorldPosRanges(AssimpInstanceStore &store, size_t regionOffset);
     
 
   
@@ -67,8 +81,12 @@ class OGLRenderer {
 
     Shader mAssimpShader;
     Shader mAssimpSkinningShader;
+    Shader mAssimpBakedSkinningShader;
     Shader mAssimpTransformComputeShader;
     Shader mAssimpMatrixComputeShader;
+    Shader mAssimpTransformLevelsComputeShader;
+    Shader mAssimpPreSkinningComputeShader;
+    Shader mAssimpPreSkinnedShader;
 
     
     Framebuffer mFramebuffer{};
@@ -76,26 +94,108 @@ class OGLRenderer {
     UserInterface mUserInterface;
     Camera mCamera{};
 
-    /* for non-animated models */
-    std::vector<glm::mat4> mWorldPosMatrices{};
+    /* the data written in every frame, the producers write straight into the mapped memory */
+    ShaderStorageRingBuffer mFrameDataBuffer{};
+    static constexpr size_t mFrameDataStartSize = 1024 * 1024;
+
+    /* InstanceTransformRecord entries of the non-animated models, only the changed records are uploaded */
     ShaderStorageBuffer mWorldPosBuffer{};
+    /* one region per static model in mWorldPosBuffer, in drawing order. sizes and offsets count records */
+    std::vector<const AssimpInstanceStore*> mWorldPosRegionStores{};
+    std::vector<size_t> mWorldPosRegionSizes{};
+    std::vector<size_t> mWorldPosRegionOffsets{};
+    /* dirty records closer than this are uploaded in one call */
+    static constexpr size_t mWorldPosMergeGap = 16;
 
     /* for animated models */
     std::vector<glm::mat4> mModelBoneMatrices{};
     ShaderStorageBuffer mShaderBoneMatrixBuffer{};
     ShaderStorageBuffer mShaderTRSMatrixBuffer{};
-    ShaderStorageBuffer mNodeTransformBuffer{};
-    ShaderStorageBuffer mShaderModelRootMatrixBuffer{};
 
-    /* for computer shader */
+    /* for computer shader, the sampled poses of all animated models. the poses are read again by the blending
+     * and the animation LOD, they are copied to the mapped memory at once, reading mapped memory is slow */
     std::vector<NodeTransformData> mNodeTransFormData{};
 
+    /* all animated models are computed in one pass and drawn afterwards */
+    SsboRingRange mAnimWorldPosRange{};
+    std::vector<std::shared_ptr<AssimpModel>> mAnimBatchModels{};
+    std::vector<AnimBatchDraw> mAnimBatchDraws{};
+    std::vector<AnimBatchRecord> mAnimBatchRecords{};
+    size_t mAnimBatchWorkGroups = 0;
+
+    /* concatenated bone tables of the models in the batch, rebuilt when the models change */
+    std::vector<std::shared_ptr<AssimpModel>> mAnimBatchTableModels{};
+    std::vector<std::shared_ptr<AssimpModel>> mAnimBatchFrameTableModels{};
+    std::vector<unsigned int> mAnimBatchTableVersions{};
+    std::vector<unsigned int> mAnimBatchFrameTableVersions{};
+    std::vector<int32_t> mAnimBatchParentIndices{};
+    std::vector<glm::mat4> mAnimBatchBoneOffsets{};
+    std::vector<int32_t> mAnimBatchLevelOrder{};
+    std::vector<int32_t> mAnimBatchLevelOffsets{};
+    ShaderStorageBuffer mAnimBatchParentBuffer{};
+    ShaderStorageBuffer mAnimBatchBoneOffsetBuffer{};
+    ShaderStorageBuffer mAnimBatchLevelOrderBuffer{};
+    ShaderStorageBuffer mAnimBatchLevelOffsetBuffer{};
+
+    /* clips of the models in the batch, for the sampling on the GPU */
+    std::vector<int32_t> mAnimBatchClipTable{};
+    std::vector<GpuAnimChannel> mAnimBatchChannels{};
+    std::vector<glm::vec2> mAnimBatchKeyTimes{};
+    std::vector<glm::vec4> mAnimBatchKeyValues{};
+    ShaderStorageBuffer mAnimBatchClipTableBuffer{};
+    ShaderStorageBuffer mAnimBatchChannelBuffer{};
+    ShaderStorageBuffer mAnimBatchKeyTimeBuffer{};
+    ShaderStorageBuffer mAnimBatchKeyValueBuffer{};
+    /* per work group of the fused pass, only set for the instances sampled on the GPU */
+    SsboRingRange mAnimInstanceRecordRange{};
+
+    /* world space vertices of all instances of the models using pre-skinning, rewritten every frame */
+    ShaderStorageBuffer mPreSkinnedVertexBuffer{};
+
+    /* instances of a model sorted by clip, to sample every clip in one batch.
+     * every clip has two groups, the sampled instances and the instances skipped by the animation LOD */
+    std::vector<unsigned int> mAnimClipOffsets{};
+    std::vector<unsigned int> mAnimClipFillPositions{};
+    /* position of the instance in the packed arrays of the store */
+    std::vector<unsigned int> mAnimSlotIndices{};
+    std::vector<float> mAnimPlayTimes{};
+    std::vector<AnimChannelCursor*> mAnimChannelCursors{};
+
+    /* instances per job of the animation update and the matrix generation */
+    static constexpr size_t mAnimUpdateGrainSize = 256;
+    static constexpr size_t mAnimSampleGrainSize = 32;
+    static constexpr size_t mMatrixGrainSize = 1024;
+    /* size of the shared memory matrix array in assimp_instance_transform_levels.comp */
+    static constexpr size_t mMaxLevelOrderBones = 256;
+    /* minimum of GL_MAX_COMPUTE_WORK_GROUP_COUNT guaranteed by OpenGL, the same for X, Y and Z */
+    static constexpr size_t mMaxComputeWorkGroups = 65535;
+    Timer mAnimUpdateTimer{};
+
+    /* staggers the updates of the skipped LOD bands over the frames */
+    unsigned int mAnimLodFrame = 0;
+    /* the stored poses are only valid if they were written in the last frame */
+    bool mAnimLodPosesValid = false;
+
+    /* planes of the view frustum as (normal, distance), the normals point inside */
+    std::array<glm::vec4, 6> mFrustumPlanes{};
+    std::vector<unsigned char> mAnimInstanceCulled{};
+    AssimpPoseCache mPoseCache{};
+    /* crossfades and layers, 1 for the slots of the instances with an active blend stack */
+    AssimpAnimBlender mAnimBlender{};
+    std::vector<unsigned char> mAnimSlotBlending{};
+
+    uint64_t mFrameStartAllocations = 0;
+
     bool mMouseLock = false;
     int mMouseXPos = 0;
     int mMouseYPos = 0;
 
     void handleMovementKeys();
     void updateTriangleCount();
+    void updateFrustumPlanes();
+    bool isSphereInFrustum(glm::vec3 center, float radius);
+    /* number of vec4 per bone in the bone matrix buffer */
+    static size_t getBonePaletteVectors(bonePaletteFormat format);
 
     /* create identity matrix by default */
     glm::mat4 mViewMatrix = glm::mat4(1.0f);
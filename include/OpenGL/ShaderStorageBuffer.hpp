@@ -15,17 +15,13 @@ class ShaderStorageBuffer {
 
     /* upload and bind */
     template <typename T>
-    void uploadSsboData(std::vector<T> bufferData, int bindingPoint) {
+    void uploadSsboData(const std::vector<T>& bufferData, int bindingPoint) {
       if (bufferData.empty()) {
         return;
       }
 
       size_t bufferSize = bufferData.size() * sizeof(T);
-      if (bufferSize > mBufferSize) {
-        Logger::log(1, "%s: resizing SSBO %i from %i to %i bytes\n", __FUNCTION__, mShaderStorageBuffer, mBufferSize, bufferSize);
-        cleanup();
-        init(bufferSize);
-      }
+      checkForResize(bufferSize);
 
       glBindBuffer(GL_SHADER_STORAGE_BUFFER, mShaderStorageBuffer);
       glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bufferSize, bufferData.data());
@@ -36,26 +32,39 @@ class ShaderStorageBuffer {
 
     /* just upload, use bind() call to use */
     template <typename T>
-    void uploadSsboData(std::vector<T> bufferData) {
+    void uploadSsboData(const std::vector<T>& bufferData) {
       if (bufferData.empty()) {
         return;
       }
 
       size_t bufferSize = bufferData.size() * sizeof(T);
-      if (bufferSize > mBufferSize) {
-        Logger::log(1, "%s: resizing SSBO %i from %i to %i bytes\n", __FUNCTION__, mShaderStorageBuffer, mBufferSize, bufferSize);
-        cleanup();
-        init(bufferSize);
-      }
+      checkForResize(bufferSize);
 
       glBindBuffer(GL_SHADER_STORAGE_BUFFER, mShaderStorageBuffer);
       glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bufferSize, bufferData.data());
       glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
     }
 
+    /* uploads 'numElements' entries to the entries starting at 'elementOffset', the buffer is not resized */
+    template <typename T>
+    void uploadSsboRange(const T* bufferData, size_t numElements, size_t elementOffset) {
+      size_t bufferOffset = elementOffset * sizeof(T);
+      size_t bufferSize = numElements * sizeof(T);
+      if (bufferOffset + bufferSize > mBufferSize) {
+        Logger::log(1, "%s error: range %i to %i is outside of SSBO %i (%i bytes)\n", __FUNCTION__, bufferOffset, bufferOffset + bufferSize,
+          mShaderStorageBuffer, mBufferSize);
+        return;
+      }
+
+      glBindBuffer(GL_SHADER_STORAGE_BUFFER, mShaderStorageBuffer);
+      glBufferSubData(GL_SHADER_STORAGE_BUFFER, bufferOffset, bufferSize, bufferData);
+      glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
     void bind(int bindingPoint);
 
-    void checkForResize(size_t newBufferSize);
+    /* grows to at least twice the old size. returns true if the buffer was recreated, the old content is lost */
+    bool checkForResize(size_t newBufferSize);
     void cleanup();
 
   private:
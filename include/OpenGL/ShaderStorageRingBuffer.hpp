@@ -0,0 +1,59 @@
+/* persistently mapped OpenGL shader storage buffer for the data written in every frame.
+ * the buffer has one part per frame in flight, a fence keeps the CPU from overwriting a part the GPU still reads */
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <glad/glad.h>
+
+/* part of the ring, only valid until the end of the frame it was allocated in */
+struct SsboRingRange {
+  void* srrData = nullptr;
+  GLuint srrBuffer = 0;
+  size_t srrOffset = 0;
+  size_t srrSize = 0;
+};
+
+class ShaderStorageRingBuffer {
+  public:
+    /* 'frameSize' is the start size of every part */
+    bool init(size_t frameSize);
+    void cleanup();
+
+    /* waits until the GPU has finished the frame that used the same part of the ring */
+    void beginFrame();
+    /* call after the last command that reads the data of the frame */
+    void endFrame();
+
+    /* the range is aligned for glBindBufferRange(). the ring grows if the part of the frame is full,
+     * the ranges allocated before stay valid */
+    SsboRingRange allocate(size_t size);
+    template <typename T>
+    T* allocate(size_t numElements, SsboRingRange& range) {
+      range = allocate(numElements * sizeof(T));
+      return static_cast<T*>(range.srrData);
+    }
+
+    void bind(const SsboRingRange& range, int bindingPoint);
+
+    size_t getFrameSize();
+
+  private:
+    static constexpr size_t mFramesInFlight = 3;
+
+    bool createBuffer(size_t frameSize);
+
+    GLuint mBuffer = 0;
+    uint8_t* mMappedData = nullptr;
+    size_t mFrameSize = 0;
+    size_t mOffsetAlignment = 256;
+
+    size_t mFrame = 0;
+    size_t mFrameOffset = 0;
+    std::array<GLsync, mFramesInFlight> mFences{};
+
+    /* replaced buffers, deleted once the frame that replaced them is done */
+    std::array<std::vector<GLuint>, mFramesInFlight> mRetiredBuffers{};
+};
@@ -10,6 +10,11 @@ class Texture {
     bool loadTexture(std::string textureFilename, bool flipImage = true);
     bool loadTexture(std::string textureName, aiTexel* textureData, int width, int height, bool flipImage = true);
 
+    /* decoding runs on the CPU only and may be done by a job, the upload needs the OpenGL context */
+    bool decodeTexture(std::string textureFilename, bool flipImage = true);
+    bool decodeTexture(std::string textureName, aiTexel* textureData, int width, int height, bool flipImage = true);
+    bool uploadTexture();
+
     void bind();
     void unbind();
 
@@ -21,4 +26,7 @@ class Texture {
     int mTexHeight = 0;
     int mNumberOfChannels = 0;
     std::string mTextureName;
+
+    /* decoded RGBA data, freed after the upload */
+    unsigned char* mTextureData = nullptr;
 };
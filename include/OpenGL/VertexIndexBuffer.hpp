@@ -19,10 +19,13 @@ public:
   void draw(GLuint mode, unsigned int start, unsigned int num);
   void drawIndirect(GLuint mode, unsigned int num);
   void drawIndirectInstanced(GLuint mode, unsigned int num, int instanceCount);
+  /* the base instance is only visible as gl_BaseInstance in the shader, there are no per instance attributes */
+  void drawIndirectInstancedBaseInstance(GLuint mode, unsigned int num, int instanceCount, unsigned int baseInstance);
 
   void bindAndDraw(GLuint mode, unsigned int start, unsigned int num);
   void bindAndDrawIndirect(GLuint mode, unsigned int num);
   void bindAndDrawIndirectInstanced(GLuint mode, unsigned int num, int instanceCount);
+  void bindAndDrawIndirectInstancedBaseInstance(GLuint mode, unsigned int num, int instanceCount, unsigned int baseInstance);
 
   void cleanup();
 
@@ -0,0 +1,10 @@
+/* counts the calls to the global operator new, to find allocations in the hot paths */
+#pragma once
+
+#include <cstdint>
+
+class AllocationCounter {
+  public:
+    /* allocations of all threads since program start */
+    static uint64_t getAllocations();
+};
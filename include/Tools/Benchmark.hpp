@@ -0,0 +1,52 @@
+/* CPU micro benchmarks, started from the user interface */
+#pragma once
+
+#include <string>
+#include <memory>
+
+// forward declaration
+class AssimpModel;
+
+enum class benchmarkType {
+  animSampling = 0,
+  animBatchSampling,
+  animSimdInterpolation,
+  jobSystemStress,
+  animPoseCache,
+  animKeyCompression,
+  boneHierarchy,
+  worldMatrixBuild
+};
+
+struct BenchmarkResult {
+  std::string brName;
+  std::string brBaselineName;
+  float brBaselineTime = 0.0f;
+  std::string brOptimizedName;
+  float brOptimizedTime = 0.0f;
+  /* free text, i.e. a correctness check or throughput numbers */
+  std::string brDetails;
+};
+
+class Benchmark {
+  public:
+    /* sample all clips of the model for many instances, binary search vs. playback cursor */
+    static BenchmarkResult animSampling(std::shared_ptr<AssimpModel> model, unsigned int numInstances, unsigned int numFrames);
+    /* per-channel sampling vs. the batched sampler on the packed clip data */
+    static BenchmarkResult animBatchSampling(std::shared_ptr<AssimpModel> model, unsigned int numInstances, unsigned int numFrames);
+    /* batched sampler with scalar kernels vs. the best SIMD kernels, plus the NLERP fast path */
+    static BenchmarkResult animSimdInterpolation(std::shared_ptr<AssimpModel> model, unsigned int numInstances, unsigned int numFrames);
+    /* batched sampler vs. the pose cache for a crowd, both on one thread */
+    static BenchmarkResult animPoseCache(std::shared_ptr<AssimpModel> model, unsigned int numInstances, unsigned int numFrames, float quantizationStep);
+    /* uncompressed clips vs. the clips with the current key compression settings of the model.
+     * reports the memory, the decode cost and the error of the sampled poses */
+    static BenchmarkResult animKeyCompression(std::shared_ptr<AssimpModel> model, unsigned int numInstances, unsigned int numFrames);
+    /* global bone matrices of a synthetic rig with chains of 'chainLength' bones below the root,
+     * parent chain walk vs. the level-ordered hierarchy, on the CPU */
+    static BenchmarkResult boneHierarchy(unsigned int numInstances, unsigned int numBones, unsigned int chainLength, unsigned int numFrames);
+    /* world matrices of 'numInstances' instances, the glm matrix products per instance vs. the closed-form SIMD
+     * batch builder on the job system. reports the single thread time of the batch builder, too */
+    static BenchmarkResult worldMatrixBuild(unsigned int numInstances, unsigned int numFrames);
+    /* many small tasks, single thread vs. the job system. reports the task throughput and the steal rates */
+    static BenchmarkResult jobSystemStress(unsigned int numTasks);
+};
@@ -0,0 +1,117 @@
+/* work-stealing job system, shared by the whole engine */
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+struct JobCounter;
+
+using JobRangeFunction = void(*)(const void*, size_t, size_t);
+
+struct Job {
+  std::function<void()> jbFunction{};
+
+  /* range jobs split themselves in halves until the range is not larger than the grain size */
+  JobRangeFunction jbRangeFunction = nullptr;
+  const void* jbContext = nullptr;
+  size_t jbBegin = 0;
+  size_t jbEnd = 0;
+  size_t jbGrainSize = 1;
+
+  JobCounter* jbCounter = nullptr;
+};
+
+/* counts the unfinished jobs of a group, must outlive all of its jobs */
+struct JobCounter {
+  std::atomic<int> jcPending{0};
+  /* processing time of range jobs, summed over all threads */
+  std::atomic<uint64_t> jcWorkTimeMicroSeconds{0};
+
+  /* jobs started once the counter reaches zero */
+  std::mutex jcMutex;
+  std::vector<Job> jcContinuations{};
+};
+
+struct JobSystemStats {
+  uint64_t jsJobsExecuted = 0;
+  /* a steal attempt locks a non-empty queue of another thread, it may still fail */
+  uint64_t jsStealAttempts = 0;
+  uint64_t jsSteals = 0;
+  /* the queue of the submitting thread was full */
+  uint64_t jsJobsRunInline = 0;
+};
+
+class JobSystem {
+  public:
+    /* number of threads including the calling thread, 0 uses all hardware threads */
+    static void init(unsigned int numThreads = 0);
+    /* all counters must have been waited for */
+    static void cleanup();
+
+    static unsigned int getThreadCount();
+    static unsigned int getHardwareThreadCount();
+    /* workers above the active count sleep, the calling thread always helps */
+    static void setActiveThreadCount(unsigned int numThreads);
+    static unsigned int getActiveThreadCount();
+
+    /* run the job on any thread, the counter is decremented once the job is done */
+    static void submit(std::function<void()> job, JobCounter* counter = nullptr);
+    /* run the job after all jobs of 'dependency' are done */
+    static void submitAfter(JobCounter& dependency, std::function<void()> job, JobCounter* counter = nullptr);
+    /* executes other jobs until the counter reaches zero */
+    static void wait(JobCounter& counter);
+
+    /* calls func(begin, end) for chunks of at most 'grainSize' elements and waits for all chunks.
+     * returns the processing time summed over all threads in milliseconds */
+    template <typename Func>
+    static float parallelFor(size_t count, size_t grainSize, const Func& func) {
+      return runRange(count, grainSize, [](const void* context, size_t begin, size_t end) {
+          (*static_cast<const Func*>(context))(begin, end);
+        }, &func);
+    }
+
+    static JobSystemStats getStatistics();
+    static void resetStatistics();
+
+  private:
+    struct WorkerQueue {
+      static constexpr size_t capacity = 1024;
+
+      /* ring buffer, the owner works on the bottom, thieves take from the top */
+      std::mutex wqMutex;
+      std::vector<Job> wqJobs = std::vector<Job>(capacity);
+      size_t wqTop = 0;
+      size_t wqBottom = 0;
+      std::atomic<size_t> wqSize{0};
+
+      std::atomic<uint64_t> wqJobsExecuted{0};
+      std::atomic<uint64_t> wqStealAttempts{0};
+      std::atomic<uint64_t> wqSteals{0};
+      std::atomic<uint64_t> wqJobsRunInline{0};
+    };
+
+    static float runRange(size_t count, size_t grainSize, JobRangeFunction func, const void* context);
+
+    static void push(Job& job);
+    static bool findJob(unsigned int queueIndex, Job& job);
+    static void execute(unsigned int queueIndex, Job& job);
+    static void finishJob(JobCounter* counter);
+    static void workerLoop(unsigned int queueIndex);
+    static unsigned int getQueueIndex();
+
+    static std::vector<std::unique_ptr<WorkerQueue>> mQueues;
+    static std::vector<std::thread> mWorkers;
+    static std::atomic<unsigned int> mActiveThreads;
+    static std::atomic<int> mQueuedJobs;
+
+    static std::mutex mSleepMutex;
+    static std::condition_variable mWakeCondition;
+    static std::atomic<int> mSleepingWorkers;
+    static std::atomic<bool> mShutdown;
+};
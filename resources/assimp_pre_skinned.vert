@@ -0,0 +1,36 @@
+#version 460 core
+layout (location = 1) in vec4 aColor;
+
+layout (location = 0) out vec4 color;
+layout (location = 1) out vec4 normal;
+layout (location = 2) out vec2 texCoord;
+
+layout (std140, binding = 0) uniform Matrices {
+  mat4 view;
+  mat4 projection;
+};
+
+/* same layout as PreSkinnedVertex */
+struct SkinnedVertex {
+  vec4 position; // last float is uv.x
+  vec4 normal; // last float is uv.y
+};
+
+/* world space vertices from the pre-skinning compute shader */
+layout (std430, binding = 1) readonly restrict buffer SkinnedVertices {
+  SkinnedVertex skinnedVertices[];
+};
+
+uniform int aNumberOfVertices;
+uniform int aSkinnedVertexOffset;
+
+void main() {
+  /* the base instance is the first vertex of the mesh, see AssimpModel::drawInstanced() */
+  int index = aSkinnedVertexOffset + gl_InstanceID * aNumberOfVertices + gl_BaseInstance + gl_VertexID;
+  SkinnedVertex vertex = skinnedVertices[index];
+
+  gl_Position = projection * view * vec4(vertex.position.xyz, 1.0);
+  color = aColor;
+  normal = vec4(vertex.normal.xyz, 1.0);
+  texCoord = vec2(vertex.position.w, vertex.normal.w);
+}
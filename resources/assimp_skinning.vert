@@ -14,8 +14,9 @@ layout (std140, binding = 0) uniform Matrices {
   mat4 projection;
 };
 
+/* final bone matrices, in the format of the bone palette */
 layout (std430, binding = 1) readonly restrict buffer BoneMatrices {
-  mat4 boneMat[];
+  vec4 bonePalette[];
 };
 
 layout (std430, binding = 2) readonly restrict buffer WorldPosMatrices {
@@ -23,20 +24,95 @@ layout (std430, binding = 2) readonly restrict buffer WorldPosMatrices {
 };
 
 uniform int aModelStride;
+/* first bone matrix and world matrix of the model, all animated models share the buffers */
+uniform int aBoneMatrixOffset;
+uniform int aWorldPosOffset;
+
+/* bone palette format, see bonePaletteFormat */
+uniform int aBonePalette;
+
+const int PALETTE_MAT4 = 0;
+const int PALETTE_AFFINE_3X4 = 1;
+const int PALETTE_DUAL_QUAT = 2;
+
+vec4 multiplyQuat(vec4 a, vec4 b) {
+  return vec4(a.w * b.xyz + b.w * a.xyz + cross(a.xyz, b.xyz), a.w * b.w - dot(a.xyz, b.xyz));
+}
+
+mat4 getSkinMatrix(int modelStride) {
+  switch (aBonePalette) {
+    case PALETTE_AFFINE_3X4: {
+      /* blend the rows, and add the constant last row */
+      vec4 rows[3] = vec4[3](vec4(0.0), vec4(0.0), vec4(0.0));
+      for (int i = 0; i < 4; ++i) {
+        uint bone = (aBoneNum[i] + modelStride) * 3;
+        rows[0] += aBoneWeight[i] * bonePalette[bone];
+        rows[1] += aBoneWeight[i] * bonePalette[bone + 1];
+        rows[2] += aBoneWeight[i] * bonePalette[bone + 2];
+      }
+      return transpose(mat4(rows[0], rows[1], rows[2], vec4(0.0, 0.0, 0.0, 1.0)));
+    }
+    case PALETTE_DUAL_QUAT: {
+      /* blend the dual quaternions in the hemisphere of the first bone */
+      uint firstBone = (aBoneNum.x + modelStride) * 2;
+      vec4 firstReal = bonePalette[firstBone];
+      vec4 real = vec4(0.0);
+      vec4 dual = vec4(0.0);
+      for (int i = 0; i < 4; ++i) {
+        uint bone = (aBoneNum[i] + modelStride) * 2;
+        vec4 boneReal = bonePalette[bone];
+        float weight = dot(firstReal, boneReal) < 0.0 ? -aBoneWeight[i] : aBoneWeight[i];
+        real += weight * boneReal;
+        dual += weight * bonePalette[bone + 1];
+      }
+      float realLength = length(real);
+      real /= realLength;
+      dual /= realLength;
+
+      /* rotation matrix from the real part (mat3_cast from GLM), translation from the dual part */
+      vec3 translation = 2.0 * multiplyQuat(dual, vec4(-real.xyz, real.w)).xyz;
+      float qxx = real.x * real.x;
+      float qyy = real.y * real.y;
+      float qzz = real.z * real.z;
+      float qxz = real.x * real.z;
+      float qxy = real.x * real.y;
+      float qyz = real.y * real.z;
+      float qwx = real.w * real.x;
+      float qwy = real.w * real.y;
+      float qwz = real.w * real.z;
+      return mat4(
+        1.0 - 2.0 * (qyy + qzz),       2.0 * (qxy + qwz),       2.0 * (qxz - qwy), 0.0,
+              2.0 * (qxy - qwz), 1.0 - 2.0 * (qxx + qzz),       2.0 * (qyz + qwx), 0.0,
+              2.0 * (qxz + qwy),       2.0 * (qyz - qwx), 1.0 - 2.0 * (qxx + qyy), 0.0,
+        translation.x,           translation.y,           translation.z,           1.0);
+    }
+    default: {
+      mat4 skinMat = mat4(0.0);
+      for (int i = 0; i < 4; ++i) {
+        uint bone = (aBoneNum[i] + modelStride) * 4;
+        skinMat += aBoneWeight[i] * mat4(bonePalette[bone], bonePalette[bone + 1], bonePalette[bone + 2], bonePalette[bone + 3]);
+      }
+      return skinMat;
+    }
+  }
+}
+
+/* transforms normals like transpose(inverse(m)), up to a positive scale. the cofactor matrix is det(m) * inverse
+ * transposed, and the normal is normalized in the fragment shader anyway. the sign keeps mirrored matrices correct */
+mat3 getNormalMatrix(mat4 m) {
+  mat3 cofactor = mat3(cross(m[1].xyz, m[2].xyz), cross(m[2].xyz, m[0].xyz), cross(m[0].xyz, m[1].xyz));
+  return dot(m[0].xyz, cofactor[0]) < 0.0 ? -cofactor : cofactor;
+}
 
 void main() {
 
-  int modelStride = gl_InstanceID * aModelStride;
+  int modelStride = aBoneMatrixOffset + gl_InstanceID * aModelStride;
 
-  mat4 skinMat =
-    aBoneWeight.x * boneMat[aBoneNum.x + modelStride] +
-    aBoneWeight.y * boneMat[aBoneNum.y + modelStride] +
-    aBoneWeight.z * boneMat[aBoneNum.z + modelStride] +
-    aBoneWeight.w * boneMat[aBoneNum.w + modelStride];
+  mat4 skinMat = getSkinMatrix(modelStride);
 
-  mat4 worldPosSkinMat = worldPos[gl_InstanceID] * skinMat;
+  mat4 worldPosSkinMat = worldPos[aWorldPosOffset + gl_InstanceID] * skinMat;
   gl_Position = projection * view * worldPosSkinMat * vec4(aPos.x, aPos.y, aPos.z, 1.0);
   color = aColor;
-  normal = transpose(inverse(worldPosSkinMat)) * vec4(aNormal.x, aNormal.y, aNormal.z, 1.0);
+  normal = vec4(getNormalMatrix(worldPosSkinMat) * aNormal.xyz, 1.0);
   texCoord = vec2(aPos.w, aNormal.w);
 }
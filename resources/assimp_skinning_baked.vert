@@ -0,0 +1,74 @@
+#version 460 core
+layout (location = 0) in vec4 aPos; // last float is uv.x :)
+layout (location = 1) in vec4 aColor;
+layout (location = 2) in vec4 aNormal; // last float is uv.y
+layout (location = 3) in uvec4 aBoneNum;
+layout (location = 4) in vec4 aBoneWeight;
+
+layout (location = 0) out vec4 color;
+layout (location = 1) out vec4 normal;
+layout (location = 2) out vec2 texCoord;
+
+layout (std140, binding = 0) uniform Matrices {
+  mat4 view;
+  mat4 projection;
+};
+
+/* final bone matrices of all frames of all clips */
+layout (std430, binding = 1) readonly restrict buffer BakedBoneMatrices {
+  mat4 bakedBoneMat[];
+};
+
+layout (std430, binding = 2) readonly restrict buffer WorldPosMatrices {
+  mat4 worldPos[];
+};
+
+struct BakedAnimRecord {
+  uint clip;
+  uint frame;
+  float blend;
+  uint padding;
+};
+
+layout (std430, binding = 3) readonly restrict buffer BakedAnimRecords {
+  BakedAnimRecord animRecord[];
+};
+
+/* x = first frame, y = number of frames */
+layout (std430, binding = 4) readonly restrict buffer BakedClips {
+  uvec2 bakedClip[];
+};
+
+uniform int aModelStride;
+
+mat4 getSkinMatrix(uint frameOffset) {
+  return
+    aBoneWeight.x * bakedBoneMat[aBoneNum.x + frameOffset] +
+    aBoneWeight.y * bakedBoneMat[aBoneNum.y + frameOffset] +
+    aBoneWeight.z * bakedBoneMat[aBoneNum.z + frameOffset] +
+    aBoneWeight.w * bakedBoneMat[aBoneNum.w + frameOffset];
+}
+
+/* transforms normals like transpose(inverse(m)), up to a positive scale. the cofactor matrix is det(m) * inverse
+ * transposed, and the normal is normalized in the fragment shader anyway. the sign keeps mirrored matrices correct */
+mat3 getNormalMatrix(mat4 m) {
+  mat3 cofactor = mat3(cross(m[1].xyz, m[2].xyz), cross(m[2].xyz, m[0].xyz), cross(m[0].xyz, m[1].xyz));
+  return dot(m[0].xyz, cofactor[0]) < 0.0 ? -cofactor : cofactor;
+}
+
+void main() {
+  BakedAnimRecord record = animRecord[gl_InstanceID];
+  uvec2 clip = bakedClip[record.clip];
+
+  uint frameA = clip.x + record.frame;
+  uint frameB = clip.x + min(record.frame + 1, clip.y - 1);
+
+  mat4 skinMat = getSkinMatrix(frameA * aModelStride) * (1.0 - record.blend) +
+    getSkinMatrix(frameB * aModelStride) * record.blend;
+
+  mat4 worldPosSkinMat = worldPos[gl_InstanceID] * skinMat;
+  gl_Position = projection * view * worldPosSkinMat * vec4(aPos.x, aPos.y, aPos.z, 1.0);
+  color = aColor;
+  normal = vec4(getNormalMatrix(worldPosSkinMat) * aNormal.xyz, 1.0);
+  texCoord = vec2(aPos.w, aNormal.w);
+}
@@ -15,15 +15,45 @@ layout (std140, binding = 0) uniform Matrices {
   mat4 projection;
 };
 
-layout (std430, binding = 1) readonly restrict buffer WorldPosMatrices {
-  mat4 worldPosMat[];
+struct InstanceTransform {
+  vec4 positionScale;
+  vec4 rotation; // quaternion x, y, z, w
 };
 
+layout (std430, binding = 1) readonly restrict buffer InstanceTransforms {
+  InstanceTransform instanceTransforms[];
+};
+
+/* the transforms of all static models share the buffer */
+uniform int aWorldPosOffset;
+uniform mat4 aModelRootMatrix;
+
+/* translation * rotation * uniform scale * model root, like the world matrix of the instance on the CPU */
+mat4 getWorldMatrix(InstanceTransform transform) {
+  vec4 q = transform.rotation;
+  float s = transform.positionScale.w;
+
+  mat3 r = mat3(
+    1.0 - 2.0 * (q.y * q.y + q.z * q.z), 2.0 * (q.x * q.y + q.w * q.z), 2.0 * (q.x * q.z - q.w * q.y),
+    2.0 * (q.x * q.y - q.w * q.z), 1.0 - 2.0 * (q.x * q.x + q.z * q.z), 2.0 * (q.y * q.z + q.w * q.x),
+    2.0 * (q.x * q.z + q.w * q.y), 2.0 * (q.y * q.z - q.w * q.x), 1.0 - 2.0 * (q.x * q.x + q.y * q.y));
+
+  mat4 localMat = mat4(vec4(r[0] * s, 0.0), vec4(r[1] * s, 0.0), vec4(r[2] * s, 0.0), vec4(transform.positionScale.xyz, 1.0));
+  return localMat * aModelRootMatrix;
+}
+
+/* transforms normals like transpose(inverse(m)), up to a positive scale. the cofactor matrix is det(m) * inverse
+ * transposed, and the normal is normalized in the fragment shader anyway. the sign keeps mirrored matrices correct */
+mat3 getNormalMatrix(mat4 m) {
+  mat3 cofactor = mat3(cross(m[1].xyz, m[2].xyz), cross(m[2].xyz, m[0].xyz), cross(m[0].xyz, m[1].xyz));
+  return dot(m[0].xyz, cofactor[0]) < 0.0 ? -cofactor : cofactor;
+}
+
 void main() {
 
-  mat4 modelMat = worldPosMat[gl_InstanceID];
+  mat4 modelMat = getWorldMatrix(instanceTransforms[aWorldPosOffset + gl_InstanceID]);
   gl_Position = projection * view * modelMat * vec4(aPos, 1.0);
   color = aColor;
-  normal = vec3(transpose(inverse(modelMat)) * vec4(aNormal, 1.0));
+  normal = getNormalMatrix(modelMat) * aNormal;
   texCoord = aTexCoord;
 }
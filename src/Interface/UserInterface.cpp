@@ -13,6 +13,7 @@
 #include "Interface/UserInterface.hpp"
 #include "Model/AssimpMesh.hpp"
 #include "Model/AssimpAnimClip.hpp"
+#include "Model/AssimpAnimKernels.hpp"
 #include "Model/AssimpInstance.hpp"
 #include "Model/InstanceSettings.hpp"
 #include "Tools/Logger.hpp"
@@ -34,6 +35,7 @@ void UserInterface::init(OGLRenderData &renderData) {
   mFrameTimeValues.resize(mNumFrameTimeValues);
   mModelUploadValues.resize(mNumModelUploadValues);
   mMatrixGenerationValues.resize(mNumMatrixGenerationValues);
+  mAnimUpdateValues.resize(mNumAnimUpdateValues);
   mMatrixUploadValues.resize(mNumMatrixUploadValues);
   mUiGenValues.resize(mNumUiGenValues);
   mUiDrawValues.resize(mNumUiDrawValues);
@@ -93,6 +95,9 @@ void UserInterface::createFrame(OGLRenderData &renderData, ModelAndInstanceData
     mMatrixGenerationValues.at(mMatrixGenOffset) = renderData.rdMatrixGenerateTime;
     mMatrixGenOffset = ++mMatrixGenOffset % mNumMatrixGenerationValues;
 
+    mAnimUpdateValues.at(mAnimUpdateOffset) = renderData.rdAnimUpdateTime;
+    mAnimUpdateOffset = (mAnimUpdateOffset + 1) % mNumAnimUpdateValues;
+
     mMatrixUploadValues.at(mMatrixUploadOffset) = renderData.rdUploadToUBOTime;
     mMatrixUploadOffset = ++mMatrixUploadOffset % mNumMatrixUploadValues;
 
@@ -144,6 +149,20 @@ void UserInterface::createFrame(OGLRenderData &renderData, ModelAndInstanceData
     }
 
     ImGui::Text("Instance Matrix Size:  %8.2f %2s", memoryUsage, unit.c_str());
+    ImGui::Text("Dirty Instances:        %10u", renderData.rdDirtyInstances);
+
+    unit = "B";
+    float preSkinnedSize = renderData.rdPreSkinnedSize;
+
+    if (preSkinnedSize > 1024.0f * 1024.0f) {
+      preSkinnedSize /= 1024.0f * 1024.0f;
+      unit = "MB";
+    } else  if (preSkinnedSize > 1024.0f) {
+      preSkinnedSize /= 1024.0f;
+      unit = "KB";
+    }
+
+    ImGui::Text("Pre-Skinned Size:      %8.2f %2s", preSkinnedSize, unit.c_str());
 
     std::string windowDims = std::to_string(renderData.rdWidth) + "x" + std::to_string(renderData.rdHeight);
     ImGui::Text("Window Dimensions:      %10s", windowDims.c_str());
@@ -210,6 +229,44 @@ void UserInterface::createFrame(OGLRenderData &renderData, ModelAndInstanceData
       ImGui::EndTooltip();
     }
 
+    ImGui::Text("Animation Update Time:  %10.4f ms", renderData.rdAnimUpdateTime);
+
+    if (ImGui::IsItemHovered()) {
+      ImGui::BeginTooltip();
+      float averageAnimUpdate = 0.0f;
+      for (const auto value : mAnimUpdateValues) {
+        averageAnimUpdate += value;
+      }
+      averageAnimUpdate /= static_cast<float>(mNumAnimUpdateValues);
+      std::string animUpdateOverlay = "now:     " + std::to_string(renderData.rdAnimUpdateTime) +
+        " ms\n30s avg: " + std::to_string(averageAnimUpdate) + " ms";
+      ImGui::AlignTextToFramePadding();
+      ImGui::Text("Animation Update");
+      ImGui::SameLine();
+      ImGui::PlotLines("##AnimUpdateTimes", mAnimUpdateValues.data(), mAnimUpdateValues.size(), mAnimUpdateOffset,
+        animUpdateOverlay.c_str(), 0.0f, std::numeric_limits<float>::max(), ImVec2(0, 80));
+      ImGui::EndTooltip();
+    }
+
+    /* work time summed over all threads vs. wall clock time */
+    float animSpeedup = 0.0f;
+    if (renderData.rdAnimUpdateTime > 0.0f) {
+      animSpeedup = renderData.rdAnimUpdateWorkTime / renderData.rdAnimUpdateTime;
+    }
+    ImGui::Text("Animation Speedup:      %10.2fx (%i threads, %.0f%% efficiency)", animSpeedup, renderData.rdJobThreadCount,
+      animSpeedup / static_cast<float>(renderData.rdJobThreadCount) * 100.0f);
+
+    /* the animation path must not allocate in steady state */
+    ImGui::Text("Frame Allocations:      %10u", renderData.rdFrameAllocations);
+    ImGui::Text("Animation Allocations:  %10u", renderData.rdAnimAllocations);
+
+    ImGui::AlignTextToFramePadding();
+    ImGui::Text("Job Threads:          ");
+    ImGui::SameLine();
+    ImGui::PushItemWidth(200);
+    ImGui::SliderInt("##JobThreads", &renderData.rdJobThreadCount, 1, renderData.rdJobMaxThreadCount, "%d", flags);
+    ImGui::PopItemWidth();
+
     ImGui::Text("Matrix Upload Time:     %10.4f ms", renderData.rdUploadToUBOTime);
 
     if (ImGui::IsItemHovered()) {
@@ -408,6 +465,99 @@ void UserInterface::createFrame(OGLRenderData &renderData, ModelAndInstanceData
     if (mModelListEmtpy) {
       ImGui::EndDisabled();
     }
+
+    /* baked animations of the selected model */
+    if (!mModelListEmtpy) {
+      std::shared_ptr<AssimpModel> currentModel = modInstData.miModelList.at(modInstData.miSelectedModel);
+      bool canBakeAnimations = currentModel->hasAnimations() && !currentModel->getBoneList().empty();
+      bool useBakedAnimations = currentModel->getUseBakedAnimations();
+
+      if (!canBakeAnimations) {
+        ImGui::BeginDisabled();
+      }
+      ImGui::Text("Baked Animation:");
+      ImGui::SameLine();
+      if (ImGui::Checkbox("##BakedAnimation", &useBakedAnimations)) {
+        currentModel->setUseBakedAnimations(useBakedAnimations);
+      }
+      if (!canBakeAnimations) {
+        ImGui::EndDisabled();
+      }
+
+      if (currentModel->hasBakedAnimations()) {
+        ImGui::Text("Baked Frames:");
+        ImGui::SameLine();
+        ImGui::Text("%u at %.0f fps (%.2f MB, %.2f ms)", currentModel->getBakedFrameCount(), currentModel->getBakeFramesPerSecond(),
+          currentModel->getBakedAnimationSize() / (1024.0f * 1024.0f), currentModel->getBakeTime());
+      }
+
+      /* skinning in a compute shader, the baked animations are skinned in the vertex shader */
+      if (currentModel->hasAnimations()) {
+        bool preSkinning = currentModel->getPreSkinning();
+        if (useBakedAnimations) {
+          ImGui::BeginDisabled();
+        }
+        ImGui::Text("Pre-Skinning:");
+        ImGui::SameLine();
+        if (ImGui::Checkbox("##PreSkinning", &preSkinning)) {
+          currentModel->setPreSkinning(preSkinning);
+        }
+        if (useBakedAnimations) {
+          ImGui::EndDisabled();
+        }
+      }
+
+      /* key compression of the selected model */
+      if (currentModel->hasAnimations()) {
+        ImGui::Text("Key Compression:");
+        ImGui::SameLine();
+        ImGui::Checkbox("##KeyCompression", &mAnimCompressionSettings.enabled);
+
+        if (!mAnimCompressionSettings.enabled) {
+          ImGui::BeginDisabled();
+        }
+        ImGui::Text("Translation Error:");
+        ImGui::SameLine();
+        ImGui::SliderFloat("##TranslationError", &mAnimCompressionSettings.translationError, 0.0f, 0.1f, "%.4f", flags);
+        ImGui::Text("Rotation Error:   ");
+        ImGui::SameLine();
+        ImGui::SliderAngle("##RotationError", &mAnimCompressionSettings.rotationError, 0.0f, 5.0f, "%.3f deg", flags);
+        ImGui::Text("Scale Error:      ");
+        ImGui::SameLine();
+        ImGui::SliderFloat("##ScaleError", &mAnimCompressionSettings.scaleError, 0.0f, 0.1f, "%.4f", flags);
+        ImGui::Text("Quantize Keys:");
+        ImGui::SameLine();
+        ImGui::Checkbox("##QuantizeKeys", &mAnimCompressionSettings.quantize);
+        if (!mAnimCompressionSettings.enabled) {
+          ImGui::EndDisabled();
+        }
+
+        ImGui::Text("Resample Keys:");
+        ImGui::SameLine();
+        ImGui::Checkbox("##ResampleKeys", &mAnimCompressionSettings.resample);
+        if (!mAnimCompressionSettings.resample) {
+          ImGui::BeginDisabled();
+        }
+        ImGui::Text("Resample Rate:    ");
+        ImGui::SameLine();
+        ImGui::SliderFloat("##ResampleRate", &mAnimCompressionSettings.resampleRate, 10.0f, 120.0f, "%.0f keys/s", flags);
+        if (!mAnimCompressionSettings.resample) {
+          ImGui::EndDisabled();
+        }
+
+        if (ImGui::Button("Apply Compression")) {
+          currentModel->setAnimCompressionSettings(mAnimCompressionSettings);
+        }
+
+        AnimCompressionStats compressionStats = currentModel->getAnimCompressionStats();
+        ImGui::Text("Keys: %u of %u (%u constant tracks)", compressionStats.packedKeys, compressionStats.rawKeys, compressionStats.constantTracks);
+        ImGui::Text("Clip Size: %.2f KB of %.2f KB", compressionStats.packedSize / 1024.0f, compressionStats.rawSize / 1024.0f);
+        if (compressionStats.resampleGrowth > 0 || compressionStats.resampleSavings > 0) {
+          ImGui::Text("Resampling: +%.2f KB keys, -%.2f KB timings", compressionStats.resampleGrowth / 1024.0f,
+            compressionStats.resampleSavings / 1024.0f);
+        }
+      }
+    }
   }
 
   if (ImGui::CollapsingHeader("Instances")) {
@@ -461,7 +611,9 @@ void UserInterface::createFrame(OGLRenderData &renderData, ModelAndInstanceData
     if (!modInstData.miAssimpInstances.empty()) {
       std::shared_ptr<AssimpInstance> currentInstance = modInstData.miAssimpInstances.at(modInstData.miSelectedInstance);
       std::string currentModelName = currentInstance->getModel()->getModelFileName();
-      numberOfInstancesPerModel = modInstData.miAssimpInstancesPerModel[currentModelName].size();
+      if (modInstData.miInstanceStores.count(currentModelName) > 0) {
+        numberOfInstancesPerModel = modInstData.miInstanceStores.at(currentModelName)->size();
+      }
     }
 
     if (numberOfInstancesPerModel < 2) {
@@ -559,7 +711,9 @@ void UserInterface::createFrame(OGLRenderData &renderData, ModelAndInstanceData
         for (int i = 0; i < animClips.size(); ++i) {
           const bool isSelected = (settings.isAnimClipNr == i);
           if (ImGui::Selectable(animClips.at(i)->getClipName().c_str(), isSelected)) {
-            settings.isAnimClipNr = i;
+            std::shared_ptr<AssimpInstance> instance = modInstData.miAssimpInstances.at(modInstData.miSelectedInstance);
+            instance->crossFadeToClip(i, mAnimCrossFadeTime);
+            settings = instance->getInstanceSettings();
           }
 
           if (isSelected) {
@@ -572,6 +726,73 @@ void UserInterface::createFrame(OGLRenderData &renderData, ModelAndInstanceData
       ImGui::Text("Replay Speed:  ");
       ImGui::SameLine();
       ImGui::SliderFloat("##ClipSpeed", &settings.isAnimSpeedFactor, 0.0f, 2.0f, "%.3f", flags);
+
+      ImGui::Text("Clip NLERP Error: %8.4f deg", glm::degrees(animClips.at(settings.isAnimClipNr)->getPackedClip().maxNlerpError));
+
+      ImGui::AlignTextToFramePadding();
+      ImGui::Text("Crossfade Time:");
+      ImGui::SameLine();
+      ImGui::SliderFloat("##ClipCrossFade", &mAnimCrossFadeTime, 0.0f, 2.0f, "%.2f s", flags);
+
+      /* blend layers of the selected instance */
+      std::shared_ptr<AssimpModel> instanceModel = modInstData.miAssimpInstances.at(modInstData.miSelectedInstance)->getModel();
+      ImGui::AlignTextToFramePadding();
+      ImGui::Text("Blend Layer:   ");
+      ImGui::SameLine();
+      ImGui::SliderInt("##BlendLayer", &mAnimLayerNr, 0, static_cast<int>(settings.isAnimLayers.size()) - 1, "%d", flags);
+
+      AnimBlendLayer& layer = settings.isAnimLayers.at(mAnimLayerNr);
+      ImGui::AlignTextToFramePadding();
+      ImGui::Text("Layer Clip:    ");
+      ImGui::SameLine();
+      if (ImGui::BeginCombo("##LayerClipCombo", animClips.at(layer.ablClipNr)->getClipName().c_str())) {
+        for (unsigned int i = 0; i < animClips.size(); ++i) {
+          const bool isSelected = (layer.ablClipNr == i);
+          if (ImGui::Selectable(animClips.at(i)->getClipName().c_str(), isSelected)) {
+            layer.ablClipNr = i;
+            layer.ablPlayTimePos = 0.0f;
+          }
+
+          if (isSelected) {
+            ImGui::SetItemDefaultFocus();
+          }
+        }
+        ImGui::EndCombo();
+      }
+
+      ImGui::AlignTextToFramePadding();
+      ImGui::Text("Layer Weight:  ");
+      ImGui::SameLine();
+      ImGui::SliderFloat("##LayerWeight", &layer.ablWeight, 0.0f, 1.0f, "%.3f", flags);
+
+      bool additiveLayer = layer.ablMode == animBlendMode::additive;
+      ImGui::AlignTextToFramePadding();
+      ImGui::Text("Additive:      ");
+      ImGui::SameLine();
+      if (ImGui::Checkbox("##LayerAdditive", &additiveLayer)) {
+        layer.ablMode = additiveLayer ? animBlendMode::additive : animBlendMode::replace;
+      }
+
+      std::string layerMaskName = layer.ablBoneMask < 0 ? "All Bones" : instanceModel->getBoneMaskName(layer.ablBoneMask);
+      ImGui::AlignTextToFramePadding();
+      ImGui::Text("Layer Mask:    ");
+      ImGui::SameLine();
+      if (ImGui::BeginCombo("##LayerMaskCombo", layerMaskName.c_str())) {
+        if (ImGui::Selectable("All Bones", layer.ablBoneMask < 0)) {
+          layer.ablBoneMask = -1;
+        }
+        for (const auto& bone : instanceModel->getBoneList()) {
+          const bool isSelected = bone->getBoneName() == layerMaskName;
+          if (ImGui::Selectable(bone->getBoneName().c_str(), isSelected)) {
+            layer.ablBoneMask = instanceModel->createBoneMask(bone->getBoneName());
+          }
+
+          if (isSelected) {
+            ImGui::SetItemDefaultFocus();
+          }
+        }
+        ImGui::EndCombo();
+      }
     } else {
       /* TODO: better solution if no instances or no clips are found */
       ImGui::BeginDisabled();
@@ -593,8 +814,209 @@ void UserInterface::createFrame(OGLRenderData &renderData, ModelAndInstanceData
     if (numberOfInstances > 0) {
       modInstData.miAssimpInstances.at(modInstData.miSelectedInstance)->setInstanceSettings(settings);
     }
+
+    ImGui::AlignTextToFramePadding();
+    ImGui::Text("Use NLERP:     ");
+    ImGui::SameLine();
+    ImGui::Checkbox("##AnimNlerp", &renderData.rdAnimUseNlerp);
+
+    ImGui::AlignTextToFramePadding();
+    ImGui::Text("Pose Cache:    ");
+    ImGui::SameLine();
+    ImGui::Checkbox("##AnimPoseCache", &renderData.rdPoseCacheEnabled);
+
+    if (!renderData.rdPoseCacheEnabled) {
+      ImGui::BeginDisabled();
+    }
+    ImGui::AlignTextToFramePadding();
+    ImGui::Text("Cache Step:    ");
+    ImGui::SameLine();
+    ImGui::PushItemWidth(200);
+    ImGui::SliderFloat("##AnimPoseCacheStep", &renderData.rdPoseCacheStep, 0.001f, 0.1f, "%.3f s", flags);
+    ImGui::PopItemWidth();
+
+    float poseCacheHitRate = 0.0f;
+    if (renderData.rdPoseCacheLookups > 0) {
+      poseCacheHitRate = static_cast<float>(renderData.rdPoseCacheHits) / static_cast<float>(renderData.rdPoseCacheLookups) * 100.0f;
+    }
+    ImGui::Text("Cache Hits:     %u of %u (%.1f%%)", renderData.rdPoseCacheHits, renderData.rdPoseCacheLookups, poseCacheHitRate);
+    if (!renderData.rdPoseCacheEnabled) {
+      ImGui::EndDisabled();
+    }
+
+    ImGui::Text("Blended:        %u instances, %u layers", renderData.rdAnimBlendedInstances, renderData.rdAnimBlendLayers);
+
+    ImGui::AlignTextToFramePadding();
+    ImGui::Text("Fused Bones:   ");
+    ImGui::SameLine();
+    ImGui::Checkbox("##FusedBoneMatrices", &renderData.rdFusedBoneMatrices);
+
+    if (!renderData.rdFusedBoneMatrices) {
+      ImGui::BeginDisabled();
+    }
+    ImGui::AlignTextToFramePadding();
+    ImGui::Text("GPU Sampling:  ");
+    ImGui::SameLine();
+    ImGui::Checkbox("##GpuAnimSampling", &renderData.rdGpuAnimSampling);
+    if (!renderData.rdFusedBoneMatrices) {
+      ImGui::EndDisabled();
+    }
+
+    int bonePalette = static_cast<int>(renderData.rdBonePaletteFormat);
+    ImGui::AlignTextToFramePadding();
+    ImGui::Text("Bone Palette:  ");
+    ImGui::SameLine();
+    ImGui::RadioButton("mat4", &bonePalette, static_cast<int>(bonePaletteFormat::mat4));
+    ImGui::SameLine();
+    ImGui::RadioButton("3x4", &bonePalette, static_cast<int>(bonePaletteFormat::affine3x4));
+    ImGui::SameLine();
+    ImGui::RadioButton("Dual Quat", &bonePalette, static_cast<int>(bonePaletteFormat::dualQuaternion));
+    renderData.rdBonePaletteFormat = static_cast<bonePaletteFormat>(bonePalette);
+
+    ImGui::AlignTextToFramePadding();
+    ImGui::Text("Frustum Culling:");
+    ImGui::SameLine();
+    ImGui::Checkbox("##FrustumCulling", &renderData.rdFrustumCullingEnabled);
+
+    if (!renderData.rdFrustumCullingEnabled) {
+      ImGui::BeginDisabled();
+    }
+    ImGui::AlignTextToFramePadding();
+    ImGui::Text("Culling Margin:");
+    ImGui::SameLine();
+    ImGui::PushItemWidth(200);
+    ImGui::SliderFloat("##FrustumCullingMargin", &renderData.rdFrustumCullingMargin, 1.0f, 4.0f, "%.2f", flags);
+    ImGui::PopItemWidth();
+    ImGui::Text("Culled:         %u instances", renderData.rdCulledInstances);
+    if (!renderData.rdFrustumCullingEnabled) {
+      ImGui::EndDisabled();
+    }
+
+    ImGui::AlignTextToFramePadding();
+    ImGui::Text("Animation LOD: ");
+    ImGui::SameLine();
+    ImGui::Checkbox("##AnimLod", &renderData.rdAnimLodEnabled);
+
+    if (!renderData.rdAnimLodEnabled) {
+      ImGui::BeginDisabled();
+    }
+    ImGui::AlignTextToFramePadding();
+    ImGui::Text("Near Distance: ");
+    ImGui::SameLine();
+    ImGui::PushItemWidth(200);
+    ImGui::SliderFloat("##AnimLodNear", &renderData.rdAnimLodNearDistance, 1.0f, 500.0f, "%.1f", flags);
+    ImGui::PopItemWidth();
+    renderData.rdAnimLodFarDistance = std::max(renderData.rdAnimLodFarDistance, renderData.rdAnimLodNearDistance);
+
+    ImGui::AlignTextToFramePadding();
+    ImGui::Text("Far Distance:  ");
+    ImGui::SameLine();
+    ImGui::PushItemWidth(200);
+    ImGui::SliderFloat("##AnimLodFar", &renderData.rdAnimLodFarDistance, renderData.rdAnimLodNearDistance, 1000.0f, "%.1f", flags);
+    ImGui::PopItemWidth();
+
+    ImGui::AlignTextToFramePadding();
+    ImGui::Text("Mid Interval:  ");
+    ImGui::SameLine();
+    ImGui::PushItemWidth(200);
+    ImGui::SliderInt("##AnimLodMidInterval", &renderData.rdAnimLodMidInterval, 1, 8, "%d frames", flags);
+    ImGui::PopItemWidth();
+
+    ImGui::AlignTextToFramePadding();
+    ImGui::Text("Far Interval:  ");
+    ImGui::SameLine();
+    ImGui::PushItemWidth(200);
+    ImGui::SliderInt("##AnimLodFarInterval", &renderData.rdAnimLodFarInterval, 1, 60, "%d frames", flags);
+    ImGui::PopItemWidth();
+
+    ImGui::Text("LOD Bands:      %u near, %u mid, %u far", renderData.rdAnimLodNearInstances, renderData.rdAnimLodMidInstances,
+      renderData.rdAnimLodFarInstances);
+    ImGui::Text("Sampled:        %u of %u", renderData.rdAnimLodSampledInstances,
+      renderData.rdAnimLodNearInstances + renderData.rdAnimLodMidInstances + renderData.rdAnimLodFarInstances);
+    if (!renderData.rdAnimLodEnabled) {
+      ImGui::EndDisabled();
+    }
+
+    /* only the levels supported by the CPU can be selected */
+    int kernelLevel = static_cast<int>(AssimpAnimKernels::getSimdLevel());
+    int supportedLevel = static_cast<int>(AssimpAnimKernels::getSupportedSimdLevel());
+    ImGui::AlignTextToFramePadding();
+    ImGui::Text("SIMD Kernels:  ");
+    ImGui::SameLine();
+    ImGui::PushItemWidth(200);
+    ImGui::SliderInt("##AnimSimdLevel", &kernelLevel, 0, supportedLevel,
+      AssimpAnimKernels::getSimdLevelName(static_cast<simdLevel>(kernelLevel)), flags);
+    ImGui::PopItemWidth();
+    AssimpAnimKernels::setSimdLevel(static_cast<simdLevel>(kernelLevel));
   }
   
+  if (ImGui::CollapsingHeader("Benchmarks")) {
+    std::shared_ptr<AssimpModel> selectedModel = nullptr;
+    if (!modInstData.miModelList.empty()) {
+      selectedModel = modInstData.miModelList.at(modInstData.miSelectedModel);
+    }
+
+    bool hasAnimatedModel = selectedModel && selectedModel->hasAnimations();
+    if (!hasAnimatedModel) {
+      ImGui::BeginDisabled();
+    }
+
+    if (ImGui::Button("Animation Sampling")) {
+      modInstData.miBenchmarkRunCallbackFunction(benchmarkType::animSampling, selectedModel);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Batched Sampling")) {
+      modInstData.miBenchmarkRunCallbackFunction(benchmarkType::animBatchSampling, selectedModel);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("SIMD Interpolation")) {
+      modInstData.miBenchmarkRunCallbackFunction(benchmarkType::animSimdInterpolation, selectedModel);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Pose Cache")) {
+      modInstData.miBenchmarkRunCallbackFunction(benchmarkType::animPoseCache, selectedModel);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Key Compression")) {
+      modInstData.miBenchmarkRunCallbackFunction(benchmarkType::animKeyCompression, selectedModel);
+    }
+
+    if (!hasAnimatedModel) {
+      ImGui::EndDisabled();
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("Job System")) {
+      modInstData.miBenchmarkRunCallbackFunction(benchmarkType::jobSystemStress, selectedModel);
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("Bone Hierarchy")) {
+      modInstData.miBenchmarkRunCallbackFunction(benchmarkType::boneHierarchy, selectedModel);
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("World Matrices")) {
+      modInstData.miBenchmarkRunCallbackFunction(benchmarkType::worldMatrixBuild, selectedModel);
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("Clear Results")) {
+      modInstData.miBenchmarkResults.clear();
+    }
+
+    for (const auto& result : modInstData.miBenchmarkResults) {
+      ImGui::Separator();
+      ImGui::Text("%s", result.brName.c_str());
+      ImGui::Text("  %-22s %10.4f ms", result.brBaselineName.c_str(), result.brBaselineTime);
+      ImGui::Text("  %-22s %10.4f ms", result.brOptimizedName.c_str(), result.brOptimizedTime);
+      if (result.brOptimizedTime > 0.0f) {
+        ImGui::Text("  speedup:               %10.2fx", result.brBaselineTime / result.brOptimizedTime);
+      }
+      ImGui::TextWrapped("  %s", result.brDetails.c_str());
+    }
+  }
+
   if (ImGui::CollapsingHeader("Lighting")) {
     ImGui::Text("Number of Lights: %ld", renderData.Lights.size());
     
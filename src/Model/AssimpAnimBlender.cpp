@@ -0,0 +1,169 @@
+#include <algorithm>
+
+#include <glm/gtc/quaternion.hpp>
+
+#include "Model/AssimpAnimBlender.hpp"
+#include "Model/AssimpAnimSampler.hpp"
+#include "Tools/JobSystem.hpp"
+
+void AssimpAnimBlender::clear() {
+  mJobs.clear();
+}
+
+const AnimBlendStats& AssimpAnimBlender::getStatistics() {
+  return mStats;
+}
+
+void AssimpAnimBlender::resetStatistics() {
+  mStats = AnimBlendStats{};
+}
+
+void AssimpAnimBlender::addInstance(const InstanceSettings& settings, NodeTransformData* pose) {
+  size_t numJobs = mJobs.size();
+
+  /* the previous clip is blended over the new one, with a weight going down to zero */
+  if (settings.isAnimFadeClipNr >= 0 && settings.isAnimFadeDuration > 0.0f) {
+    float fadeWeight = 1.0f - std::clamp(settings.isAnimFadeTime / settings.isAnimFadeDuration, 0.0f, 1.0f);
+    if (fadeWeight > 0.0f) {
+      AnimBlendJob job{};
+      job.abjLevel = 0;
+      job.abjClipNr = static_cast<unsigned int>(settings.isAnimFadeClipNr);
+      job.abjTime = settings.isAnimFadePlayTimePos;
+      job.abjWeight = fadeWeight;
+      job.abjPose = pose;
+      mJobs.emplace_back(job);
+    }
+  }
+
+  for (size_t i = 0; i < settings.isAnimLayers.size(); ++i) {
+    const AnimBlendLayer& layer = settings.isAnimLayers.at(i);
+    if (layer.ablWeight <= 0.0f) {
+      continue;
+    }
+
+    AnimBlendJob job{};
+    job.abjLevel = static_cast<unsigned int>(i + 1);
+    job.abjClipNr = layer.ablClipNr;
+    job.abjTime = layer.ablPlayTimePos;
+    job.abjWeight = std::min(layer.ablWeight, 1.0f);
+    job.abjMode = layer.ablMode;
+    job.abjBoneMask = layer.ablBoneMask;
+    job.abjPose = pose;
+    mJobs.emplace_back(job);
+  }
+
+  if (mJobs.size() > numJobs) {
+    ++mStats.absBlendedInstances;
+  }
+}
+
+float AssimpAnimBlender::blendLayers(const std::shared_ptr<AssimpModel>& model, size_t numBones, bool useNlerp) {
+  const std::vector<std::shared_ptr<AssimpAnimClip>>& animClips = model->getAnimClips();
+  mJobs.erase(std::remove_if(mJobs.begin(), mJobs.end(), [&animClips](const AnimBlendJob& job) { return job.abjClipNr >= animClips.size(); }),
+    mJobs.end());
+
+  size_t numJobs = mJobs.size();
+  if (numJobs == 0) {
+    return 0.0f;
+  }
+  mStats.absSampledLayers += static_cast<unsigned int>(numJobs);
+
+  /* the levels of an instance must be blended in order, inside a level the jobs are grouped by clip */
+  std::sort(mJobs.begin(), mJobs.end(), [](const AnimBlendJob& a, const AnimBlendJob& b) {
+    return a.abjLevel != b.abjLevel ? a.abjLevel < b.abjLevel : a.abjClipNr < b.abjClipNr;
+  });
+
+  mTimes.resize(numJobs);
+  mLayerPoses.resize(numJobs * numBones);
+  for (size_t i = 0; i < numJobs; ++i) {
+    mTimes[i] = mJobs[i].abjTime;
+  }
+
+  float workTime = 0.0f;
+  size_t levelStart = 0;
+  while (levelStart < numJobs) {
+    size_t levelEnd = levelStart;
+    while (levelEnd < numJobs && mJobs[levelEnd].abjLevel == mJobs[levelStart].abjLevel) {
+      ++levelEnd;
+    }
+
+    /* every job writes to another instance, a chunk may span more than one clip */
+    workTime += JobSystem::parallelFor(levelEnd - levelStart, mBlendGrainSize, [&](size_t begin, size_t end) {
+      size_t rangeStart = levelStart + begin;
+      size_t chunkEnd = levelStart + end;
+      while (rangeStart < chunkEnd) {
+        unsigned int clipNr = mJobs[rangeStart].abjClipNr;
+        size_t rangeEnd = rangeStart;
+        while (rangeEnd < chunkEnd && mJobs[rangeEnd].abjClipNr == clipNr) {
+          ++rangeEnd;
+        }
+
+        AssimpAnimSampler::sampleClip(animClips.at(clipNr), mTimes.data() + rangeStart, rangeEnd - rangeStart, numBones,
+          mLayerPoses.data() + rangeStart * numBones, nullptr, useNlerp);
+
+        const NodeTransformData* referencePose = model->getAnimReferencePose(clipNr);
+        for (size_t i = rangeStart; i < rangeEnd; ++i) {
+          const AnimBlendJob& job = mJobs[i];
+          const float* boneMask = nullptr;
+          if (job.abjBoneMask >= 0 && static_cast<unsigned int>(job.abjBoneMask) < model->getBoneMaskCount()) {
+            boneMask = model->getBoneMask(job.abjBoneMask).data();
+          }
+          blendPose(job.abjPose, mLayerPoses.data() + i * numBones, numBones, job.abjWeight, job.abjMode, referencePose, boneMask);
+        }
+        rangeStart = rangeEnd;
+      }
+    });
+    levelStart = levelEnd;
+  }
+
+  return workTime;
+}
+
+void AssimpAnimBlender::blendPose(NodeTransformData* pose, const NodeTransformData* layerPose, size_t numBones, float weight,
+    animBlendMode mode, const NodeTransformData* referencePose, const float* boneMask) {
+  for (size_t bone = 0; bone < numBones; ++bone) {
+    float boneWeight = boneMask ? weight * boneMask[bone] : weight;
+    if (boneWeight <= 0.0f) {
+      continue;
+    }
+
+    NodeTransformData& target = pose[bone];
+    const NodeTransformData& layer = layerPose[bone];
+
+    /* rotations are stored as x, y, z, w */
+    glm::quat targetRotation = glm::quat(target.rotation.w, target.rotation.x, target.rotation.y, target.rotation.z);
+    glm::quat layerRotation = glm::quat(layer.rotation.w, layer.rotation.x, layer.rotation.y, layer.rotation.z);
+    glm::quat rotation;
+
+    if (mode == animBlendMode::additive && referencePose) {
+      const NodeTransformData& reference = referencePose[bone];
+      glm::quat referenceRotation = glm::quat(reference.rotation.w, reference.rotation.x, reference.rotation.y, reference.rotation.z);
+
+      target.translation += glm::vec4(boneWeight * (glm::vec3(layer.translation) - glm::vec3(reference.translation)), 0.0f);
+      for (int c = 0; c < 3; ++c) {
+        float scaleRatio = reference.scale[c] != 0.0f ? layer.scale[c] / reference.scale[c] : 1.0f;
+        target.scale[c] *= glm::mix(1.0f, scaleRatio, boneWeight);
+      }
+
+      /* the difference to the first frame of the layer clip is added on top of the pose */
+      glm::quat delta = glm::inverse(referenceRotation) * layerRotation;
+      if (delta.w < 0.0f) {
+        delta = -delta;
+      }
+      delta = glm::normalize(glm::quat(glm::mix(1.0f, delta.w, boneWeight), boneWeight * delta.x, boneWeight * delta.y, boneWeight * delta.z));
+      rotation = glm::normalize(targetRotation * delta);
+    } else {
+      target.translation = glm::mix(target.translation, layer.translation, boneWeight);
+      target.scale = glm::mix(target.scale, layer.scale, boneWeight);
+
+      /* NLERP in the hemisphere of the pose, exact enough for blending */
+      if (glm::dot(targetRotation, layerRotation) < 0.0f) {
+        layerRotation = -layerRotation;
+      }
+      rotation = glm::normalize(glm::quat(glm::mix(targetRotation.w, layerRotation.w, boneWeight), glm::mix(targetRotation.x, layerRotation.x, boneWeight),
+        glm::mix(targetRotation.y, layerRotation.y, boneWeight), glm::mix(targetRotation.z, layerRotation.z, boneWeight)));
+    }
+
+    target.rotation = glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w);
+  }
+}
@@ -1,3 +1,5 @@
+#include <limits>
+
 #include "Model/AssimpAnimChannel.hpp"
 
 #include "Tools/Logger.hpp"
@@ -55,7 +57,45 @@ float AssimpAnimChannel::getMaxTime() {
   return std::max(std::max(maxRotationTime, maxTranslationTime), maxScaleTime);
 }
 
+unsigned int AssimpAnimChannel::findKeyIndex(const float* timings, unsigned int numKeys, float time, unsigned int& cursor) {
+  unsigned int lastKeyIndex = numKeys - 2;
+
+  /* forward-moving time: the key is the cursor position or only a few keys behind it */
+  if (cursor <= lastKeyIndex && timings[cursor] <= time) {
+    for (unsigned int i = 0; i < mMaxCursorSteps; ++i) {
+      if (cursor == lastKeyIndex || time < timings[cursor + 1]) {
+        return cursor;
+      }
+      ++cursor;
+    }
+  }
+
+  /* loop or seek, search the entire track */
+  const float* timeIndexPos = std::upper_bound(timings, timings + numKeys, time);
+  /* catch rare cases where time is exaclty zero */
+  int timeIndex = static_cast<int>(timeIndexPos - timings) - 1;
+  cursor = static_cast<unsigned int>(std::clamp(timeIndex, 0, static_cast<int>(lastKeyIndex)));
+
+  return cursor;
+}
+
 glm::vec4 AssimpAnimChannel::getTranslation(float time) {
+  /* an invalid cursor always triggers the binary search */
+  unsigned int cursor = std::numeric_limits<unsigned int>::max();
+  return getTranslation(time, cursor);
+}
+
+glm::vec4 AssimpAnimChannel::getScaling(float time) {
+  unsigned int cursor = std::numeric_limits<unsigned int>::max();
+  return getScaling(time, cursor);
+}
+
+glm::vec4 AssimpAnimChannel::getRotation(float time) {
+  unsigned int cursor = std::numeric_limits<unsigned int>::max();
+  return getRotation(time, cursor);
+}
+
+glm::vec4 AssimpAnimChannel::getTranslation(float time, unsigned int& cursor) {
   if (mTranslations.empty()) {
     return glm::vec4(0.0f);
   }
@@ -64,14 +104,14 @@ glm::vec4 AssimpAnimChannel::getTranslation(float time) {
   switch (mPreState) {
     case 0:
       /* do not change vertex position-> aiAnimBehaviour_DEFAULT */
-      if (time < mTranslationTiminngs.at(0)) {
+      if (time < mTranslationTiminngs[0]) {
         return glm::vec4(0.0f);
       }
       break;
     case 1:
       /* use value at zero time "aiAnimBehaviour_CONSTANT" */
-      if (time < mTranslationTiminngs.at(0)) {
-        return glm::vec4(mTranslations.at(0), 1.0f);
+      if (time < mTranslationTiminngs[0]) {
+        return glm::vec4(mTranslations[0], 1.0f);
       }
       break;
     default:
@@ -81,13 +121,13 @@ glm::vec4 AssimpAnimChannel::getTranslation(float time) {
 
   switch(mPostState) {
     case 0:
-      if (time > mTranslationTiminngs.at(mTranslationTiminngs.size() - 1)) {
+      if (time > mTranslationTiminngs.back()) {
         return glm::vec4(0.0f);
       }
       break;
     case 1:
-      if (time >= mTranslationTiminngs.at(mTranslationTiminngs.size() - 1)) {
-        return glm::vec4(mTranslations.at(mTranslations.size() - 1), 1.0f);
+      if (time >= mTranslationTiminngs.back()) {
+        return glm::vec4(mTranslations.back(), 1.0f);
       }
       break;
     default:
@@ -95,16 +135,19 @@ glm::vec4 AssimpAnimChannel::getTranslation(float time) {
       break;
   }
 
-  auto timeIndexPos = std::lower_bound(mTranslationTiminngs.begin(), mTranslationTiminngs.end(), time);
-  /* catch rare cases where time is exaclty zero */
-  int timeIndex = std::max(static_cast<int>(std::distance(mTranslationTiminngs.begin(), timeIndexPos)) - 1, 0);
+  /* nothing to interpolate */
+  if (mTranslations.size() == 1) {
+    return glm::vec4(mTranslations[0], 1.0f);
+  }
 
-  float interpolatedTime = (time - mTranslationTiminngs.at(timeIndex)) * mInverseTranslationTimeDiffs.at(timeIndex);
+  unsigned int timeIndex = findKeyIndex(mTranslationTiminngs.data(), static_cast<unsigned int>(mTranslationTiminngs.size()), time, cursor);
 
-  return glm::vec4(glm::mix(mTranslations.at(timeIndex), mTranslations.at(timeIndex + 1), interpolatedTime), 1.0f);
+  float interpolatedTime = (time - mTranslationTiminngs[timeIndex]) * mInverseTranslationTimeDiffs[timeIndex];
+
+  return glm::vec4(glm::mix(mTranslations[timeIndex], mTranslations[timeIndex + 1], interpolatedTime), 1.0f);
 }
 
-glm::vec4 AssimpAnimChannel::getScaling(float time) {
+glm::vec4 AssimpAnimChannel::getScaling(float time, unsigned int& cursor) {
   if (mScalings.empty()) {
     return glm::vec4(1.0f);
   }
@@ -113,14 +156,14 @@ glm::vec4 AssimpAnimChannel::getScaling(float time) {
   switch (mPreState) {
     case 0:
       /* do not change vertex position-> aiAnimBehaviour_DEFAULT */
-      if (time < mScaleTimings.at(0)) {
+      if (time < mScaleTimings[0]) {
         return glm::vec4(0.0f);
       }
       break;
     case 1:
       /* use value at zero time "aiAnimBehaviour_CONSTANT" */
-      if (time < mScaleTimings.at(0)) {
-        return glm::vec4(mScalings.at(0), 1.0f);
+      if (time < mScaleTimings[0]) {
+        return glm::vec4(mScalings[0], 1.0f);
       }
       break;
     default:
@@ -130,13 +173,13 @@ glm::vec4 AssimpAnimChannel::getScaling(float time) {
 
   switch(mPostState) {
     case 0:
-      if (time > mScaleTimings.at(mScaleTimings.size() - 1)) {
+      if (time > mScaleTimings.back()) {
         return glm::vec4(0.0f);
       }
       break;
     case 1:
-      if (time >= mScaleTimings.at(mScaleTimings.size() - 1)) {
-        return glm::vec4(mScalings.at(mScalings.size() - 1), 1.0f);
+      if (time >= mScaleTimings.back()) {
+        return glm::vec4(mScalings.back(), 1.0f);
       }
       break;
     default:
@@ -144,15 +187,18 @@ glm::vec4 AssimpAnimChannel::getScaling(float time) {
       break;
   }
 
-  auto timeIndexPos = std::lower_bound(mScaleTimings.begin(), mScaleTimings.end(), time);
-  int timeIndex = std::max(static_cast<int>(std::distance(mScaleTimings.begin(), timeIndexPos)) - 1, 0);
+  if (mScalings.size() == 1) {
+    return glm::vec4(mScalings[0], 1.0f);
+  }
+
+  unsigned int timeIndex = findKeyIndex(mScaleTimings.data(), static_cast<unsigned int>(mScaleTimings.size()), time, cursor);
 
-  float interpolatedTime = (time - mScaleTimings.at(timeIndex)) * mInverseScaleTimeDiffs.at(timeIndex);
+  float interpolatedTime = (time - mScaleTimings[timeIndex]) * mInverseScaleTimeDiffs[timeIndex];
 
-  return glm::vec4(glm::mix(mScalings.at(timeIndex), mScalings.at(timeIndex + 1), interpolatedTime), 1.0f);
+  return glm::vec4(glm::mix(mScalings[timeIndex], mScalings[timeIndex + 1], interpolatedTime), 1.0f);
 }
 
-glm::vec4 AssimpAnimChannel::getRotation(float time) {
+glm::vec4 AssimpAnimChannel::getRotation(float time, unsigned int& cursor) {
   if (mRotations.empty()) {
     return glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
   }
@@ -161,14 +207,14 @@ glm::vec4 AssimpAnimChannel::getRotation(float time) {
   switch (mPreState) {
     case 0:
       /* do not change vertex position-> aiAnimBehaviour_DEFAULT */
-      if (time < mRotationTiminigs.at(0)) {
+      if (time < mRotationTiminigs[0]) {
         return glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
       }
       break;
     case 1:
       /* use value at zero time "aiAnimBehaviour_CONSTANT" */
-      if (time < mRotationTiminigs.at(0)) {
-        glm::quat rotation = mRotations.at(0);
+      if (time < mRotationTiminigs[0]) {
+        glm::quat rotation = mRotations[0];
         return glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w);
       }
       break;
@@ -179,13 +225,13 @@ glm::vec4 AssimpAnimChannel::getRotation(float time) {
 
   switch(mPostState) {
     case 0:
-      if (time > mRotationTiminigs.at(mRotationTiminigs.size() - 1)) {
+      if (time > mRotationTiminigs.back()) {
         return glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
       }
       break;
     case 1:
-      if (time >= mRotationTiminigs.at(mRotationTiminigs.size() - 1)) {
-        glm::quat rotation = mRotations.at(mRotations.size() - 1);
+      if (time >= mRotationTiminigs.back()) {
+        glm::quat rotation = mRotations.back();
         return glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w);
       }
       break;
@@ -194,13 +240,17 @@ glm::vec4 AssimpAnimChannel::getRotation(float time) {
       break;
   }
 
-  auto timeIndexPos = std::lower_bound(mRotationTiminigs.begin(), mRotationTiminigs.end(), time);
-  int timeIndex = std::max(static_cast<int>(std::distance(mRotationTiminigs.begin(), timeIndexPos)) - 1, 0);
+  if (mRotations.size() == 1) {
+    glm::quat rotation = mRotations[0];
+    return glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w);
+  }
+
+  unsigned int timeIndex = findKeyIndex(mRotationTiminigs.data(), static_cast<unsigned int>(mRotationTiminigs.size()), time, cursor);
 
-  float interpolatedTime = (time - mRotationTiminigs.at(timeIndex)) * mInverseRotationTimeDiffs.at(timeIndex);
+  float interpolatedTime = (time - mRotationTiminigs[timeIndex]) * mInverseRotationTimeDiffs[timeIndex];
 
   /* roiations are interpolated via SLERP */
-  glm::quat rotation = glm::normalize(glm::slerp(mRotations.at(timeIndex), mRotations.at(timeIndex + 1), interpolatedTime));
+  glm::quat rotation = glm::normalize(glm::slerp(mRotations[timeIndex], mRotations[timeIndex + 1], interpolatedTime));
 
   /* return order of GLM vec4 */
   return glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w);
@@ -212,4 +262,36 @@ int AssimpAnimChannel::getBoneId() {
 
 void AssimpAnimChannel::setBoneId(unsigned int id) {
   mBoneId = id;
+}
+
+unsigned int AssimpAnimChannel::getPreState() {
+  return mPreState;
+}
+
+unsigned int AssimpAnimChannel::getPostState() {
+  return mPostState;
+}
+
+const std::vector<float>& AssimpAnimChannel::getTranslationTimings() {
+  return mTranslationTiminngs;
+}
+
+const std::vector<glm::vec3>& AssimpAnimChannel::getTranslations() {
+  return mTranslations;
+}
+
+const std::vector<float>& AssimpAnimChannel::getRotationTimings() {
+  return mRotationTiminigs;
+}
+
+const std::vector<glm::quat>& AssimpAnimChannel::getRotations() {
+  return mRotations;
+}
+
+const std::vector<float>& AssimpAnimChannel::getScaleTimings() {
+  return mScaleTimings;
+}
+
+const std::vector<glm::vec3>& AssimpAnimChannel::getScalings() {
+  return mScalings;
 }
\ No newline at end of file
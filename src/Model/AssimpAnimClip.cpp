@@ -1,7 +1,12 @@
+#include <algorithm>
+#include <cmath>
+
 #include "Model/AssimpAnimClip.hpp"
 #include "Tools/Logger.hpp"
 
-void AssimpAnimClip::addChannels(aiAnimation* animation, std::vector<std::shared_ptr<AssimpBone>> boneList) {
+void AssimpAnimClip::addChannels(aiAnimation* animation, const std::vector<std::shared_ptr<AssimpBone>>& boneList,
+    const AnimCompressionSettings& compressionSettings) {
+  mCompressionSettings = compressionSettings;
   mClipName = animation->mName.C_Str();
   mClipDuration = static_cast<float>(animation->mDuration);
   mClipTicksPerSecond = static_cast<float>(animation->mTicksPerSecond);
@@ -16,13 +21,362 @@ void AssimpAnimClip::addChannels(aiAnimation* animation, std::vector<std::shared
 
     std::string targetNodeName = channel->getTargetNodeName();
     const auto bonePos = std::find_if(boneList.begin(), boneList.end(),
-      [targetNodeName](std::shared_ptr<AssimpBone> bone) { return bone->getBoneName() == targetNodeName; } );
+      [&targetNodeName](const std::shared_ptr<AssimpBone>& bone) { return bone->getBoneName() == targetNodeName; } );
     if (bonePos != boneList.end()) {
       channel->setBoneId((*bonePos)->getBoneId());
     }
 
     mAnimChannels.emplace_back(channel);
   }
+
+  createPackedClip();
+}
+
+static float getKeyDistance(const glm::vec3& a, const glm::vec3& b) {
+  return glm::length(a - b);
+}
+
+static float getKeyDistance(const glm::quat& a, const glm::quat& b) {
+  float cosAngle = std::min(std::abs(glm::dot(glm::normalize(a), glm::normalize(b))), 1.0f);
+  return 2.0f * std::acos(cosAngle);
+}
+
+static glm::vec3 interpolateKeys(const glm::vec3& from, const glm::vec3& to, float factor) {
+  return glm::mix(from, to, factor);
+}
+
+static glm::quat interpolateKeys(const glm::quat& from, const glm::quat& to, float factor) {
+  return glm::slerp(from, to, factor);
+}
+
+/* returns the indices of the keys to keep. a key is dropped if the interpolation between
+ * its remaining neighbours is within 'maxError'. a track without any change keeps only its first key,
+ * plus its last key if the sampler needs the end of the track for a post state other than CONSTANT */
+template <typename T>
+static std::vector<unsigned int> reduceKeys(const std::vector<float>& timings, const std::vector<T>& values, float maxError,
+    unsigned int postState, bool& isConstant) {
+  unsigned int numKeys = static_cast<unsigned int>(timings.size());
+  std::vector<unsigned int> keptKeys{};
+  isConstant = false;
+
+  if (numKeys == 0) {
+    return keptKeys;
+  }
+
+  isConstant = true;
+  for (unsigned int i = 1; i < numKeys; ++i) {
+    if (getKeyDistance(values[0], values[i]) > maxError) {
+      isConstant = false;
+      break;
+    }
+  }
+  keptKeys.emplace_back(0);
+  if (isConstant) {
+    if (postState != 1 && numKeys > 1) {
+      keptKeys.emplace_back(numKeys - 1);
+    }
+    return keptKeys;
+  }
+
+  /* greedy: extend every section as far as the keys in between can be reconstructed */
+  unsigned int sectionStart = 0;
+  while (sectionStart < numKeys - 1) {
+    unsigned int sectionEnd = sectionStart + 1;
+    while (sectionEnd + 1 < numKeys) {
+      unsigned int candidate = sectionEnd + 1;
+      float inverseTimeDiff = 1.0f / (timings[candidate] - timings[sectionStart]);
+      bool fits = true;
+      for (unsigned int key = sectionStart + 1; key < candidate && fits; ++key) {
+        float factor = (timings[key] - timings[sectionStart]) * inverseTimeDiff;
+        fits = getKeyDistance(interpolateKeys(values[sectionStart], values[candidate], factor), values[key]) <= maxError;
+      }
+      if (!fits) {
+        break;
+      }
+      sectionEnd = candidate;
+    }
+    keptKeys.emplace_back(sectionEnd);
+    sectionStart = sectionEnd;
+  }
+
+  return keptKeys;
+}
+
+/* copies the kept keys of a single track to the end of the packed track */
+template <typename T>
+static void appendTrack(PackedAnimTrack& track, std::vector<T>& values, const std::vector<float>& timings, const std::vector<T>& channelValues,
+    const std::vector<unsigned int>& keptKeys, bool isConstant) {
+  unsigned int offset = static_cast<unsigned int>(track.timings.size());
+  unsigned int numKeys = static_cast<unsigned int>(keptKeys.size());
+
+  track.keyOffsets.emplace_back(offset);
+  track.keyCounts.emplace_back(numKeys);
+  track.constantChannels.emplace_back(isConstant ? 1 : 0);
+
+  for (unsigned int i = 0; i < numKeys; ++i) {
+    track.timings.emplace_back(timings[keptKeys[i]]);
+    values.emplace_back(channelValues[keptKeys[i]]);
+    if (i + 1 < numKeys) {
+      track.inverseTimeDiffs.emplace_back(1.0f / (timings[keptKeys[i + 1]] - timings[keptKeys[i]]));
+    } else {
+      track.inverseTimeDiffs.emplace_back(0.0f);
+    }
+  }
+}
+
+/* keeps all keys if the compression is disabled */
+template <typename T>
+static void appendTrack(PackedAnimTrack& track, std::vector<T>& values, const std::vector<float>& timings, const std::vector<T>& channelValues,
+    bool compress, float maxError, unsigned int postState, AnimCompressionStats& stats) {
+  bool isConstant = false;
+  std::vector<unsigned int> keptKeys{};
+  if (compress) {
+    keptKeys = reduceKeys(timings, channelValues, maxError, postState, isConstant);
+  } else {
+    for (unsigned int i = 0; i < timings.size(); ++i) {
+      keptKeys.emplace_back(i);
+    }
+  }
+
+  /* a single key is constant anyway, only count the tracks we collapsed */
+  if (isConstant && timings.size() > 1) {
+    ++stats.constantTracks;
+  }
+  stats.rawKeys += static_cast<unsigned int>(timings.size());
+  stats.packedKeys += static_cast<unsigned int>(keptKeys.size());
+
+  appendTrack(track, values, timings, channelValues, keptKeys, isConstant);
+}
+
+/* value of a track between its first and its last key, the sampler handles the pre and post states */
+template <typename T>
+static T sampleTrack(const std::vector<float>& timings, const std::vector<T>& values, float time) {
+  if (time <= timings.front()) {
+    return values.front();
+  }
+  if (time >= timings.back()) {
+    return values.back();
+  }
+  size_t key = std::upper_bound(timings.begin(), timings.end(), time) - timings.begin() - 1;
+  return interpolateKeys(values[key], values[key + 1], (time - timings[key]) / (timings[key + 1] - timings[key]));
+}
+
+/* appends 'numFrames' keys of the track at a fixed rate, or a single key if the track does not change */
+template <typename T>
+static void appendResampledTrack(PackedAnimTrack& track, std::vector<T>& values, const std::vector<float>& timings, const std::vector<T>& channelValues,
+    unsigned int numFrames, float framesPerTick, float maxConstantError, AnimCompressionStats& stats) {
+  track.keyOffsets.emplace_back(static_cast<unsigned int>(values.size()));
+  stats.rawKeys += static_cast<unsigned int>(timings.size());
+
+  if (timings.empty()) {
+    track.keyCounts.emplace_back(0);
+    track.constantChannels.emplace_back(0);
+    track.keyRanges.emplace_back(0.0f, 0.0f);
+    return;
+  }
+  track.keyRanges.emplace_back(timings.front(), timings.back());
+
+  bool isConstant = true;
+  for (unsigned int i = 1; i < timings.size() && isConstant; ++i) {
+    isConstant = getKeyDistance(channelValues[0], channelValues[i]) <= maxConstantError;
+  }
+  if (isConstant) {
+    if (timings.size() > 1) {
+      ++stats.constantTracks;
+    }
+    ++stats.packedKeys;
+    track.keyCounts.emplace_back(1);
+    track.constantChannels.emplace_back(1);
+    values.emplace_back(channelValues[0]);
+    return;
+  }
+
+  stats.packedKeys += numFrames;
+  track.keyCounts.emplace_back(numFrames);
+  track.constantChannels.emplace_back(0);
+  for (unsigned int frame = 0; frame < numFrames; ++frame) {
+    values.emplace_back(sampleTrack(timings, channelValues, static_cast<float>(frame) / framesPerTick));
+  }
+}
+
+void AssimpAnimClip::createPackedClip() {
+  mPackedClip = PackedAnimClip{};
+  mPackedClip.numChannels = static_cast<unsigned int>(mAnimChannels.size());
+  mCompressionStats = AnimCompressionStats{};
+
+  bool compress = mCompressionSettings.enabled;
+  for (const auto& channel : mAnimChannels) {
+    mPackedClip.boneIds.emplace_back(channel->getBoneId());
+    mPackedClip.preStates.emplace_back(channel->getPreState());
+    mPackedClip.postStates.emplace_back(channel->getPostState());
+  }
+
+  if (mCompressionSettings.resample) {
+    resamplePackedClip();
+  } else {
+    for (const auto& channel : mAnimChannels) {
+      appendTrack(mPackedClip.translationTrack, mPackedClip.translations, channel->getTranslationTimings(), channel->getTranslations(),
+        compress, mCompressionSettings.translationError, channel->getPostState(), mCompressionStats);
+      appendTrack(mPackedClip.rotationTrack, mPackedClip.rotations, channel->getRotationTimings(), channel->getRotations(),
+        compress, mCompressionSettings.rotationError, channel->getPostState(), mCompressionStats);
+      appendTrack(mPackedClip.scaleTrack, mPackedClip.scalings, channel->getScaleTimings(), channel->getScalings(),
+        compress, mCompressionSettings.scaleError, channel->getPostState(), mCompressionStats);
+    }
+  }
+
+  size_t rawValueSize = 0;
+  for (const auto& channel : mAnimChannels) {
+    rawValueSize += channel->getTranslations().size() * sizeof(glm::vec3) + channel->getRotations().size() * sizeof(glm::quat) +
+      channel->getScalings().size() * sizeof(glm::vec3);
+  }
+  size_t packedValueSize = mPackedClip.translations.size() * sizeof(glm::vec3) + mPackedClip.rotations.size() * sizeof(glm::quat) +
+    mPackedClip.scalings.size() * sizeof(glm::vec3);
+
+  if (compress && mCompressionSettings.quantize) {
+    quantizePackedClip();
+  }
+
+  mPackedClip.maxNlerpError = measureNlerpError();
+
+  /* timings and inverse time differences are two floats per key */
+  size_t keyTimingSize = 2 * sizeof(float);
+  size_t packedTimingSize = 0;
+  for (const PackedAnimTrack* track : { &mPackedClip.translationTrack, &mPackedClip.rotationTrack, &mPackedClip.scaleTrack }) {
+    packedTimingSize += (track->timings.size() + track->inverseTimeDiffs.size()) * sizeof(float) + track->keyRanges.size() * sizeof(glm::vec2);
+  }
+  mCompressionStats.rawSize = mCompressionStats.rawKeys * keyTimingSize + rawValueSize;
+  mCompressionStats.packedSize = packedTimingSize + mPackedClip.numChannels * 3 * sizeof(unsigned char) +
+    mPackedClip.translations.size() * sizeof(glm::vec3) + mPackedClip.rotations.size() * sizeof(glm::quat) + mPackedClip.scalings.size() * sizeof(glm::vec3) +
+    (mPackedClip.translationMins.size() + mPackedClip.translationScales.size()) * sizeof(glm::vec3) +
+    (mPackedClip.quantizedTranslations.size() + mPackedClip.quantizedRotations.size()) * sizeof(uint16_t);
+
+  /* the resampled keys are compared before the quantization, the quantization saves the same share either way */
+  if (mPackedClip.uniform) {
+    mCompressionStats.resampleGrowth = packedValueSize > rawValueSize ? packedValueSize - rawValueSize : 0;
+    size_t rawTimingSize = mCompressionStats.rawKeys * keyTimingSize;
+    mCompressionStats.resampleSavings = rawTimingSize > packedTimingSize ? rawTimingSize - packedTimingSize : 0;
+  }
+
+  Logger::log(1, "%s: clip '%s' packed into %i bytes (%i channels, %i of %i keys, %i constant tracks, %i bytes uncompressed), max NLERP error %f degrees\n",
+    __FUNCTION__, mClipName.c_str(), mCompressionStats.packedSize, mPackedClip.numChannels, mCompressionStats.packedKeys, mCompressionStats.rawKeys,
+    mCompressionStats.constantTracks, mCompressionStats.rawSize, glm::degrees(mPackedClip.maxNlerpError));
+  if (mPackedClip.uniform) {
+    Logger::log(1, "%s: clip '%s' resampled to %i frames, %i bytes of key values added, %i bytes of key timings removed\n", __FUNCTION__,
+      mClipName.c_str(), mPackedClip.numFrames, mCompressionStats.resampleGrowth, mCompressionStats.resampleSavings);
+  }
+}
+
+void AssimpAnimClip::resamplePackedClip() {
+  float ticksPerSecond = mClipTicksPerSecond > 0.0f ? mClipTicksPerSecond : 1.0f;
+  mPackedClip.uniform = true;
+  mPackedClip.framesPerTick = std::max(mCompressionSettings.resampleRate, 1.0f) / ticksPerSecond;
+  /* the last frame is at or behind the end of the clip */
+  mPackedClip.numFrames = std::max(static_cast<unsigned int>(std::ceil(mClipDuration * mPackedClip.framesPerTick)) + 1, 2u);
+
+  /* without the key reduction, only tracks without any change are collapsed */
+  bool compress = mCompressionSettings.enabled;
+  for (const auto& channel : mAnimChannels) {
+    appendResampledTrack(mPackedClip.translationTrack, mPackedClip.translations, channel->getTranslationTimings(), channel->getTranslations(),
+      mPackedClip.numFrames, mPackedClip.framesPerTick, compress ? mCompressionSettings.translationError : 0.0f, mCompressionStats);
+    appendResampledTrack(mPackedClip.rotationTrack, mPackedClip.rotations, channel->getRotationTimings(), channel->getRotations(),
+      mPackedClip.numFrames, mPackedClip.framesPerTick, compress ? mCompressionSettings.rotationError : 0.0f, mCompressionStats);
+    appendResampledTrack(mPackedClip.scaleTrack, mPackedClip.scalings, channel->getScaleTimings(), channel->getScalings(),
+      mPackedClip.numFrames, mPackedClip.framesPerTick, compress ? mCompressionSettings.scaleError : 0.0f, mCompressionStats);
+  }
+}
+
+void AssimpAnimClip::quantizePackedClip() {
+  /* translations: 16 bit per component, in the value range of the channel */
+  const PackedAnimTrack& translationTrack = mPackedClip.translationTrack;
+  for (unsigned int channel = 0; channel < mPackedClip.numChannels; ++channel) {
+    unsigned int firstKey = translationTrack.keyOffsets.at(channel);
+    unsigned int lastKey = firstKey + translationTrack.keyCounts.at(channel);
+
+    glm::vec3 minValue = glm::vec3(0.0f);
+    glm::vec3 maxValue = glm::vec3(0.0f);
+    if (lastKey > firstKey) {
+      minValue = mPackedClip.translations.at(firstKey);
+      maxValue = minValue;
+    }
+    for (unsigned int key = firstKey; key < lastKey; ++key) {
+      minValue = glm::min(minValue, mPackedClip.translations.at(key));
+      maxValue = glm::max(maxValue, mPackedClip.translations.at(key));
+    }
+    glm::vec3 scale = (maxValue - minValue) / 65535.0f;
+
+    mPackedClip.translationMins.emplace_back(minValue);
+    mPackedClip.translationScales.emplace_back(scale);
+
+    for (unsigned int key = firstKey; key < lastKey; ++key) {
+      for (int c = 0; c < 3; ++c) {
+        float value = scale[c] > 0.0f ? (mPackedClip.translations.at(key)[c] - minValue[c]) / scale[c] : 0.0f;
+        mPackedClip.quantizedTranslations.emplace_back(static_cast<uint16_t>(std::clamp(std::round(value), 0.0f, 65535.0f)));
+      }
+    }
+  }
+
+  /* rotations: drop the largest component, it can be restored from the unit length.
+   * the other three are in [-1/sqrt(2), 1/sqrt(2)] and get 15 bits each */
+  for (const auto& rotation : mPackedClip.rotations) {
+    glm::quat normalizedRotation = glm::normalize(rotation);
+    float components[4] = { normalizedRotation.x, normalizedRotation.y, normalizedRotation.z, normalizedRotation.w };
+
+    unsigned int largest = 0;
+    for (unsigned int i = 1; i < 4; ++i) {
+      if (std::abs(components[i]) > std::abs(components[largest])) {
+        largest = i;
+      }
+    }
+    /* q and -q are the same rotation, the dropped component is always positive */
+    float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+
+    uint16_t values[3];
+    unsigned int index = 0;
+    for (unsigned int i = 0; i < 4; ++i) {
+      if (i == largest) {
+        continue;
+      }
+      float value = (sign * components[i] / 1.41421356f + 0.5f) * 32767.0f;
+      values[index++] = static_cast<uint16_t>(std::clamp(std::round(value), 0.0f, 32767.0f));
+    }
+    values[0] |= static_cast<uint16_t>((largest >> 1) << 15);
+    values[1] |= static_cast<uint16_t>((largest & 1) << 15);
+
+    mPackedClip.quantizedRotations.insert(mPackedClip.quantizedRotations.end(), values, values + 3);
+  }
+
+  mPackedClip.quantized = true;
+  std::vector<glm::vec3>().swap(mPackedClip.translations);
+  std::vector<glm::quat>().swap(mPackedClip.rotations);
+}
+
+float AssimpAnimClip::measureNlerpError() {
+  /* the error is zero at the keys, sample the sections in between */
+  const int numSteps = 16;
+  float maxError = 0.0f;
+
+  const PackedAnimTrack& track = mPackedClip.rotationTrack;
+  for (unsigned int channel = 0; channel < mPackedClip.numChannels; ++channel) {
+    unsigned int firstKey = track.keyOffsets.at(channel);
+    for (unsigned int key = firstKey; key + 1 < firstKey + track.keyCounts.at(channel); ++key) {
+      glm::quat from = mPackedClip.getRotation(key);
+      glm::quat to = mPackedClip.getRotation(key + 1);
+      if (glm::dot(from, to) < 0.0f) {
+        to = -to;
+      }
+
+      for (int step = 1; step < numSteps; ++step) {
+        float factor = static_cast<float>(step) / static_cast<float>(numSteps);
+        glm::quat slerpRotation = glm::normalize(glm::slerp(from, to, factor));
+        glm::quat nlerpRotation = glm::normalize(from + (to - from) * factor);
+
+        float cosAngle = std::min(std::abs(glm::dot(slerpRotation, nlerpRotation)), 1.0f);
+        maxError = std::max(maxError, 2.0f * std::acos(cosAngle));
+      }
+    }
+  }
+
+  return maxError;
 }
 
 std::string AssimpAnimClip::getClipName() {
@@ -37,6 +391,23 @@ const std::vector<std::shared_ptr<AssimpAnimChannel>>& AssimpAnimClip::getChanne
   return mAnimChannels;
 }
 
+const PackedAnimClip& AssimpAnimClip::getPackedClip() {
+  return mPackedClip;
+}
+
+void AssimpAnimClip::compress(const AnimCompressionSettings& compressionSettings) {
+  mCompressionSettings = compressionSettings;
+  createPackedClip();
+}
+
+const AnimCompressionSettings& AssimpAnimClip::getCompressionSettings() {
+  return mCompressionSettings;
+}
+
+const AnimCompressionStats& AssimpAnimClip::getCompressionStats() {
+  return mCompressionStats;
+}
+
 float AssimpAnimClip::getClipDuration() {
   return mClipDuration;
 }
@@ -0,0 +1,346 @@
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+#include "Model/AssimpAnimKernels.hpp"
+#include "Tools/Logger.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ANIM_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+/* MSVC allows all intrinsics without extra compiler flags */
+#define ANIM_TARGET_AVX2
+#else
+#define ANIM_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+simdLevel AssimpAnimKernels::mSimdLevel = AssimpAnimKernels::getSupportedSimdLevel();
+
+static simdLevel detectSimdLevel() {
+#if defined(ANIM_KERNELS_X86)
+#if defined(_MSC_VER)
+  int cpuInfo[4] = { 0 };
+  __cpuid(cpuInfo, 0);
+  int maxLeaf = cpuInfo[0];
+
+  __cpuid(cpuInfo, 1);
+  bool hasSse2 = (cpuInfo[3] & (1 << 26)) != 0;
+  bool hasOsxSave = (cpuInfo[2] & (1 << 27)) != 0;
+  bool hasAvx = (cpuInfo[2] & (1 << 28)) != 0;
+
+  bool hasAvx2 = false;
+  if (maxLeaf >= 7 && hasAvx && hasOsxSave) {
+    /* the OS must save the YMM registers on context switches */
+    bool osSavesYmm = (_xgetbv(0) & 0x6) == 0x6;
+    __cpuidex(cpuInfo, 7, 0);
+    hasAvx2 = osSavesYmm && (cpuInfo[1] & (1 << 5)) != 0;
+  }
+#else
+  __builtin_cpu_init();
+  bool hasSse2 = __builtin_cpu_supports("sse2");
+  bool hasAvx2 = __builtin_cpu_supports("avx2");
+#endif
+  if (hasAvx2) {
+    return simdLevel::avx2;
+  }
+  if (hasSse2) {
+    return simdLevel::sse;
+  }
+#endif
+  return simdLevel::scalar;
+}
+
+simdLevel AssimpAnimKernels::getSupportedSimdLevel() {
+  static const simdLevel supportedLevel = detectSimdLevel();
+  return supportedLevel;
+}
+
+simdLevel AssimpAnimKernels::getSimdLevel() {
+  return mSimdLevel;
+}
+
+void AssimpAnimKernels::setSimdLevel(simdLevel level) {
+  if (static_cast<int>(level) > static_cast<int>(getSupportedSimdLevel())) {
+    Logger::log(1, "%s warning: %s not supported, using %s\n", __FUNCTION__, getSimdLevelName(level), getSimdLevelName(getSupportedSimdLevel()));
+    level = getSupportedSimdLevel();
+  }
+  mSimdLevel = level;
+}
+
+const char* AssimpAnimKernels::getSimdLevelName(simdLevel level) {
+  switch (level) {
+    case simdLevel::sse:
+      return "SSE";
+    case simdLevel::avx2:
+      return "AVX2";
+    default:
+      return "Scalar";
+  }
+}
+
+/* scalar versions, also used for the lanes that do not fill a full SIMD register */
+static void lerpVec3Scalar(AnimInterpolationBatch& batch, unsigned int start) {
+  for (unsigned int i = start; i < batch.numLanes; ++i) {
+    glm::vec3 from = glm::vec3(batch.from[0][i], batch.from[1][i], batch.from[2][i]);
+    glm::vec3 to = glm::vec3(batch.to[0][i], batch.to[1][i], batch.to[2][i]);
+    glm::vec3 result = glm::mix(from, to, batch.factor[i]);
+    batch.result[0][i] = result.x;
+    batch.result[1][i] = result.y;
+    batch.result[2][i] = result.z;
+  }
+}
+
+static void interpolateQuatScalar(AnimInterpolationBatch& batch, unsigned int start, bool useNlerp) {
+  for (unsigned int i = start; i < batch.numLanes; ++i) {
+    glm::quat from = glm::quat(batch.from[3][i], batch.from[0][i], batch.from[1][i], batch.from[2][i]);
+    glm::quat to = glm::quat(batch.to[3][i], batch.to[0][i], batch.to[1][i], batch.to[2][i]);
+
+    glm::quat result;
+    if (useNlerp) {
+      /* take the short path */
+      if (glm::dot(from, to) < 0.0f) {
+        to = -to;
+      }
+      result = glm::normalize(from + (to - from) * batch.factor[i]);
+    } else {
+      result = glm::normalize(glm::slerp(from, to, batch.factor[i]));
+    }
+
+    batch.result[0][i] = result.x;
+    batch.result[1][i] = result.y;
+    batch.result[2][i] = result.z;
+    batch.result[3][i] = result.w;
+  }
+}
+
+#if defined(ANIM_KERNELS_X86)
+/* Abramowitz/Stegun 4.4.46, acos(x) for 0 <= x <= 1, error below 2e-8 */
+static const float acosCoeffs[8] = { 1.5707963050f, -0.2145988016f, 0.0889789874f, -0.0501743046f,
+  0.0308918810f, -0.0170881256f, 0.0066700901f, -0.0012624911f };
+
+/* Taylor series of sin(x) up to x^11, error below 6e-8 for 0 <= x <= pi/2 */
+static const float sinCoeffs[6] = { 1.0f, -1.0f / 6.0f, 1.0f / 120.0f, -1.0f / 5040.0f, 1.0f / 362880.0f, -1.0f / 39916800.0f };
+
+static inline __m128 acosSse(__m128 x) {
+  __m128 poly = _mm_set1_ps(acosCoeffs[7]);
+  for (int i = 6; i >= 0; --i) {
+    poly = _mm_add_ps(_mm_mul_ps(poly, x), _mm_set1_ps(acosCoeffs[i]));
+  }
+  return _mm_mul_ps(poly, _mm_sqrt_ps(_mm_sub_ps(_mm_set1_ps(1.0f), x)));
+}
+
+static inline __m128 sinSse(__m128 x) {
+  __m128 x2 = _mm_mul_ps(x, x);
+  __m128 poly = _mm_set1_ps(sinCoeffs[5]);
+  for (int i = 4; i >= 0; --i) {
+    poly = _mm_add_ps(_mm_mul_ps(poly, x2), _mm_set1_ps(sinCoeffs[i]));
+  }
+  return _mm_mul_ps(poly, x);
+}
+
+static void lerpVec3Sse(AnimInterpolationBatch& batch) {
+  unsigned int simdLanes = batch.numLanes & ~3u;
+  for (unsigned int i = 0; i < simdLanes; i += 4) {
+    __m128 factor = _mm_load_ps(&batch.factor[i]);
+    for (int c = 0; c < 3; ++c) {
+      __m128 from = _mm_load_ps(&batch.from[c][i]);
+      __m128 to = _mm_load_ps(&batch.to[c][i]);
+      _mm_store_ps(&batch.result[c][i], _mm_add_ps(from, _mm_mul_ps(_mm_sub_ps(to, from), factor)));
+    }
+  }
+  lerpVec3Scalar(batch, simdLanes);
+}
+
+static void interpolateQuatSse(AnimInterpolationBatch& batch, bool useNlerp) {
+  const __m128 signMask = _mm_set1_ps(-0.0f);
+  const __m128 one = _mm_set1_ps(1.0f);
+
+  unsigned int simdLanes = batch.numLanes & ~3u;
+  for (unsigned int i = 0; i < simdLanes; i += 4) {
+    __m128 factor = _mm_load_ps(&batch.factor[i]);
+    __m128 from[4];
+    __m128 to[4];
+    for (int c = 0; c < 4; ++c) {
+      from[c] = _mm_load_ps(&batch.from[c][i]);
+      to[c] = _mm_load_ps(&batch.to[c][i]);
+    }
+
+    __m128 cosTheta = _mm_add_ps(_mm_add_ps(_mm_mul_ps(from[0], to[0]), _mm_mul_ps(from[1], to[1])),
+      _mm_add_ps(_mm_mul_ps(from[2], to[2]), _mm_mul_ps(from[3], to[3])));
+
+    /* take the short path: flip 'to' if the dot product is negative */
+    __m128 dotSign = _mm_and_ps(cosTheta, signMask);
+    for (int c = 0; c < 4; ++c) {
+      to[c] = _mm_xor_ps(to[c], dotSign);
+    }
+    cosTheta = _mm_xor_ps(cosTheta, dotSign);
+
+    __m128 fromScale;
+    __m128 toScale;
+    if (useNlerp) {
+      fromScale = _mm_sub_ps(one, factor);
+      toScale = factor;
+    } else {
+      __m128 angle = acosSse(_mm_min_ps(cosTheta, one));
+      __m128 inverseSinAngle = _mm_div_ps(one, sinSse(angle));
+      __m128 slerpFromScale = _mm_mul_ps(sinSse(_mm_mul_ps(_mm_sub_ps(one, factor), angle)), inverseSinAngle);
+      __m128 slerpToScale = _mm_mul_ps(sinSse(_mm_mul_ps(factor, angle)), inverseSinAngle);
+
+      /* linear interpolation for (almost) equal rotations, like glm::slerp */
+      __m128 useLerp = _mm_cmpgt_ps(cosTheta, _mm_set1_ps(1.0f - 1.1920929e-07f));
+      fromScale = _mm_or_ps(_mm_and_ps(useLerp, _mm_sub_ps(one, factor)), _mm_andnot_ps(useLerp, slerpFromScale));
+      toScale = _mm_or_ps(_mm_and_ps(useLerp, factor), _mm_andnot_ps(useLerp, slerpToScale));
+    }
+
+    __m128 result[4];
+    for (int c = 0; c < 4; ++c) {
+      result[c] = _mm_add_ps(_mm_mul_ps(from[c], fromScale), _mm_mul_ps(to[c], toScale));
+    }
+
+    __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(result[0], result[0]), _mm_mul_ps(result[1], result[1])),
+      _mm_add_ps(_mm_mul_ps(result[2], result[2]), _mm_mul_ps(result[3], result[3]))));
+    __m128 inverseLength = _mm_div_ps(one, length);
+    for (int c = 0; c < 4; ++c) {
+      _mm_store_ps(&batch.result[c][i], _mm_mul_ps(result[c], inverseLength));
+    }
+  }
+  interpolateQuatScalar(batch, simdLanes, useNlerp);
+}
+
+ANIM_TARGET_AVX2 static inline __m256 acosAvx2(__m256 x) {
+  __m256 poly = _mm256_set1_ps(acosCoeffs[7]);
+  for (int i = 6; i >= 0; --i) {
+    poly = _mm256_add_ps(_mm256_mul_ps(poly, x), _mm256_set1_ps(acosCoeffs[i]));
+  }
+  return _mm256_mul_ps(poly, _mm256_sqrt_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), x)));
+}
+
+ANIM_TARGET_AVX2 static inline __m256 sinAvx2(__m256 x) {
+  __m256 x2 = _mm256_mul_ps(x, x);
+  __m256 poly = _mm256_set1_ps(sinCoeffs[5]);
+  for (int i = 4; i >= 0; --i) {
+    poly = _mm256_add_ps(_mm256_mul_ps(poly, x2), _mm256_set1_ps(sinCoeffs[i]));
+  }
+  return _mm256_mul_ps(poly, x);
+}
+
+ANIM_TARGET_AVX2 static void lerpVec3Avx2(AnimInterpolationBatch& batch) {
+  unsigned int simdLanes = batch.numLanes & ~7u;
+  for (unsigned int i = 0; i < simdLanes; i += 8) {
+    __m256 factor = _mm256_load_ps(&batch.factor[i]);
+    for (int c = 0; c < 3; ++c) {
+      __m256 from = _mm256_load_ps(&batch.from[c][i]);
+      __m256 to = _mm256_load_ps(&batch.to[c][i]);
+      _mm256_store_ps(&batch.result[c][i], _mm256_add_ps(from, _mm256_mul_ps(_mm256_sub_ps(to, from), factor)));
+    }
+  }
+  lerpVec3Scalar(batch, simdLanes);
+}
+
+ANIM_TARGET_AVX2 static void interpolateQuatAvx2(AnimInterpolationBatch& batch, bool useNlerp) {
+  const __m256 signMask = _mm256_set1_ps(-0.0f);
+  const __m256 one = _mm256_set1_ps(1.0f);
+
+  unsigned int simdLanes = batch.numLanes & ~7u;
+  for (unsigned int i = 0; i < simdLanes; i += 8) {
+    __m256 factor = _mm256_load_ps(&batch.factor[i]);
+    __m256 from[4];
+    __m256 to[4];
+    for (int c = 0; c < 4; ++c) {
+      from[c] = _mm256_load_ps(&batch.from[c][i]);
+      to[c] = _mm256_load_ps(&batch.to[c][i]);
+    }
+
+    __m256 cosTheta = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(from[0], to[0]), _mm256_mul_ps(from[1], to[1])),
+      _mm256_add_ps(_mm256_mul_ps(from[2], to[2]), _mm256_mul_ps(from[3], to[3])));
+
+    __m256 dotSign = _mm256_and_ps(cosTheta, signMask);
+    for (int c = 0; c < 4; ++c) {
+      to[c] = _mm256_xor_ps(to[c], dotSign);
+    }
+    cosTheta = _mm256_xor_ps(cosTheta, dotSign);
+
+    __m256 fromScale;
+    __m256 toScale;
+    if (useNlerp) {
+      fromScale = _mm256_sub_ps(one, factor);
+      toScale = factor;
+    } else {
+      __m256 angle = acosAvx2(_mm256_min_ps(cosTheta, one));
+      __m256 inverseSinAngle = _mm256_div_ps(one, sinAvx2(angle));
+      __m256 slerpFromScale = _mm256_mul_ps(sinAvx2(_mm256_mul_ps(_mm256_sub_ps(one, factor), angle)), inverseSinAngle);
+      __m256 slerpToScale = _mm256_mul_ps(sinAvx2(_mm256_mul_ps(factor, angle)), inverseSinAngle);
+
+      __m256 useLerp = _mm256_cmp_ps(cosTheta, _mm256_set1_ps(1.0f - 1.1920929e-07f), _CMP_GT_OQ);
+      fromScale = _mm256_blendv_ps(slerpFromScale, _mm256_sub_ps(one, factor), useLerp);
+      toScale = _mm256_blendv_ps(slerpToScale, factor, useLerp);
+    }
+
+    __m256 result[4];
+    for (int c = 0; c < 4; ++c) {
+      result[c] = _mm256_add_ps(_mm256_mul_ps(from[c], fromScale), _mm256_mul_ps(to[c], toScale));
+    }
+
+    __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(result[0], result[0]), _mm256_mul_ps(result[1], result[1])),
+      _mm256_add_ps(_mm256_mul_ps(result[2], result[2]), _mm256_mul_ps(result[3], result[3]))));
+    __m256 inverseLength = _mm256_div_ps(one, length);
+    for (int c = 0; c < 4; ++c) {
+      _mm256_store_ps(&batch.result[c][i], _mm256_mul_ps(result[c], inverseLength));
+    }
+  }
+  interpolateQuatScalar(batch, simdLanes, useNlerp);
+}
+#endif
+
+void AssimpAnimKernels::lerpVec3(AnimInterpolationBatch& batch) {
+  switch (mSimdLevel) {
+#if defined(ANIM_KERNELS_X86)
+    case simdLevel::avx2:
+      lerpVec3Avx2(batch);
+      break;
+    case simdLevel::sse:
+      lerpVec3Sse(batch);
+      break;
+#endif
+    default:
+      lerpVec3Scalar(batch, 0);
+      break;
+  }
+}
+
+void AssimpAnimKernels::slerpQuat(AnimInterpolationBatch& batch) {
+  switch (mSimdLevel) {
+#if defined(ANIM_KERNELS_X86)
+    case simdLevel::avx2:
+      interpolateQuatAvx2(batch, false);
+      break;
+    case simdLevel::sse:
+      interpolateQuatSse(batch, false);
+      break;
+#endif
+    default:
+      interpolateQuatScalar(batch, 0, false);
+      break;
+  }
+}
+
+void AssimpAnimKernels::nlerpQuat(AnimInterpolationBatch& batch) {
+  switch (mSimdLevel) {
+#if defined(ANIM_KERNELS_X86)
+    case simdLevel::avx2:
+      interpolateQuatAvx2(batch, true);
+      break;
+    case simdLevel::sse:
+      interpolateQuatSse(batch, true);
+      break;
+#endif
+    default:
+      interpolateQuatScalar(batch, 0, true);
+      break;
+  }
+}
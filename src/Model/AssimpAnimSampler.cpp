@@ -0,0 +1,255 @@
+#include <algorithm>
+#include <limits>
+
+#include "Model/AssimpAnimSampler.hpp"
+#include "Model/AssimpAnimKernels.hpp"
+
+enum class trackSampleType {
+  emptyTrack = 0,
+  defaultValue,
+  keyValue,
+  interpolate
+};
+
+struct TrackSample {
+  trackSampleType type = trackSampleType::emptyTrack;
+  /* index into the packed value array */
+  unsigned int key = 0;
+  float factor = 0.0f;
+};
+
+/* same pre and post state handling as in AssimpAnimChannel */
+static TrackSample findTrackSample(const PackedAnimTrack& track, unsigned int channel, float time,
+    unsigned int preState, unsigned int postState, unsigned int& cursor) {
+  unsigned int numKeys = track.keyCounts[channel];
+  if (numKeys == 0) {
+    return { trackSampleType::emptyTrack };
+  }
+
+  unsigned int firstKey = track.keyOffsets[channel];
+  unsigned int lastKey = firstKey + numKeys - 1;
+
+  switch (preState) {
+    case 0:
+      if (time < track.timings[firstKey]) {
+        return { trackSampleType::defaultValue };
+      }
+      break;
+    case 1:
+      if (time < track.timings[firstKey]) {
+        return { trackSampleType::keyValue, firstKey };
+      }
+      break;
+    default:
+      break;
+  }
+
+  switch (postState) {
+    case 0:
+      if (time > track.timings[lastKey]) {
+        return { trackSampleType::defaultValue };
+      }
+      break;
+    case 1:
+      if (time >= track.timings[lastKey]) {
+        return { trackSampleType::keyValue, lastKey };
+      }
+      break;
+    default:
+      break;
+  }
+
+  /* collapsed tracks have the same value between their first and their last key */
+  if (numKeys == 1 || track.constantChannels[channel]) {
+    return { trackSampleType::keyValue, firstKey };
+  }
+
+  unsigned int key = firstKey + AssimpAnimChannel::findKeyIndex(&track.timings[firstKey], numKeys, time, cursor);
+  return { trackSampleType::interpolate, key, (time - track.timings[key]) * track.inverseTimeDiffs[key] };
+}
+
+/* resampled clips, the key and the factor are the same for all tracks of the clip and come from the frame position */
+static TrackSample findUniformTrackSample(const PackedAnimTrack& track, unsigned int channel, float time,
+    unsigned int preState, unsigned int postState, unsigned int frameKey, float frameFactor) {
+  unsigned int numKeys = track.keyCounts[channel];
+  if (numKeys == 0) {
+    return { trackSampleType::emptyTrack };
+  }
+
+  unsigned int firstKey = track.keyOffsets[channel];
+
+  /* the constant pre and post states are part of the resampled keys */
+  const glm::vec2& keyRange = track.keyRanges[channel];
+  if ((preState == 0 && time < keyRange.x) || (postState == 0 && time > keyRange.y)) {
+    return { trackSampleType::defaultValue };
+  }
+
+  if (track.constantChannels[channel]) {
+    return { trackSampleType::keyValue, firstKey };
+  }
+
+  return { trackSampleType::interpolate, firstKey + frameKey, frameFactor };
+}
+
+/* runs the kernel and writes the results to the lane targets */
+static void flushVec3Batch(AnimInterpolationBatch& batch, glm::vec4** targets) {
+  if (batch.numLanes == 0) {
+    return;
+  }
+  AssimpAnimKernels::lerpVec3(batch);
+  for (unsigned int lane = 0; lane < batch.numLanes; ++lane) {
+    *targets[lane] = glm::vec4(batch.result[0][lane], batch.result[1][lane], batch.result[2][lane], 1.0f);
+  }
+  batch.numLanes = 0;
+}
+
+static void flushQuatBatch(AnimInterpolationBatch& batch, glm::vec4** targets, bool useNlerp) {
+  if (batch.numLanes == 0) {
+    return;
+  }
+  if (useNlerp) {
+    AssimpAnimKernels::nlerpQuat(batch);
+  } else {
+    AssimpAnimKernels::slerpQuat(batch);
+  }
+  for (unsigned int lane = 0; lane < batch.numLanes; ++lane) {
+    *targets[lane] = glm::vec4(batch.result[0][lane], batch.result[1][lane], batch.result[2][lane], batch.result[3][lane]);
+  }
+  batch.numLanes = 0;
+}
+
+static void addVec3Lane(AnimInterpolationBatch& batch, glm::vec4** targets, glm::vec4* target, const glm::vec3& from, const glm::vec3& to, float factor) {
+  unsigned int lane = batch.numLanes++;
+  for (int c = 0; c < 3; ++c) {
+    batch.from[c][lane] = from[c];
+    batch.to[c][lane] = to[c];
+  }
+  batch.factor[lane] = factor;
+  targets[lane] = target;
+
+  if (batch.numLanes == AnimInterpolationBatch::maxLanes) {
+    flushVec3Batch(batch, targets);
+  }
+}
+
+static void addQuatLane(AnimInterpolationBatch& batch, glm::vec4** targets, glm::vec4* target, const glm::quat& from, const glm::quat& to, float factor, bool useNlerp) {
+  unsigned int lane = batch.numLanes++;
+  batch.from[0][lane] = from.x;
+  batch.from[1][lane] = from.y;
+  batch.from[2][lane] = from.z;
+  batch.from[3][lane] = from.w;
+  batch.to[0][lane] = to.x;
+  batch.to[1][lane] = to.y;
+  batch.to[2][lane] = to.z;
+  batch.to[3][lane] = to.w;
+  batch.factor[lane] = factor;
+  targets[lane] = target;
+
+  if (batch.numLanes == AnimInterpolationBatch::maxLanes) {
+    flushQuatBatch(batch, targets, useNlerp);
+  }
+}
+
+void AssimpAnimSampler::sampleClip(const std::shared_ptr<AssimpAnimClip>& clip, const float* times, size_t numInstances, size_t numBones,
+    NodeTransformData* out, AnimChannelCursor* const* cursors, bool useNlerp) {
+  const PackedAnimClip& packedClip = clip->getPackedClip();
+
+  /* nodes without a channel keep the default transform */
+  std::fill(out, out + numInstances * numBones, NodeTransformData{});
+
+  const unsigned int invalidKey = std::numeric_limits<unsigned int>::max();
+
+  /* key search is done per instance, the interpolations are collected and done in SIMD batches */
+  AnimInterpolationBatch translationBatch;
+  AnimInterpolationBatch rotationBatch;
+  AnimInterpolationBatch scaleBatch;
+  glm::vec4* translationTargets[AnimInterpolationBatch::maxLanes];
+  glm::vec4* rotationTargets[AnimInterpolationBatch::maxLanes];
+  glm::vec4* scaleTargets[AnimInterpolationBatch::maxLanes];
+
+  for (unsigned int channel = 0; channel < packedClip.numChannels; ++channel) {
+    int boneId = packedClip.boneIds[channel];
+    if (boneId < 0 || static_cast<size_t>(boneId) >= numBones) {
+      continue;
+    }
+
+    unsigned int preState = packedClip.preStates[channel];
+    unsigned int postState = packedClip.postStates[channel];
+
+    for (size_t i = 0; i < numInstances; ++i) {
+      float time = times[i];
+      NodeTransformData& nodeTransform = out[i * numBones + boneId];
+
+      /* without cursors, every lookup is a binary search. resampled clips need neither */
+      AnimChannelCursor noCursor{ invalidKey, invalidKey, invalidKey };
+      AnimChannelCursor& cursor = cursors && !packedClip.uniform ? cursors[i][channel] : noCursor;
+
+      unsigned int frameKey = 0;
+      float frameFactor = 0.0f;
+      if (packedClip.uniform) {
+        float frame = std::max(time * packedClip.framesPerTick, 0.0f);
+        frameKey = std::min(static_cast<unsigned int>(frame), packedClip.numFrames - 2);
+        frameFactor = std::min(frame - static_cast<float>(frameKey), 1.0f);
+      }
+
+      TrackSample sample = packedClip.uniform ?
+        findUniformTrackSample(packedClip.translationTrack, channel, time, preState, postState, frameKey, frameFactor) :
+        findTrackSample(packedClip.translationTrack, channel, time, preState, postState, cursor.translationKey);
+      switch (sample.type) {
+        case trackSampleType::emptyTrack:
+        case trackSampleType::defaultValue:
+          nodeTransform.translation = glm::vec4(0.0f);
+          break;
+        case trackSampleType::keyValue:
+          nodeTransform.translation = glm::vec4(packedClip.getTranslation(channel, sample.key), 1.0f);
+          break;
+        case trackSampleType::interpolate:
+          addVec3Lane(translationBatch, translationTargets, &nodeTransform.translation,
+            packedClip.getTranslation(channel, sample.key), packedClip.getTranslation(channel, sample.key + 1), sample.factor);
+          break;
+      }
+
+      sample = packedClip.uniform ?
+        findUniformTrackSample(packedClip.rotationTrack, channel, time, preState, postState, frameKey, frameFactor) :
+        findTrackSample(packedClip.rotationTrack, channel, time, preState, postState, cursor.rotationKey);
+      switch (sample.type) {
+        case trackSampleType::emptyTrack:
+        case trackSampleType::defaultValue:
+          nodeTransform.rotation = glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
+          break;
+        case trackSampleType::keyValue: {
+          glm::quat rotation = packedClip.getRotation(sample.key);
+          nodeTransform.rotation = glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w);
+          break;
+        }
+        case trackSampleType::interpolate:
+          addQuatLane(rotationBatch, rotationTargets, &nodeTransform.rotation,
+            packedClip.getRotation(sample.key), packedClip.getRotation(sample.key + 1), sample.factor, useNlerp);
+          break;
+      }
+
+      sample = packedClip.uniform ?
+        findUniformTrackSample(packedClip.scaleTrack, channel, time, preState, postState, frameKey, frameFactor) :
+        findTrackSample(packedClip.scaleTrack, channel, time, preState, postState, cursor.scaleKey);
+      switch (sample.type) {
+        case trackSampleType::emptyTrack:
+          nodeTransform.scale = glm::vec4(1.0f);
+          break;
+        case trackSampleType::defaultValue:
+          nodeTransform.scale = glm::vec4(0.0f);
+          break;
+        case trackSampleType::keyValue:
+          nodeTransform.scale = glm::vec4(packedClip.scalings[sample.key], 1.0f);
+          break;
+        case trackSampleType::interpolate:
+          addVec3Lane(scaleBatch, scaleTargets, &nodeTransform.scale,
+            packedClip.scalings[sample.key], packedClip.scalings[sample.key + 1], sample.factor);
+          break;
+      }
+    }
+  }
+
+  flushVec3Batch(translationBatch, translationTargets);
+  flushQuatBatch(rotationBatch, rotationTargets, useNlerp);
+  flushVec3Batch(scaleBatch, scaleTargets);
+}
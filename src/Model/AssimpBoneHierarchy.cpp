@@ -0,0 +1,73 @@
+#include <algorithm>
+
+#include "Model/AssimpBoneHierarchy.hpp"
+#include "Tools/Logger.hpp"
+
+void AssimpBoneHierarchy::createLevelOrder(const std::vector<int32_t>& parentIndices, std::vector<int32_t>& levelOrder, std::vector<int32_t>& levelOffsets) {
+  size_t numBones = parentIndices.size();
+  levelOrder.clear();
+  levelOffsets.clear();
+
+  /* depth of every bone, the roots are level 0 */
+  std::vector<int32_t> boneLevels(numBones, 0);
+  int32_t numLevels = 0;
+  for (size_t bone = 0; bone < numBones; ++bone) {
+    int32_t level = 0;
+    int32_t parent = parentIndices.at(bone);
+    while (parent >= 0 && static_cast<size_t>(level) < numBones) {
+      ++level;
+      parent = parentIndices.at(parent);
+    }
+    if (static_cast<size_t>(level) >= numBones) {
+      Logger::log(1, "%s error: bone %i is part of a parent cycle\n", __FUNCTION__, bone);
+      level = 0;
+    }
+    boneLevels.at(bone) = level;
+    numLevels = std::max(numLevels, level + 1);
+  }
+
+  /* counting sort, keeps the bone order inside of a level */
+  levelOffsets.assign(numLevels + 1, 0);
+  for (const auto level : boneLevels) {
+    ++levelOffsets.at(level + 1);
+  }
+  for (int32_t level = 1; level <= numLevels; ++level) {
+    levelOffsets.at(level) += levelOffsets.at(level - 1);
+  }
+
+  std::vector<int32_t> fillPositions(levelOffsets.begin(), levelOffsets.end() - 1);
+  levelOrder.resize(numBones);
+  for (size_t bone = 0; bone < numBones; ++bone) {
+    levelOrder.at(fillPositions.at(boneLevels.at(bone))++) = static_cast<int32_t>(bone);
+  }
+}
+
+void AssimpBoneHierarchy::computeBoneMatricesParentWalk(const glm::mat4* localMatrices, const int32_t* parentIndices, const glm::mat4* offsetMatrices,
+    size_t numBones, glm::mat4* boneMatrices) {
+  for (size_t bone = 0; bone < numBones; ++bone) {
+    glm::mat4 nodeMatrix = localMatrices[bone];
+    int32_t parentNode = parentIndices[bone];
+    while (parentNode >= 0) {
+      nodeMatrix = localMatrices[parentNode] * nodeMatrix;
+      parentNode = parentIndices[parentNode];
+    }
+    boneMatrices[bone] = nodeMatrix * offsetMatrices[bone];
+  }
+}
+
+void AssimpBoneHierarchy::computeBoneMatricesLevelOrder(const glm::mat4* localMatrices, const int32_t* parentIndices, const std::vector<int32_t>& levelOrder,
+    const glm::mat4* offsetMatrices, size_t numBones, glm::mat4* globalMatrices, glm::mat4* boneMatrices) {
+  /* the global matrix of the parent is always ready */
+  for (const auto bone : levelOrder) {
+    int32_t parentNode = parentIndices[bone];
+    if (parentNode >= 0) {
+      globalMatrices[bone] = globalMatrices[parentNode] * localMatrices[bone];
+    } else {
+      globalMatrices[bone] = localMatrices[bone];
+    }
+  }
+
+  for (size_t bone = 0; bone < numBones; ++bone) {
+    boneMatrices[bone] = globalMatrices[bone] * offsetMatrices[bone];
+  }
+}
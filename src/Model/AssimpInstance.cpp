@@ -1,8 +1,8 @@
 #include "Model/AssimpInstance.hpp"
 
-#include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtx/quaternion.hpp>
+#include <algorithm>
 
+#include "Model/AssimpAnimSampler.hpp"
 #include "Tools/Logger.hpp"
 
 AssimpInstance::AssimpInstance(std::shared_ptr<AssimpModel> model, glm::vec3 position, glm::vec3 rotation, float modelScale) : mAssimpModel(model) {
@@ -14,6 +14,20 @@ AssimpInstance::AssimpInstance(std::shared_ptr<AssimpModel> model, glm::vec3 pos
   mInstanceSettings.isWorldRotation = rotation;
   mInstanceSettings.isScale = modelScale;
 
+  init();
+}
+
+AssimpInstance::AssimpInstance(std::shared_ptr<AssimpModel> model, AssimpInstanceStore* store, InstanceHandle handle) : mAssimpModel(model),
+    mStore(store), mHandle(handle) {
+  if (!model) {
+    Logger::log(1, "%s error: invalid model given\n", __FUNCTION__);
+    return;
+  }
+
+  init();
+}
+
+void AssimpInstance::init() {
   /* avoid resizes during fill */
   mNodeTransformData.resize(mAssimpModel->getBoneList().size());
 
@@ -23,48 +37,172 @@ AssimpInstance::AssimpInstance(std::shared_ptr<AssimpModel> model, glm::vec3 pos
   updateModelRootMatrix();
 }
 
+glm::vec3& AssimpInstance::storedPosition() {
+  return mStore ? mStore->getPositions()[mStore->getIndex(mHandle)] : mInstanceSettings.isWorldPosition;
+}
+
+glm::vec3& AssimpInstance::storedRotation() {
+  return mStore ? mStore->getRotations()[mStore->getIndex(mHandle)] : mInstanceSettings.isWorldRotation;
+}
+
+float& AssimpInstance::storedScale() {
+  return mStore ? mStore->getScales()[mStore->getIndex(mHandle)] : mInstanceSettings.isScale;
+}
+
+unsigned int& AssimpInstance::storedAnimClipNr() {
+  return mStore ? mStore->getAnimClipNrs()[mStore->getIndex(mHandle)] : mInstanceSettings.isAnimClipNr;
+}
+
+float& AssimpInstance::storedAnimPlayTimePos() {
+  return mStore ? mStore->getAnimPlayTimes()[mStore->getIndex(mHandle)] : mInstanceSettings.isAnimPlayTimePos;
+}
+
+float& AssimpInstance::storedAnimSpeedFactor() {
+  return mStore ? mStore->getAnimSpeedFactors()[mStore->getIndex(mHandle)] : mInstanceSettings.isAnimSpeedFactor;
+}
+
+glm::mat4& AssimpInstance::storedWorldMatrix() {
+  return mStore ? mStore->getWorldMatrices()[mStore->getIndex(mHandle)] : mInstanceRootMatrix;
+}
+
 void AssimpInstance::updateModelRootMatrix() {
-  mLocalScaleMatrix = glm::scale(glm::mat4(1.0f), glm::vec3(mInstanceSettings.isScale));
+  /* the store rebuilds the matrices of all changed instances at once */
+  if (mStore) {
+    mStore->markDirty(mStore->getIndex(mHandle));
+    return;
+  }
 
-  if (mInstanceSettings.isSwapYZAxis) {
-    glm::mat4 flipMatrix = glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-    mLocalSwapAxisMatrix = glm::rotate(flipMatrix, glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-  } else {
-    mLocalSwapAxisMatrix = glm::mat4(1.0f);
+  mInstanceRootMatrix = AssimpInstanceStore::createWorldMatrix(mInstanceSettings.isWorldPosition, mInstanceSettings.isWorldRotation,
+    mInstanceSettings.isScale, mInstanceSettings.isSwapYZAxis, mModelRootMatrix);
+}
+
+/* in clip ticks, wraps around at the end of the clip */
+static float advancePlayTime(const std::shared_ptr<AssimpAnimClip>& clip, float playTimePos, float speedFactor, float deltaTime) {
+  return std::fmod(playTimePos + deltaTime * clip->getClipTicksPerSecond() * speedFactor, clip->getClipDuration());
+}
+
+void AssimpInstance::updateAnimationTime(float deltaTime) {
+  unsigned int animClipNr = storedAnimClipNr();
+  float& animPlayTimePos = storedAnimPlayTimePos();
+  animPlayTimePos = advancePlayTime(mAssimpModel->getAnimClips().at(animClipNr), animPlayTimePos, storedAnimSpeedFactor(), deltaTime);
+
+  /* may run on a worker thread, avoid touching the reference counters of the channels */
+  size_t numChannels = mAssimpModel->getAnimClips().at(animClipNr)->getChannels().size();
+
+  /* cursors are only valid for the clip they were created for */
+  if (mAnimCursorClipNr != animClipNr || mAnimChannelCursors.size() != numChannels) {
+    mAnimChannelCursors.assign(numChannels, AnimChannelCursor{});
+    mAnimCursorClipNr = animClipNr;
   }
 
-  mLocalRotationMatrix = glm::mat4_cast(glm::quat(glm::radians(mInstanceSettings.isWorldRotation)));
+  /* the clip we fade out from keeps playing */
+  if (mInstanceSettings.isAnimFadeClipNr >= 0) {
+    mInstanceSettings.isAnimFadeTime += deltaTime;
+    if (mInstanceSettings.isAnimFadeTime >= mInstanceSettings.isAnimFadeDuration ||
+        static_cast<size_t>(mInstanceSettings.isAnimFadeClipNr) >= mAssimpModel->getAnimClips().size()) {
+      mInstanceSettings.isAnimFadeClipNr = -1;
+    } else {
+      mInstanceSettings.isAnimFadePlayTimePos = advancePlayTime(mAssimpModel->getAnimClips().at(mInstanceSettings.isAnimFadeClipNr),
+        mInstanceSettings.isAnimFadePlayTimePos, mInstanceSettings.isAnimFadeSpeedFactor, deltaTime);
+    }
+  }
 
-  mLocalTranslationMatrix = glm::translate(glm::mat4(1.0f), mInstanceSettings.isWorldPosition);
+  for (auto& layer : mInstanceSettings.isAnimLayers) {
+    if (layer.ablWeight > 0.0f && layer.ablClipNr < mAssimpModel->getAnimClips().size()) {
+      layer.ablPlayTimePos = advancePlayTime(mAssimpModel->getAnimClips().at(layer.ablClipNr), layer.ablPlayTimePos, layer.ablSpeedFactor, deltaTime);
+    }
+  }
+}
+
+void AssimpInstance::crossFadeToClip(unsigned int clipNr, float duration) {
+  unsigned int& animClipNr = storedAnimClipNr();
+  if (clipNr == animClipNr || clipNr >= mAssimpModel->getAnimClips().size()) {
+    return;
+  }
 
-  mLocalTransformMatrix = mLocalTranslationMatrix * mLocalRotationMatrix * mLocalSwapAxisMatrix * mLocalScaleMatrix;
-  mInstanceRootMatrix = mLocalTransformMatrix * mModelRootMatrix;
+  float& animPlayTimePos = storedAnimPlayTimePos();
+  if (duration > 0.0f) {
+    mInstanceSettings.isAnimFadeClipNr = static_cast<int>(animClipNr);
+    mInstanceSettings.isAnimFadePlayTimePos = animPlayTimePos;
+    mInstanceSettings.isAnimFadeSpeedFactor = storedAnimSpeedFactor();
+    mInstanceSettings.isAnimFadeTime = 0.0f;
+    mInstanceSettings.isAnimFadeDuration = duration;
+  } else {
+    mInstanceSettings.isAnimFadeClipNr = -1;
+  }
+
+  animClipNr = clipNr;
+  animPlayTimePos = 0.0f;
 }
 
-void AssimpInstance::updateAnimation(float deltaTime) {
-  mInstanceSettings.isAnimPlayTimePos += deltaTime * mAssimpModel->getAnimClips().at(mInstanceSettings.isAnimClipNr)->getClipTicksPerSecond() * mInstanceSettings.isAnimSpeedFactor;
-  mInstanceSettings.isAnimPlayTimePos = std::fmod(mInstanceSettings.isAnimPlayTimePos, mAssimpModel->getAnimClips().at(mInstanceSettings.isAnimClipNr)->getClipDuration());
+bool AssimpInstance::hasAnimBlending() {
+  if (mInstanceSettings.isAnimFadeClipNr >= 0) {
+    return true;
+  }
+  for (const auto& layer : mInstanceSettings.isAnimLayers) {
+    if (layer.ablWeight > 0.0f) {
+      return true;
+    }
+  }
+  return false;
+}
 
-  std::vector<std::shared_ptr<AssimpAnimChannel>> animChannels = mAssimpModel->getAnimClips().at(mInstanceSettings.isAnimClipNr)->getChannels();
+void AssimpInstance::updateAnimation(float deltaTime) {
+  updateAnimation(deltaTime, mNodeTransformData.data(), mNodeTransformData.size());
+}
 
-  std::fill(mNodeTransformData.begin(), mNodeTransformData.end(), NodeTransformData{});
+void AssimpInstance::updateAnimation(float deltaTime, NodeTransformData* nodeTransformData, size_t numNodeTransforms) {
+  if (numNodeTransforms < mAssimpModel->getBoneList().size()) {
+    Logger::log(1, "%s error: output has %i entries, model has %i bones\n", __FUNCTION__, numNodeTransforms, mAssimpModel->getBoneList().size());
+    return;
+  }
 
-  /* animate clip via channels */
-  for (const auto& channel : animChannels) {
-    NodeTransformData nodeTransform;
+  updateAnimationTime(deltaTime);
 
-    nodeTransform.translation = channel->getTranslation(mInstanceSettings.isAnimPlayTimePos);
-    nodeTransform.rotation = channel->getRotation(mInstanceSettings.isAnimPlayTimePos);
-    nodeTransform.scale = channel->getScaling(mInstanceSettings.isAnimPlayTimePos);
+  AnimChannelCursor* cursors = mAnimChannelCursors.data();
+  AssimpAnimSampler::sampleClip(mAssimpModel->getAnimClips().at(storedAnimClipNr()), &storedAnimPlayTimePos(), 1,
+    numNodeTransforms, nodeTransformData, &cursors);
 
-    int boneId = channel->getBoneId();
-    if (boneId >= 0) {
-      mNodeTransformData.at(boneId) = nodeTransform;
-    }
+  if (hasAnimBlending()) {
+    mAnimBlender.clear();
+    mAnimBlender.resetStatistics();
+    mAnimBlender.addInstance(getInstanceSettings(), nodeTransformData);
+    mAnimBlender.blendLayers(mAssimpModel, numNodeTransforms);
   }
+}
 
-  /* set root node transform matrix, enabling instance movement */
-  updateModelRootMatrix();
+AnimChannelCursor* AssimpInstance::getAnimChannelCursors() {
+  return mAnimChannelCursors.data();
+}
+
+void AssimpInstance::setAnimLod(unsigned int level, bool skipUpdate) {
+  mAnimLodLevel = level;
+  mAnimLodSkip = skipUpdate;
+}
+
+unsigned int AssimpInstance::getAnimLodLevel() {
+  return mAnimLodLevel;
+}
+
+bool AssimpInstance::getAnimLodSkip() {
+  return mAnimLodSkip;
+}
+
+bool AssimpInstance::hasAnimLodPose() {
+  return mAnimLodPoseClipNr == static_cast<int>(storedAnimClipNr());
+}
+
+void AssimpInstance::invalidateAnimLodPose() {
+  mAnimLodPoseClipNr = -1;
+}
+
+void AssimpInstance::storeAnimLodPose(const NodeTransformData* nodeTransformData) {
+  std::copy(nodeTransformData, nodeTransformData + mNodeTransformData.size(), mNodeTransformData.begin());
+  mAnimLodPoseClipNr = static_cast<int>(storedAnimClipNr());
+}
+
+void AssimpInstance::loadAnimLodPose(NodeTransformData* nodeTransformData) {
+  std::copy(mNodeTransformData.begin(), mNodeTransformData.end(), nodeTransformData);
 }
 
 std::shared_ptr<AssimpModel> AssimpInstance::getModel() {
@@ -72,58 +210,105 @@ std::shared_ptr<AssimpModel> AssimpInstance::getModel() {
 }
 
 glm::vec3 AssimpInstance::getWorldPosition() {
-  return mInstanceSettings.isWorldPosition;
+  return storedPosition();
 }
 
 glm::mat4 AssimpInstance::getWorldTransformMatrix() {
-  return mInstanceRootMatrix;
+  /* the static models keep transform records only, and the instance stays in the dirty list for the upload */
+  if (mStore) {
+    mStore->updateWorldMatrix(mStore->getIndex(mHandle));
+  }
+  return storedWorldMatrix();
 }
 
 void AssimpInstance::setTranslation(glm::vec3 position) {
-  mInstanceSettings.isWorldPosition = position;
+  storedPosition() = position;
   updateModelRootMatrix();
 }
 
 void AssimpInstance::setRotation(glm::vec3 rotation) {
-  mInstanceSettings.isWorldRotation = rotation;
+  storedRotation() = rotation;
   updateModelRootMatrix();
 }
 
 void AssimpInstance::setScale(float scale) {
-  mInstanceSettings.isScale = scale;
+  storedScale() = scale;
   updateModelRootMatrix();
 }
 
 void AssimpInstance::setSwapYZAxis(bool value) {
-  mInstanceSettings.isSwapYZAxis = value;
+  if (mStore) {
+    mStore->getSwapYZAxis()[mStore->getIndex(mHandle)] = value ? 1 : 0;
+  } else {
+    mInstanceSettings.isSwapYZAxis = value;
+  }
   updateModelRootMatrix();
 }
 
 glm::vec3 AssimpInstance::getRotation() {
-  return mInstanceSettings.isWorldRotation;
+  return storedRotation();
 }
 
 glm::vec3 AssimpInstance::getTranslation() {
-  return mInstanceSettings.isWorldPosition;
+  return storedPosition();
 }
 
 float AssimpInstance::getScale() {
-  return mInstanceSettings.isScale;
+  return storedScale();
 }
 
 bool AssimpInstance::getSwapYZAxis() {
+  if (mStore) {
+    return mStore->getSwapYZAxis()[mStore->getIndex(mHandle)] != 0;
+  }
   return mInstanceSettings.isSwapYZAxis;
 }
 
 void AssimpInstance::setInstanceSettings(InstanceSettings settings) {
   mInstanceSettings = settings;
+  if (mStore) {
+    mStore->writeSettings(mStore->getIndex(mHandle), settings);
+    return;
+  }
   updateModelRootMatrix();
 }
 
 InstanceSettings AssimpInstance::getInstanceSettings() {
-  return mInstanceSettings;
+  InstanceSettings settings = mInstanceSettings;
+  if (mStore) {
+    mStore->readSettings(mStore->getIndex(mHandle), settings);
+  }
+  return settings;
+}
+
+AssimpInstanceStore* AssimpInstance::getInstanceStore() {
+  return mStore;
+}
+
+InstanceHandle AssimpInstance::getInstanceHandle() {
+  return mHandle;
+}
+
+void AssimpInstance::detachFromStore() {
+  if (!mStore) {
+    return;
+  }
+
+  size_t index = mStore->getIndex(mHandle);
+  mStore->readSettings(index, mInstanceSettings);
+  mStore->updateWorldMatrix(index);
+  mInstanceRootMatrix = mStore->getWorldMatrices()[index];
+  mStore = nullptr;
+}
+
+void AssimpInstance::setInstanceListIndex(size_t index) {
+  mInstanceListIndex = index;
+}
+
+size_t AssimpInstance::getInstanceListIndex() {
+  return mInstanceListIndex;
 }
 
-std::vector<NodeTransformData> AssimpInstance::getNodeTransformData() {
+const std::vector<NodeTransformData>& AssimpInstance::getNodeTransformData() {
   return mNodeTransformData;
 }
@@ -0,0 +1,294 @@
+#include "Model/AssimpInstanceStore.hpp"
+
+#include <algorithm>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+#include "Model/AssimpInstance.hpp"
+#include "Model/AssimpTransformKernels.hpp"
+#include "Tools/JobSystem.hpp"
+#include "Tools/Logger.hpp"
+
+AssimpInstanceStore::AssimpInstanceStore(std::shared_ptr<AssimpModel> model) : mAssimpModel(model) {
+  if (!model) {
+    Logger::log(1, "%s error: invalid model given\n", __FUNCTION__);
+    return;
+  }
+  mModelRootMatrix = model->getRootTranformationMatrix();
+}
+
+AssimpInstanceStore::~AssimpInstanceStore() {
+  for (const auto& instance : mInstances) {
+    instance->detachFromStore();
+  }
+}
+
+std::shared_ptr<AssimpModel> AssimpInstanceStore::getModel() {
+  return mAssimpModel;
+}
+
+void AssimpInstanceStore::reserve(size_t numInstances) {
+  mInstances.reserve(numInstances);
+  mHandles.reserve(numInstances);
+  mPositions.reserve(numInstances);
+  mRotations.reserve(numInstances);
+  mScales.reserve(numInstances);
+  mSwapYZAxis.reserve(numInstances);
+  mAnimClipNrs.reserve(numInstances);
+  mAnimPlayTimes.reserve(numInstances);
+  mAnimSpeedFactors.reserve(numInstances);
+  mWorldMatrices.reserve(numInstances);
+  mDirty.reserve(numInstances);
+}
+
+std::shared_ptr<AssimpInstance> AssimpInstanceStore::addInstance(glm::vec3 position, glm::vec3 rotation, float scale) {
+  uint32_t slot = 0;
+  if (mFreeSlots.empty()) {
+    slot = static_cast<uint32_t>(mSlotIndices.size());
+    mSlotIndices.emplace_back(0);
+    /* generation 0 is never used, a default handle is always invalid */
+    mSlotGenerations.emplace_back(1);
+  } else {
+    slot = mFreeSlots.back();
+    mFreeSlots.pop_back();
+  }
+
+  InstanceHandle handle{};
+  handle.ihSlot = slot;
+  handle.ihGeneration = mSlotGenerations.at(slot);
+  mSlotIndices.at(slot) = static_cast<uint32_t>(mInstances.size());
+
+  InstanceSettings defaultSettings{};
+  mHandles.emplace_back(handle);
+  mPositions.emplace_back(position);
+  mRotations.emplace_back(rotation);
+  mScales.emplace_back(scale);
+  mSwapYZAxis.emplace_back(defaultSettings.isSwapYZAxis ? 1 : 0);
+  mAnimClipNrs.emplace_back(defaultSettings.isAnimClipNr);
+  mAnimPlayTimes.emplace_back(defaultSettings.isAnimPlayTimePos);
+  mAnimSpeedFactors.emplace_back(defaultSettings.isAnimSpeedFactor);
+  mWorldMatrices.emplace_back(1.0f);
+  mDirty.emplace_back(0);
+
+  /* the constructor of the instance marks the world matrix as dirty */
+  std::shared_ptr<AssimpInstance> instance = std::make_shared<AssimpInstance>(mAssimpModel, this, handle);
+  mInstances.emplace_back(instance);
+
+  return instance;
+}
+
+/* moves the last entry into the gap */
+template <typename T>
+static void swapRemove(std::vector<T>& data, size_t index) {
+  if (index + 1 != data.size()) {
+    data[index] = std::move(data.back());
+  }
+  data.pop_back();
+}
+
+bool AssimpInstanceStore::removeInstance(InstanceHandle handle) {
+  if (!isValid(handle)) {
+    Logger::log(1, "%s error: invalid instance handle (slot %u, generation %u)\n", __FUNCTION__, handle.ihSlot, handle.ihGeneration);
+    return false;
+  }
+
+  size_t index = mSlotIndices.at(handle.ihSlot);
+  mInstances.at(index)->detachFromStore();
+
+  swapRemove(mInstances, index);
+  swapRemove(mHandles, index);
+  swapRemove(mPositions, index);
+  swapRemove(mRotations, index);
+  swapRemove(mScales, index);
+  swapRemove(mSwapYZAxis, index);
+  swapRemove(mAnimClipNrs, index);
+  swapRemove(mAnimPlayTimes, index);
+  swapRemove(mAnimSpeedFactors, index);
+  swapRemove(mWorldMatrices, index);
+  swapRemove(mDirty, index);
+
+  /* the moved instance keeps its handle, only the slot needs the new position.
+   * the matrix is unchanged, but has to be uploaded to the new position */
+  if (index < mHandles.size()) {
+    mSlotIndices.at(mHandles.at(index).ihSlot) = static_cast<uint32_t>(index);
+    mDirty.at(index) = 0;
+    markDirty(index);
+  }
+
+  ++mSlotGenerations.at(handle.ihSlot);
+  mFreeSlots.emplace_back(handle.ihSlot);
+  return true;
+}
+
+bool AssimpInstanceStore::isValid(InstanceHandle handle) const {
+  return handle.ihSlot < mSlotGenerations.size() && mSlotGenerations[handle.ihSlot] == handle.ihGeneration;
+}
+
+size_t AssimpInstanceStore::getIndex(InstanceHandle handle) const {
+  return mSlotIndices[handle.ihSlot];
+}
+
+size_t AssimpInstanceStore::size() const {
+  return mInstances.size();
+}
+
+bool AssimpInstanceStore::empty() const {
+  return mInstances.empty();
+}
+
+const std::vector<std::shared_ptr<AssimpInstance>>& AssimpInstanceStore::getInstances() const {
+  return mInstances;
+}
+
+std::vector<glm::vec3>& AssimpInstanceStore::getPositions() {
+  return mPositions;
+}
+
+std::vector<glm::vec3>& AssimpInstanceStore::getRotations() {
+  return mRotations;
+}
+
+std::vector<float>& AssimpInstanceStore::getScales() {
+  return mScales;
+}
+
+std::vector<uint8_t>& AssimpInstanceStore::getSwapYZAxis() {
+  return mSwapYZAxis;
+}
+
+std::vector<unsigned int>& AssimpInstanceStore::getAnimClipNrs() {
+  return mAnimClipNrs;
+}
+
+std::vector<float>& AssimpInstanceStore::getAnimPlayTimes() {
+  return mAnimPlayTimes;
+}
+
+std::vector<float>& AssimpInstanceStore::getAnimSpeedFactors() {
+  return mAnimSpeedFactors;
+}
+
+std::vector<glm::mat4>& AssimpInstanceStore::getWorldMatrices() {
+  return mWorldMatrices;
+}
+
+void AssimpInstanceStore::readSettings(size_t index, InstanceSettings& settings) const {
+  settings.isWorldPosition = mPositions[index];
+  settings.isWorldRotation = mRotations[index];
+  settings.isScale = mScales[index];
+  settings.isSwapYZAxis = mSwapYZAxis[index] != 0;
+  settings.isAnimClipNr = mAnimClipNrs[index];
+  settings.isAnimPlayTimePos = mAnimPlayTimes[index];
+  settings.isAnimSpeedFactor = mAnimSpeedFactors[index];
+}
+
+void AssimpInstanceStore::writeSettings(size_t index, const InstanceSettings& settings) {
+  /* the UI writes the settings of the selected instance in every frame */
+  if (mPositions[index] != settings.isWorldPosition || mRotations[index] != settings.isWorldRotation || mScales[index] != settings.isScale ||
+      (mSwapYZAxis[index] != 0) != settings.isSwapYZAxis) {
+    markDirty(index);
+  }
+
+  mPositions[index] = settings.isWorldPosition;
+  mRotations[index] = settings.isWorldRotation;
+  mScales[index] = settings.isScale;
+  mSwapYZAxis[index] = settings.isSwapYZAxis ? 1 : 0;
+  mAnimClipNrs[index] = settings.isAnimClipNr;
+  mAnimPlayTimes[index] = settings.isAnimPlayTimePos;
+  mAnimSpeedFactors[index] = settings.isAnimSpeedFactor;
+}
+
+void AssimpInstanceStore::markDirty(size_t index) {
+  if (!mDirty[index]) {
+    mDirty[index] = 1;
+    mDirtyIndices.emplace_back(static_cast<uint32_t>(index));
+  }
+}
+
+bool AssimpInstanceStore::isDirty(size_t index) const {
+  return mDirty[index] != 0;
+}
+
+void AssimpInstanceStore::prepareDirtyIndices() {
+  /* removals leave the indices behind the end of the arrays */
+  mDirtyIndices.erase(std::remove_if(mDirtyIndices.begin(), mDirtyIndices.end(), [this](uint32_t index) { return index >= mDirty.size(); }),
+    mDirtyIndices.end());
+  /* a removal may add the index of the moved instance a second time */
+  std::sort(mDirtyIndices.begin(), mDirtyIndices.end());
+  mDirtyIndices.erase(std::unique(mDirtyIndices.begin(), mDirtyIndices.end()), mDirtyIndices.end());
+}
+
+void AssimpInstanceStore::updateWorldMatrices() {
+  prepareDirtyIndices();
+  JobSystem::parallelFor(mDirtyIndices.size(), mMatrixGrainSize, [&](size_t begin, size_t end) {
+    AssimpTransformKernels::buildWorldMatrices(mPositions.data(), mRotations.data(), mScales.data(), mSwapYZAxis.data(), mModelRootMatrix,
+      mDirtyIndices.data() + begin, end - begin, mWorldMatrices.data());
+  });
+}
+
+void AssimpInstanceStore::updateWorldMatrix(size_t index) {
+  uint32_t matrixIndex = static_cast<uint32_t>(index);
+  AssimpTransformKernels::buildWorldMatrices(mPositions.data(), mRotations.data(), mScales.data(), mSwapYZAxis.data(), mModelRootMatrix,
+    &matrixIndex, 1, mWorldMatrices.data());
+}
+
+void AssimpInstanceStore::updateTransformRecords() {
+  prepareDirtyIndices();
+  /* added instances are always dirty, the records behind the old end are written below */
+  mTransformRecords.resize(mInstances.size());
+  JobSystem::parallelFor(mDirtyIndices.size(), mMatrixGrainSize, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      size_t index = mDirtyIndices[i];
+      mTransformRecords[index] = createTransformRecord(mPositions[index], mRotations[index], mScales[index], mSwapYZAxis[index] != 0);
+    }
+  });
+}
+
+const std::vector<InstanceTransformRecord>& AssimpInstanceStore::getTransformRecords() const {
+  return mTransformRecords;
+}
+
+const std::vector<uint32_t>& AssimpInstanceStore::getDirtyIndices() const {
+  return mDirtyIndices;
+}
+
+void AssimpInstanceStore::clearDirty() {
+  for (uint32_t index : mDirtyIndices) {
+    if (index < mDirty.size()) {
+      mDirty[index] = 0;
+    }
+  }
+  mDirtyIndices.clear();
+}
+
+glm::mat4 AssimpInstanceStore::createWorldMatrix(glm::vec3 position, glm::vec3 rotation, float scale, bool swapYZAxis, const glm::mat4& modelRootMatrix) {
+  glm::mat4 localScaleMatrix = glm::scale(glm::mat4(1.0f), glm::vec3(scale));
+
+  glm::mat4 localSwapAxisMatrix = glm::mat4(1.0f);
+  if (swapYZAxis) {
+    glm::mat4 flipMatrix = glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    localSwapAxisMatrix = glm::rotate(flipMatrix, glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+  }
+
+  glm::mat4 localRotationMatrix = glm::mat4_cast(glm::quat(glm::radians(rotation)));
+
+  glm::mat4 localTranslationMatrix = glm::translate(glm::mat4(1.0f), position);
+
+  glm::mat4 localTransformMatrix = localTranslationMatrix * localRotationMatrix * localSwapAxisMatrix * localScaleMatrix;
+  return localTransformMatrix * modelRootMatrix;
+}
+
+InstanceTransformRecord AssimpInstanceStore::createTransformRecord(glm::vec3 position, glm::vec3 rotation, float scale, bool swapYZAxis) {
+  glm::quat orientation = glm::quat(glm::radians(rotation));
+  if (swapYZAxis) {
+    /* same rotations as the swap matrix in createWorldMatrix() */
+    orientation = orientation * glm::angleAxis(glm::radians(-90.0f), glm::vec3(0.0f, 0.0f, 1.0f)) *
+      glm::angleAxis(glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+  }
+
+  InstanceTransformRecord record{};
+  record.itrPositionScale = glm::vec4(position, scale);
+  record.itrRotation = glm::vec4(orientation.x, orientation.y, orientation.z, orientation.w);
+  return record;
+}
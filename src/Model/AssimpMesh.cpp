@@ -55,12 +55,10 @@ bool AssimpMesh::processMesh(aiMesh* mesh, const aiScene* scene, std::string ass
 
             // do not try to load internal textures
             if (!texName.empty() && texName.find("*") != 0) {
+              /* the model decodes all textures in parallel, failed textures are removed again */
               std::shared_ptr<Texture> newTex = std::make_shared<Texture>();
               std::string texNameWithPath = assetDirectory + '/' + texName;
-              if (!newTex->loadTexture(texNameWithPath)) {
-                Logger::log(1, "%s error: could not load texture file '%s', skipping\n", __FUNCTION__, texNameWithPath.c_str());
-                continue;
-              }
+              mPendingTextures.emplace_back(PendingTexture{texNameWithPath, newTex});
 
               textures.insert({texName, newTex});
             }
@@ -180,6 +178,10 @@ unsigned int AssimpMesh::getVertexCount() {
   return mVertexCount;
 }
 
+const std::vector<PendingTexture>& AssimpMesh::getPendingTextures() {
+  return mPendingTextures;
+}
+
 std::vector<std::shared_ptr<AssimpBone>> AssimpMesh::getBoneList() {
   return mBoneList;
 }
@@ -1,5 +1,11 @@
 #include <algorithm>
 #include <filesystem>
+#include <cmath>
+#include <limits>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtx/string_cast.hpp>
 
 #include <assimp/scene.h>
 #include <assimp/Importer.hpp>
@@ -8,6 +14,10 @@
 #include "Model/AssimpModel.hpp"
 #include "Tools/Tools.hpp"
 #include "Tools/Logger.hpp"
+#include "Tools/JobSystem.hpp"
+#include "Tools/Timer.hpp"
+#include "Model/AssimpAnimSampler.hpp"
+#include "Model/AssimpBoneHierarchy.hpp"
 
 bool AssimpModel::loadModel(std::string modelFilename, unsigned int extraImportFlags) {
   Logger::log(1, "%s: loading model from file '%s'\n", __FUNCTION__, modelFilename.c_str());
@@ -36,6 +46,9 @@ bool AssimpModel::loadModel(std::string modelFilename, unsigned int extraImportF
 
   aiNode* rootNode = scene->mRootNode;
 
+  /* textures are decoded by the job system while the nodes are processed, the upload is done afterwards */
+  JobCounter textureJobs;
+
   if (scene->HasTextures()) {
     unsigned int numTextures = scene->mNumTextures;
 
@@ -46,11 +59,16 @@ bool AssimpModel::loadModel(std::string modelFilename, unsigned int extraImportF
       int width = scene->mTextures[i]->mWidth;
       aiTexel* data = scene->mTextures[i]->pcData;
 
-      std::shared_ptr<Texture> newTex = std::make_shared<Texture>();
-      if (!newTex->loadTexture(texName, data, width, height)) {
+      if (!data) {
+        Logger::log(1, "%s error: could not load texture '%s'\n", __FUNCTION__, texName.c_str());
+        /* jobs may still use the scene data */
+        JobSystem::wait(textureJobs);
         return false;
       }
 
+      std::shared_ptr<Texture> newTex = std::make_shared<Texture>();
+      JobSystem::submit([newTex, texName, data, width, height]() { newTex->decodeTexture(texName, data, width, height); }, &textureJobs);
+
       std::string internalTexName = "*" + std::to_string(i);
       Logger::log(1, "%s: - added internal texture '%s'\n", __FUNCTION__, internalTexName.c_str());
       mTextures.insert({internalTexName, newTex});
@@ -62,18 +80,12 @@ bool AssimpModel::loadModel(std::string modelFilename, unsigned int extraImportF
   /* add a white texture in case there is no diffuse tex but colors */
   mWhiteTexture = std::make_shared<Texture>();
   std::string whiteTexName = "C:/Users/xrhstos/Desktop/RenderEngine/assets/textures/white.png";
-  if (!mWhiteTexture->loadTexture(whiteTexName)) {
-    Logger::log(1, "%s error: could not load white default texture '%s'\n", __FUNCTION__, whiteTexName.c_str());
-    return false;
-  }
+  JobSystem::submit([whiteTex = mWhiteTexture, whiteTexName]() { whiteTex->decodeTexture(whiteTexName); }, &textureJobs);
 
   /* add a placeholder texture in case there is no diffuse tex */
   mPlaceholderTexture = std::make_shared<Texture>();
   std::string placeholderTexName = "C:/Users/xrhstos/Desktop/RenderEngine/assets/textures/missing_tex.png";
-  if (!mPlaceholderTexture->loadTexture(placeholderTexName)) {
-    Logger::log(1, "%s error: could not load placeholder texture '%s'\n", __FUNCTION__, placeholderTexName.c_str());
-    return false;
-  }
+  JobSystem::submit([placeholderTex = mPlaceholderTexture, placeholderTexName]() { placeholderTex->decodeTexture(placeholderTexName); }, &textureJobs);
 
   /* the textures are stored directly or relative to the model file */
   std::string assetDirectory = modelFilename.substr(0, modelFilename.find_last_of('/'));
@@ -89,6 +101,12 @@ bool AssimpModel::loadModel(std::string modelFilename, unsigned int extraImportF
 
   Logger::log(1, "%s: ... processing nodes finished...\n", __FUNCTION__);
 
+  /* texture files found in the materials of the meshes */
+  for (const auto& pendingTex : mPendingTextures) {
+    JobSystem::submit([pendingTex]() { pendingTex.ptTexture->decodeTexture(pendingTex.ptFileName); }, &textureJobs);
+  }
+  mPendingTextures.clear();
+
   for (const auto& entry : mNodeList) {
     std::vector<std::shared_ptr<AssimpNode>> childNodes = entry->getChilds();
 
@@ -100,28 +118,98 @@ bool AssimpModel::loadModel(std::string modelFilename, unsigned int extraImportF
     }
   }
 
-  std::vector<glm::mat4> boneOffsetMatricesList{};
-  std::vector<int32_t> boneParentIndexList{};
-
   for (const auto& bone : mBoneList) {
-    boneOffsetMatricesList.emplace_back(bone->getOffsetMatrix());
+    mBoneOffsetMatrices.emplace_back(bone->getOffsetMatrix());
 
     std::string parentNodeName = mNodeMap.at(bone->getBoneName())->getParentNodeName();
     const auto boneIter = std::find_if(mBoneList.begin(), mBoneList.end(), [parentNodeName](std::shared_ptr<AssimpBone>& bone) { return bone->getBoneName() == parentNodeName; });
     if (boneIter == mBoneList.end()) {
-      boneParentIndexList.emplace_back(-1); // root node gets a -1 to identify
+      mBoneParentIndices.emplace_back(-1); // root node gets a -1 to identify
     } else {
-      boneParentIndexList.emplace_back(std::distance(mBoneList.begin(), boneIter));
+      mBoneParentIndices.emplace_back(std::distance(mBoneList.begin(), boneIter));
     }
   }
 
   Logger::log(1, "%s: -- bone parents --\n", __FUNCTION__);
   for (unsigned int i = 0; i < mBoneList.size(); ++i) {
-    Logger::log(1, "%s: bone %i (%s) has parent %i (%s)\n", __FUNCTION__, i, mBoneList.at(i)->getBoneName().c_str(), boneParentIndexList.at(i),
-      boneParentIndexList.at(i) < 0 ? "invalid" : mBoneList.at(boneParentIndexList.at(i))->getBoneName().c_str());
+    Logger::log(1, "%s: bone %i (%s) has parent %i (%s)\n", __FUNCTION__, i, mBoneList.at(i)->getBoneName().c_str(), mBoneParentIndices.at(i),
+      mBoneParentIndices.at(i) < 0 ? "invalid" : mBoneList.at(mBoneParentIndices.at(i))->getBoneName().c_str());
   }
   Logger::log(1, "%s: -- bone parents --\n", __FUNCTION__);
 
+  /* the matrix compute shader resolves the global bone matrices level by level */
+  AssimpBoneHierarchy::createLevelOrder(mBoneParentIndices, mBoneLevelOrder, mBoneLevelOffsets);
+  Logger::log(1, "%s: bone hierarchy has %i levels\n", __FUNCTION__, getBoneLevelCount());
+
+  /* animation clips are independent of each other, the packing of the keys is done in parallel */
+  unsigned int numAnims = scene->mNumAnimations;
+  mAnimClips.resize(numAnims);
+  JobCounter animClipJobs;
+  for (unsigned int i = 0; i < numAnims; ++i) {
+    aiAnimation* animation = scene->mAnimations[i];
+
+    Logger::log(1, "%s: -- animation clip %i has %i skeletal channels, %i mesh channels, and %i morph mesh channels\n",
+      __FUNCTION__, i, animation->mNumChannels, animation->mNumMeshChannels, animation->mNumMorphMeshChannels);
+
+    JobSystem::submit([this, animation, i]() {
+      std::shared_ptr<AssimpAnimClip> animClip = std::make_shared<AssimpAnimClip>();
+      animClip->addChannels(animation, mBoneList, mAnimCompressionSettings);
+      if (animClip->getClipName().empty()) {
+        animClip->setClipName(std::to_string(i));
+      }
+      mAnimClips.at(i) = animClip;
+    }, &animClipJobs);
+  }
+
+  /* OpenGL calls are only allowed in this thread */
+  JobSystem::wait(textureJobs);
+
+  if (!mWhiteTexture->uploadTexture()) {
+    Logger::log(1, "%s error: could not load white default texture '%s'\n", __FUNCTION__, whiteTexName.c_str());
+    JobSystem::wait(animClipJobs);
+    return false;
+  }
+
+  if (!mPlaceholderTexture->uploadTexture()) {
+    Logger::log(1, "%s error: could not load placeholder texture '%s'\n", __FUNCTION__, placeholderTexName.c_str());
+    JobSystem::wait(animClipJobs);
+    return false;
+  }
+
+  /* a broken embedded texture fails the model, missing texture files of the materials are skipped */
+  for (auto iter = mTextures.begin(); iter != mTextures.end(); ) {
+    if (!iter->second->uploadTexture()) {
+      if (iter->first.find("*") == 0) {
+        Logger::log(1, "%s error: could not load embedded texture '%s'\n", __FUNCTION__, iter->first.c_str());
+        JobSystem::wait(animClipJobs);
+        return false;
+      }
+      Logger::log(1, "%s error: could not load texture '%s', skipping\n", __FUNCTION__, iter->first.c_str());
+      iter = mTextures.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+
+  /* bounding sphere of the bind pose, the center is the middle of the bounding box */
+  glm::vec3 minPos = glm::vec3(std::numeric_limits<float>::max());
+  glm::vec3 maxPos = glm::vec3(std::numeric_limits<float>::lowest());
+  for (const auto& mesh : mModelMeshes) {
+    for (const auto& vertex : mesh.vertices) {
+      minPos = glm::min(minPos, glm::vec3(vertex.position));
+      maxPos = glm::max(maxPos, glm::vec3(vertex.position));
+    }
+  }
+  if (mVertexCount > 0) {
+    mBoundingSphereCenter = (minPos + maxPos) * 0.5f;
+    mBoundingSphereRadius = 0.0f;
+    for (const auto& mesh : mModelMeshes) {
+      for (const auto& vertex : mesh.vertices) {
+        mBoundingSphereRadius = std::max(mBoundingSphereRadius, glm::length(glm::vec3(vertex.position) - mBoundingSphereCenter));
+      }
+    }
+  }
+  Logger::log(1, "%s: bounding sphere center %s, radius %f\n", __FUNCTION__, glm::to_string(mBoundingSphereCenter).c_str(), mBoundingSphereRadius);
 
   /* create vertex buffers for the meshes */
   for (const auto& mesh : mModelMeshes) {
@@ -131,24 +219,24 @@ bool AssimpModel::loadModel(std::string modelFilename, unsigned int extraImportF
     mVertexBuffers.emplace_back(buffer);
   }
 
-  mShaderBoneMatrixOffsetBuffer.uploadSsboData(boneOffsetMatricesList);
-  mShaderBoneParentBuffer.uploadSsboData(boneParentIndexList);
+  /* the pre-skinning compute shader reads the vertices of all meshes from a single buffer */
+  std::vector<OGLVertex> skinVertices{};
+  skinVertices.reserve(mVertexCount);
+  for (const auto& mesh : mModelMeshes) {
+    mMeshVertexOffsets.emplace_back(skinVertices.size());
+    skinVertices.insert(skinVertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+  }
+  if (!mBoneList.empty()) {
+    mSkinVertexBuffer.uploadSsboData(skinVertices);
+  }
 
-  /* animations */
-  unsigned int numAnims = scene->mNumAnimations;
-  for (unsigned int i = 0; i < numAnims; ++i) {
-    aiAnimation* animation = scene->mAnimations[i];
+  mShaderBoneMatrixOffsetBuffer.uploadSsboData(mBoneOffsetMatrices);
+  mShaderBoneParentBuffer.uploadSsboData(mBoneParentIndices);
 
-    Logger::log(1, "%s: -- animation clip %i has %i skeletal channels, %i mesh channels, and %i morph mesh channels\n",
-      __FUNCTION__, i, animation->mNumChannels, animation->mNumMeshChannels, animation->mNumMorphMeshChannels);
+  JobSystem::wait(animClipJobs);
 
-    std::shared_ptr<AssimpAnimClip> animClip = std::make_shared<AssimpAnimClip>();
-    animClip->addChannels(animation, mBoneList);
-    if (animClip->getClipName().empty()) {
-      animClip->setClipName(std::to_string(i));
-    }
-    mAnimClips.emplace_back(animClip);
-  }
+  createGpuAnimClips();
+  createAnimReferencePoses();
 
   mModelFilenamePath = modelFilename;
   mModelFilename = std::filesystem::path(modelFilename).filename().generic_string();
@@ -164,6 +252,350 @@ bool AssimpModel::loadModel(std::string modelFilename, unsigned int extraImportF
   return true;
 }
 
+void AssimpModel::bakeAnimations() {
+  if (mAnimClips.empty() || mBoneList.empty()) {
+    return;
+  }
+
+  Timer bakeTimer;
+  bakeTimer.start();
+
+  size_t numBones = mBoneList.size();
+
+  /* the last frame of every clip is at the clip end */
+  mBakedClipFrames.clear();
+  unsigned int totalFrames = 0;
+  for (const auto& clip : mAnimClips) {
+    float ticksPerSecond = clip->getClipTicksPerSecond() > 0.0f ? clip->getClipTicksPerSecond() : 1.0f;
+    unsigned int numFrames = static_cast<unsigned int>(std::ceil(clip->getClipDuration() / ticksPerSecond * mBakeFramesPerSecond)) + 1;
+    mBakedClipFrames.emplace_back(totalFrames, numFrames);
+    totalFrames += numFrames;
+  }
+
+  std::vector<glm::mat4> bakedMatrices(totalFrames * numBones);
+
+  /* same math as the two compute shaders: TRS matrix, global matrix, bone offset */
+  JobSystem::parallelFor(totalFrames, 16, [&](size_t begin, size_t end) {
+    std::vector<NodeTransformData> nodeTransforms(numBones);
+    std::vector<glm::mat4> trsMatrices(numBones);
+    std::vector<glm::mat4> globalMatrices(numBones);
+
+    for (size_t frame = begin; frame < end; ++frame) {
+      size_t clipNr = 0;
+      while (clipNr + 1 < mBakedClipFrames.size() && mBakedClipFrames.at(clipNr + 1).x <= frame) {
+        ++clipNr;
+      }
+      const std::shared_ptr<AssimpAnimClip>& clip = mAnimClips.at(clipNr);
+
+      float ticksPerSecond = clip->getClipTicksPerSecond() > 0.0f ? clip->getClipTicksPerSecond() : 1.0f;
+      float time = std::min((frame - mBakedClipFrames.at(clipNr).x) / mBakeFramesPerSecond * ticksPerSecond, clip->getClipDuration());
+      AssimpAnimSampler::sampleClip(clip, &time, 1, numBones, nodeTransforms.data());
+
+      for (size_t bone = 0; bone < numBones; ++bone) {
+        const NodeTransformData& nodeTransform = nodeTransforms.at(bone);
+        glm::quat rotation = glm::quat(nodeTransform.rotation.w, nodeTransform.rotation.x, nodeTransform.rotation.y, nodeTransform.rotation.z);
+        trsMatrices.at(bone) = glm::translate(glm::mat4(1.0f), glm::vec3(nodeTransform.translation)) * glm::mat4_cast(rotation) *
+          glm::scale(glm::mat4(1.0f), glm::vec3(nodeTransform.scale));
+      }
+
+      AssimpBoneHierarchy::computeBoneMatricesLevelOrder(trsMatrices.data(), mBoneParentIndices.data(), mBoneLevelOrder, mBoneOffsetMatrices.data(),
+        numBones, globalMatrices.data(), bakedMatrices.data() + frame * numBones);
+    }
+  });
+
+  mBakedBoneMatrixBuffer.uploadSsboData(bakedMatrices);
+  mBakedClipBuffer.uploadSsboData(mBakedClipFrames);
+
+  mBakedFrameCount = totalFrames;
+  mBakedAnimationSize = bakedMatrices.size() * sizeof(glm::mat4) + mBakedClipFrames.size() * sizeof(glm::uvec2);
+  mBakeTime = bakeTimer.stop();
+
+  Logger::log(1, "%s: baked %i clips with %i frames at %.1f fps (%i bytes) in %.3f ms\n", __FUNCTION__, mAnimClips.size(), mBakedFrameCount,
+    mBakeFramesPerSecond, mBakedAnimationSize, mBakeTime);
+}
+
+void AssimpModel::setAnimCompressionSettings(const AnimCompressionSettings& settings) {
+  mAnimCompressionSettings = settings;
+
+  JobCounter compressionJobs;
+  for (const auto& clip : mAnimClips) {
+    JobSystem::submit([&clip, &settings]() { clip->compress(settings); }, &compressionJobs);
+  }
+  JobSystem::wait(compressionJobs);
+  createGpuAnimClips();
+  createAnimReferencePoses();
+
+  /* the baked frames must show the same poses as the sampled clips */
+  if (hasBakedAnimations()) {
+    bakeAnimations();
+  }
+}
+
+void AssimpModel::createGpuAnimClips() {
+  mGpuAnimClipTable.clear();
+  mGpuAnimChannels.clear();
+  mGpuAnimKeyTimes.clear();
+  mGpuAnimKeyValues.clear();
+  ++mGpuAnimClipVersion;
+
+  if (mAnimClips.empty() || mBoneList.empty()) {
+    return;
+  }
+
+  size_t numBones = mBoneList.size();
+  mGpuAnimClipTable.resize(mAnimClips.size());
+
+  for (size_t clipNr = 0; clipNr < mAnimClips.size(); ++clipNr) {
+    const PackedAnimClip& packedClip = mAnimClips.at(clipNr)->getPackedClip();
+
+    size_t boneChannels = mGpuAnimClipTable.size();
+    mGpuAnimClipTable.at(clipNr) = static_cast<int32_t>(boneChannels);
+    mGpuAnimClipTable.resize(boneChannels + numBones, -1);
+
+    for (unsigned int channel = 0; channel < packedClip.numChannels; ++channel) {
+      int boneId = packedClip.boneIds[channel];
+      if (boneId < 0 || static_cast<size_t>(boneId) >= numBones) {
+        continue;
+      }
+      /* a later channel of the same bone wins, as in the CPU sampler */
+      mGpuAnimClipTable.at(boneChannels + boneId) = static_cast<int32_t>(mGpuAnimChannels.size());
+
+      GpuAnimChannel gpuChannel{};
+      gpuChannel.gchPreState = static_cast<int32_t>(packedClip.preStates[channel]);
+      gpuChannel.gchPostState = static_cast<int32_t>(packedClip.postStates[channel]);
+
+      /* the quantized keys are decoded here, the shader only sees floats. resampled clips get their key times back,
+       * the shader still searches the keys. collapsed tracks of resampled clips get the time range of the original keys,
+       * the first and the last key have the same value */
+      auto appendKeys = [&](const PackedAnimTrack& track, int32_t& firstKey, int32_t& keyCount, auto getKeyValue) {
+        firstKey = static_cast<int32_t>(mGpuAnimKeyTimes.size());
+        keyCount = static_cast<int32_t>(track.keyCounts[channel]);
+        if (packedClip.uniform && track.constantChannels[channel]) {
+          const glm::vec2& keyRange = track.keyRanges[channel];
+          unsigned int key = track.keyOffsets[channel];
+          mGpuAnimKeyTimes.emplace_back(keyRange.x, 0.0f);
+          mGpuAnimKeyValues.emplace_back(getKeyValue(key));
+          if (keyRange.y > keyRange.x) {
+            mGpuAnimKeyTimes.emplace_back(keyRange.y, 0.0f);
+            mGpuAnimKeyValues.emplace_back(getKeyValue(key));
+            keyCount = 2;
+          }
+          return;
+        }
+        for (unsigned int i = 0; i < track.keyCounts[channel]; ++i) {
+          unsigned int key = track.keyOffsets[channel] + i;
+          mGpuAnimKeyTimes.emplace_back(packedClip.getKeyTime(track, channel, key), packedClip.getInverseKeyTimeDiff(track, key));
+          mGpuAnimKeyValues.emplace_back(getKeyValue(key));
+        }
+      };
+
+      appendKeys(packedClip.translationTrack, gpuChannel.gchTranslationKey, gpuChannel.gchTranslationCount,
+        [&](unsigned int key) { return glm::vec4(packedClip.getTranslation(channel, key), 1.0f); });
+      appendKeys(packedClip.rotationTrack, gpuChannel.gchRotationKey, gpuChannel.gchRotationCount,
+        [&](unsigned int key) {
+          glm::quat rotation = packedClip.getRotation(key);
+          return glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w);
+        });
+      appendKeys(packedClip.scaleTrack, gpuChannel.gchScaleKey, gpuChannel.gchScaleCount,
+        [&](unsigned int key) { return glm::vec4(packedClip.scalings[key], 1.0f); });
+
+      gpuChannel.gchConstantTracks = (packedClip.translationTrack.constantChannels[channel] ? 1 : 0) |
+        (packedClip.rotationTrack.constantChannels[channel] ? 2 : 0) | (packedClip.scaleTrack.constantChannels[channel] ? 4 : 0);
+
+      mGpuAnimChannels.emplace_back(gpuChannel);
+    }
+  }
+
+  Logger::log(1, "%s: GPU clip data for %i clips: %i channels, %i keys (%i bytes)\n", __FUNCTION__, mAnimClips.size(), mGpuAnimChannels.size(),
+    mGpuAnimKeyTimes.size(), mGpuAnimClipTable.size() * sizeof(int32_t) + mGpuAnimChannels.size() * sizeof(GpuAnimChannel) +
+    mGpuAnimKeyTimes.size() * (sizeof(glm::vec2) + sizeof(glm::vec4)));
+}
+
+const std::vector<int32_t>& AssimpModel::getGpuAnimClipTable() {
+  return mGpuAnimClipTable;
+}
+
+const std::vector<GpuAnimChannel>& AssimpModel::getGpuAnimChannels() {
+  return mGpuAnimChannels;
+}
+
+const std::vector<glm::vec2>& AssimpModel::getGpuAnimKeyTimes() {
+  return mGpuAnimKeyTimes;
+}
+
+const std::vector<glm::vec4>& AssimpModel::getGpuAnimKeyValues() {
+  return mGpuAnimKeyValues;
+}
+
+unsigned int AssimpModel::getGpuAnimClipVersion() {
+  return mGpuAnimClipVersion;
+}
+
+void AssimpModel::createAnimReferencePoses() {
+  size_t numBones = mBoneList.size();
+  mAnimReferencePoses.resize(mAnimClips.size() * numBones);
+
+  float firstFrame = 0.0f;
+  for (size_t clipNr = 0; clipNr < mAnimClips.size(); ++clipNr) {
+    AssimpAnimSampler::sampleClip(mAnimClips.at(clipNr), &firstFrame, 1, numBones, mAnimReferencePoses.data() + clipNr * numBones);
+  }
+}
+
+const NodeTransformData* AssimpModel::getAnimReferencePose(unsigned int clipNr) {
+  if (clipNr >= mAnimClips.size() || mBoneList.empty()) {
+    return nullptr;
+  }
+  return mAnimReferencePoses.data() + clipNr * mBoneList.size();
+}
+
+int AssimpModel::createBoneMask(std::string boneName) {
+  const auto maskIter = std::find(mBoneMaskNames.begin(), mBoneMaskNames.end(), boneName);
+  if (maskIter != mBoneMaskNames.end()) {
+    return static_cast<int>(std::distance(mBoneMaskNames.begin(), maskIter));
+  }
+
+  const auto boneIter = std::find_if(mBoneList.begin(), mBoneList.end(), [&boneName](std::shared_ptr<AssimpBone>& bone) { return bone->getBoneName() == boneName; });
+  if (boneIter == mBoneList.end()) {
+    Logger::log(1, "%s error: model '%s' has no bone '%s'\n", __FUNCTION__, mModelFilename.c_str(), boneName.c_str());
+    return -1;
+  }
+  int maskRoot = static_cast<int>(std::distance(mBoneList.begin(), boneIter));
+
+  /* walk up the parents of every bone until the mask root or the model root has been reached */
+  std::vector<float> boneMask(mBoneList.size(), 0.0f);
+  for (size_t i = 0; i < mBoneList.size(); ++i) {
+    int bone = static_cast<int>(i);
+    while (bone >= 0 && bone != maskRoot) {
+      bone = mBoneParentIndices.at(bone);
+    }
+    if (bone == maskRoot) {
+      boneMask.at(i) = 1.0f;
+    }
+  }
+
+  mBoneMasks.emplace_back(boneMask);
+  mBoneMaskNames.emplace_back(boneName);
+  Logger::log(1, "%s: added bone mask %i for bone '%s'\n", __FUNCTION__, mBoneMasks.size() - 1, boneName.c_str());
+  return static_cast<int>(mBoneMasks.size() - 1);
+}
+
+unsigned int AssimpModel::getBoneMaskCount() {
+  return static_cast<unsigned int>(mBoneMasks.size());
+}
+
+const std::vector<float>& AssimpModel::getBoneMask(int maskNr) {
+  return mBoneMasks.at(maskNr);
+}
+
+std::string AssimpModel::getBoneMaskName(int maskNr) {
+  return mBoneMaskNames.at(maskNr);
+}
+
+const AnimCompressionSettings& AssimpModel::getAnimCompressionSettings() {
+  return mAnimCompressionSettings;
+}
+
+AnimCompressionStats AssimpModel::getAnimCompressionStats() {
+  AnimCompressionStats modelStats{};
+  for (const auto& clip : mAnimClips) {
+    const AnimCompressionStats& clipStats = clip->getCompressionStats();
+    modelStats.rawKeys += clipStats.rawKeys;
+    modelStats.packedKeys += clipStats.packedKeys;
+    modelStats.constantTracks += clipStats.constantTracks;
+    modelStats.rawSize += clipStats.rawSize;
+    modelStats.packedSize += clipStats.packedSize;
+    modelStats.resampleGrowth += clipStats.resampleGrowth;
+    modelStats.resampleSavings += clipStats.resampleSavings;
+  }
+  return modelStats;
+}
+
+unsigned int AssimpModel::getBoneLevelCount() {
+  return mBoneLevelOffsets.empty() ? 0 : static_cast<unsigned int>(mBoneLevelOffsets.size() - 1);
+}
+
+const std::vector<int32_t>& AssimpModel::getBoneLevelOrder() {
+  return mBoneLevelOrder;
+}
+
+const std::vector<int32_t>& AssimpModel::getBoneLevelOffsets() {
+  return mBoneLevelOffsets;
+}
+
+glm::vec3 AssimpModel::getBoundingSphereCenter() {
+  return mBoundingSphereCenter;
+}
+
+float AssimpModel::getBoundingSphereRadius() {
+  return mBoundingSphereRadius;
+}
+
+bool AssimpModel::hasBakedAnimations() {
+  return mBakedFrameCount > 0;
+}
+
+void AssimpModel::setUseBakedAnimations(bool value) {
+  /* most models never use the baked clips, bake on first use only */
+  if (value && !hasBakedAnimations()) {
+    bakeAnimations();
+  }
+  mUseBakedAnimations = value;
+}
+
+bool AssimpModel::getUseBakedAnimations() {
+  return mUseBakedAnimations;
+}
+
+void AssimpModel::setPreSkinning(bool value) {
+  mPreSkinning = value;
+}
+
+bool AssimpModel::getPreSkinning() {
+  return mPreSkinning;
+}
+
+void AssimpModel::bindSkinVertexBuffer(int bindingPoint) {
+  mSkinVertexBuffer.bind(bindingPoint);
+}
+
+float AssimpModel::getBakeFramesPerSecond() {
+  return mBakeFramesPerSecond;
+}
+
+unsigned int AssimpModel::getBakedFrameCount() {
+  return mBakedFrameCount;
+}
+
+size_t AssimpModel::getBakedAnimationSize() {
+  return mBakedAnimationSize;
+}
+
+float AssimpModel::getBakeTime() {
+  return mBakeTime;
+}
+
+BakedAnimRecord AssimpModel::getBakedAnimRecord(unsigned int clipNr, float playTime) {
+  BakedAnimRecord record;
+  record.barClip = clipNr;
+
+  const std::shared_ptr<AssimpAnimClip>& clip = mAnimClips.at(clipNr);
+  float ticksPerSecond = clip->getClipTicksPerSecond() > 0.0f ? clip->getClipTicksPerSecond() : 1.0f;
+  float framePos = std::max(playTime, 0.0f) / ticksPerSecond * mBakeFramesPerSecond;
+
+  unsigned int lastFrame = mBakedClipFrames.at(clipNr).y - 1;
+  record.barFrame = std::min(static_cast<unsigned int>(framePos), lastFrame);
+  record.barBlend = record.barFrame < lastFrame ? framePos - static_cast<float>(record.barFrame) : 0.0f;
+  return record;
+}
+
+void AssimpModel::bindBakedBoneMatrixBuffer(int bindingPoint) {
+  mBakedBoneMatrixBuffer.bind(bindingPoint);
+}
+
+void AssimpModel::bindBakedClipBuffer(int bindingPoint) {
+  mBakedClipBuffer.bind(bindingPoint);
+}
+
 void AssimpModel::processNode(std::shared_ptr<AssimpNode> node, aiNode* aNode, const aiScene* scene, std::string assetDirectory) {
   std::string nodeName = aNode->mName.C_Str();
   Logger::log(1, "%s: node name: '%s'\n", __FUNCTION__, nodeName.c_str());
@@ -179,6 +611,9 @@ void AssimpModel::processNode(std::shared_ptr<AssimpNode> node, aiNode* aNode, c
 
       mModelMeshes.emplace_back(mesh.getMesh());
 
+      const std::vector<PendingTexture>& meshTextures = mesh.getPendingTextures();
+      mPendingTextures.insert(mPendingTextures.end(), meshTextures.begin(), meshTextures.end());
+
       /* avoid inserting duplicate bone Ids - meshes can reference the same bones */
       std::vector<std::shared_ptr<AssimpBone>> flatBones = mesh.getBoneList();
       for (const auto& bone : flatBones) {
@@ -248,7 +683,7 @@ void AssimpModel::draw() {
   }
 }
 
-void AssimpModel::drawInstanced(int instanceCount) {
+void AssimpModel::drawInstanced(int instanceCount, bool preSkinned) {
   for (unsigned int i = 0; i < mModelMeshes.size(); ++i) {
     OGLMesh& mesh = mModelMeshes.at(i);
     // find diffuse texture by name
@@ -273,7 +708,13 @@ void AssimpModel::drawInstanced(int instanceCount) {
       }
     }
 
-    mVertexBuffers.at(i).bindAndDrawIndirectInstanced(GL_TRIANGLES, mesh.indices.size(), instanceCount);
+    if (preSkinned) {
+      /* the vertex shader finds the skinned vertices of the mesh by the base instance */
+      mVertexBuffers.at(i).bindAndDrawIndirectInstancedBaseInstance(GL_TRIANGLES, mesh.indices.size(), instanceCount,
+        mMeshVertexOffsets.at(i));
+    } else {
+      mVertexBuffers.at(i).bindAndDrawIndirectInstanced(GL_TRIANGLES, mesh.indices.size(), instanceCount);
+    }
 
     if (diffuseTex) {
       diffuseTex->unbind();
@@ -291,6 +732,10 @@ unsigned int AssimpModel::getTriangleCount() {
   return mTriangleCount;
 }
 
+unsigned int AssimpModel::getVertexCount() {
+  return mVertexCount;
+}
+
 void AssimpModel::cleanup() {
   for (auto buffer : mVertexBuffers) {
     buffer.cleanup();
@@ -307,6 +752,10 @@ void AssimpModel::cleanup() {
   if (mWhiteTexture) {
     mWhiteTexture->cleanup();
   }
+
+  mBakedBoneMatrixBuffer.cleanup();
+  mBakedClipBuffer.cleanup();
+  mSkinVertexBuffer.cleanup();
 }
 
 std::string AssimpModel::getModelFileName() {
@@ -344,3 +793,11 @@ void AssimpModel::bindBoneMatrixOffsetBuffer(int bindingPoint) {
 void AssimpModel::bindBoneParentBuffer(int bindingPoint) {
   mShaderBoneParentBuffer.bind(bindingPoint);
 }
+
+const std::vector<int32_t>& AssimpModel::getBoneParentIndices() {
+  return mBoneParentIndices;
+}
+
+const std::vector<glm::mat4>& AssimpModel::getBoneOffsetMatrices() {
+  return mBoneOffsetMatrices;
+}
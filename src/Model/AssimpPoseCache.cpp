@@ -0,0 +1,74 @@
+#include <algorithm>
+
+#include "Model/AssimpPoseCache.hpp"
+#include "Model/AssimpAnimSampler.hpp"
+#include "Tools/JobSystem.hpp"
+
+void AssimpPoseCache::setQuantizationStep(float step) {
+  mQuantizationStep = std::max(step, 0.0f);
+}
+
+float AssimpPoseCache::getQuantizationStep() {
+  return mQuantizationStep;
+}
+
+const PoseCacheStats& AssimpPoseCache::getStatistics() {
+  return mStats;
+}
+
+void AssimpPoseCache::resetStatistics() {
+  mStats = PoseCacheStats{};
+}
+
+float AssimpPoseCache::sampleClip(const std::shared_ptr<AssimpAnimClip>& clip, const float* times, size_t numInstances, size_t numBones,
+    NodeTransformData* out, bool useNlerp) {
+  if (numInstances == 0) {
+    return 0.0f;
+  }
+  mStats.pcLookups += static_cast<unsigned int>(numInstances);
+
+  float ticksPerSecond = clip->getClipTicksPerSecond() > 0.0f ? clip->getClipTicksPerSecond() : 1.0f;
+  float stepTicks = mQuantizationStep * ticksPerSecond;
+  float clipDuration = clip->getClipDuration();
+
+  size_t numBuckets = 0;
+  if (stepTicks > 0.0f) {
+    numBuckets = static_cast<size_t>(clipDuration / stepTicks) + 2;
+  }
+
+  if (numBuckets == 0 || numBuckets > mMaxBuckets) {
+    return JobSystem::parallelFor(numInstances, 32, [&](size_t begin, size_t end) {
+      AssimpAnimSampler::sampleClip(clip, times + begin, end - begin, numBones, out + begin * numBones, nullptr, useNlerp);
+    });
+  }
+
+  /* find the distinct quantized times */
+  mBucketPoses.assign(numBuckets, -1);
+  mPoseTimes.clear();
+  mInstancePoses.resize(numInstances);
+  for (size_t i = 0; i < numInstances; ++i) {
+    size_t bucket = std::min(static_cast<size_t>(std::max(0.0f, times[i] / stepTicks + 0.5f)), numBuckets - 1);
+    if (mBucketPoses[bucket] < 0) {
+      mBucketPoses[bucket] = static_cast<int>(mPoseTimes.size());
+      mPoseTimes.emplace_back(std::min(bucket * stepTicks, clipDuration));
+    }
+    mInstancePoses[i] = static_cast<unsigned int>(mBucketPoses[bucket]);
+  }
+
+  size_t numPoses = mPoseTimes.size();
+  mStats.pcHits += static_cast<unsigned int>(numInstances - numPoses);
+
+  /* the instances do not own the cached poses, the playback cursors cannot be used */
+  mPoses.resize(numPoses * numBones);
+  float workTime = JobSystem::parallelFor(numPoses, 8, [&](size_t begin, size_t end) {
+    AssimpAnimSampler::sampleClip(clip, mPoseTimes.data() + begin, end - begin, numBones, mPoses.data() + begin * numBones,
+      nullptr, useNlerp);
+  });
+
+  workTime += JobSystem::parallelFor(numInstances, 64, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      std::copy_n(mPoses.data() + mInstancePoses[i] * numBones, numBones, out + i * numBones);
+    }
+  });
+  return workTime;
+}
@@ -0,0 +1,325 @@
+#include <cmath>
+
+#include "Model/AssimpTransformKernels.hpp"
+#include "Model/AssimpAnimKernels.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TRANSFORM_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+/* MSVC allows all intrinsics without extra compiler flags */
+#define TRANSFORM_TARGET_AVX2
+#else
+#define TRANSFORM_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+/* degrees to radians, halved for the quaternion */
+static const float degreesToHalfRadians = 3.14159265358979f / 360.0f;
+
+static inline size_t getInstanceIndex(const uint32_t* indices, size_t i) {
+  return indices ? indices[i] : i;
+}
+
+/* scalar version, also used for the instances that do not fill a full SIMD register */
+static void buildWorldMatricesScalar(const glm::vec3* positions, const glm::vec3* rotations, const float* scales, const uint8_t* swapYZAxis,
+    const glm::mat4& modelRootMatrix, const uint32_t* indices, size_t start, size_t numIndices, glm::mat4* worldMatrices) {
+  for (size_t i = start; i < numIndices; ++i) {
+    size_t index = getInstanceIndex(indices, i);
+
+    /* glm::quat(eulerAngles) */
+    glm::vec3 halfAngles = rotations[index] * degreesToHalfRadians;
+    glm::vec3 c = glm::cos(halfAngles);
+    glm::vec3 s = glm::sin(halfAngles);
+    float qw = c.x * c.y * c.z + s.x * s.y * s.z;
+    float qx = s.x * c.y * c.z - c.x * s.y * s.z;
+    float qy = c.x * s.y * c.z + s.x * c.y * s.z;
+    float qz = c.x * c.y * s.z - s.x * s.y * c.z;
+
+    /* glm::mat3_cast() */
+    glm::vec3 axes[3] = {
+      glm::vec3(1.0f - 2.0f * (qy * qy + qz * qz), 2.0f * (qx * qy + qw * qz), 2.0f * (qx * qz - qw * qy)),
+      glm::vec3(2.0f * (qx * qy - qw * qz), 1.0f - 2.0f * (qx * qx + qz * qz), 2.0f * (qy * qz + qw * qx)),
+      glm::vec3(2.0f * (qx * qz + qw * qy), 2.0f * (qy * qz - qw * qx), 1.0f - 2.0f * (qx * qx + qy * qy))
+    };
+
+    /* the swap matrix only moves the columns of the rotation: x <- z, y <- x, z <- y */
+    if (swapYZAxis[index] != 0) {
+      glm::vec3 axisZ = axes[2];
+      axes[2] = axes[1];
+      axes[1] = axes[0];
+      axes[0] = axisZ;
+    }
+
+    float scale = scales[index];
+    glm::vec3 position = positions[index];
+    glm::mat4& worldMatrix = worldMatrices[index];
+    for (int col = 0; col < 4; ++col) {
+      const glm::vec4& root = modelRootMatrix[col];
+      worldMatrix[col] = glm::vec4((axes[0] * root.x + axes[1] * root.y + axes[2] * root.z) * scale + position * root.w, root.w);
+    }
+  }
+}
+
+#if defined(TRANSFORM_KERNELS_X86)
+/* input of one SIMD iteration, gathered from the arrays of the instances */
+struct TransformLanes {
+  static constexpr unsigned int maxLanes = 8;
+
+  alignas(32) float position[3][maxLanes];
+  alignas(32) float halfAngle[3][maxLanes];
+  alignas(32) float scale[maxLanes];
+  alignas(32) float swapYZAxis[maxLanes];
+};
+
+static inline void gatherLanes(const glm::vec3* positions, const glm::vec3* rotations, const float* scales, const uint8_t* swapYZAxis,
+    const uint32_t* indices, size_t first, unsigned int numLanes, TransformLanes& lanes) {
+  for (unsigned int lane = 0; lane < numLanes; ++lane) {
+    size_t index = getInstanceIndex(indices, first + lane);
+    for (int c = 0; c < 3; ++c) {
+      lanes.position[c][lane] = positions[index][c];
+      lanes.halfAngle[c][lane] = rotations[index][c] * degreesToHalfRadians;
+    }
+    lanes.scale[lane] = scales[index];
+    lanes.swapYZAxis[lane] = swapYZAxis[index] != 0 ? 1.0f : 0.0f;
+  }
+}
+
+/* Cody-Waite reduction to [-pi/4, pi/4] with pi/2 split in three parts, and the Cephes sinf/cosf polynomials.
+ * the error is below 1e-7 for the angles used by the instances */
+static const float piOverTwoParts[3] = { 1.5703125f, 4.837512969970703125e-4f, 7.54978995489188216e-8f };
+static const float sinPolyCoeffs[3] = { -1.6666654611e-1f, 8.3321608736e-3f, -1.9515295891e-4f };
+static const float cosPolyCoeffs[3] = { 4.166664568298827e-2f, -1.388731625493765e-3f, 2.443315711809948e-5f };
+
+static inline void sinCosSse(__m128 x, __m128& sinResult, __m128& cosResult) {
+  __m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(0.63661977236758f)));
+  __m128 j = _mm_cvtepi32_ps(quadrant);
+  __m128 r = _mm_sub_ps(x, _mm_mul_ps(j, _mm_set1_ps(piOverTwoParts[0])));
+  r = _mm_sub_ps(r, _mm_mul_ps(j, _mm_set1_ps(piOverTwoParts[1])));
+  r = _mm_sub_ps(r, _mm_mul_ps(j, _mm_set1_ps(piOverTwoParts[2])));
+  __m128 r2 = _mm_mul_ps(r, r);
+
+  __m128 sinPoly = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(sinPolyCoeffs[2]), r2), _mm_set1_ps(sinPolyCoeffs[1]));
+  sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, r2), _mm_set1_ps(sinPolyCoeffs[0]));
+  __m128 sinR = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(sinPoly, r2), r));
+
+  __m128 cosPoly = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(cosPolyCoeffs[2]), r2), _mm_set1_ps(cosPolyCoeffs[1]));
+  cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, r2), _mm_set1_ps(cosPolyCoeffs[0]));
+  __m128 cosR = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(r2, _mm_set1_ps(0.5f))), _mm_mul_ps(_mm_mul_ps(cosPoly, r2), r2));
+
+  /* odd quadrants swap sine and cosine, the signs follow the quadrant */
+  __m128 swapMask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+  __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+  __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+  sinResult = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swapMask, cosR), _mm_andnot_ps(swapMask, sinR)), sinSign);
+  cosResult = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swapMask, sinR), _mm_andnot_ps(swapMask, cosR)), cosSign);
+}
+
+static inline __m128 selectSse(__m128 mask, __m128 ifTrue, __m128 ifFalse) {
+  return _mm_or_ps(_mm_and_ps(mask, ifTrue), _mm_andnot_ps(mask, ifFalse));
+}
+
+static void buildWorldMatricesSse(const glm::vec3* positions, const glm::vec3* rotations, const float* scales, const uint8_t* swapYZAxis,
+    const glm::mat4& modelRootMatrix, const uint32_t* indices, size_t numIndices, glm::mat4* worldMatrices) {
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 two = _mm_set1_ps(2.0f);
+
+  TransformLanes lanes;
+  size_t simdIndices = numIndices & ~static_cast<size_t>(3);
+  for (size_t i = 0; i < simdIndices; i += 4) {
+    gatherLanes(positions, rotations, scales, swapYZAxis, indices, i, 4, lanes);
+
+    __m128 s[3];
+    __m128 c[3];
+    for (int axis = 0; axis < 3; ++axis) {
+      sinCosSse(_mm_load_ps(lanes.halfAngle[axis]), s[axis], c[axis]);
+    }
+
+    __m128 qw = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(c[0], c[1]), c[2]), _mm_mul_ps(_mm_mul_ps(s[0], s[1]), s[2]));
+    __m128 qx = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(s[0], c[1]), c[2]), _mm_mul_ps(_mm_mul_ps(c[0], s[1]), s[2]));
+    __m128 qy = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(c[0], s[1]), c[2]), _mm_mul_ps(_mm_mul_ps(s[0], c[1]), s[2]));
+    __m128 qz = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(c[0], c[1]), s[2]), _mm_mul_ps(_mm_mul_ps(s[0], s[1]), c[2]));
+
+    __m128 xx = _mm_mul_ps(qx, qx);
+    __m128 yy = _mm_mul_ps(qy, qy);
+    __m128 zz = _mm_mul_ps(qz, qz);
+    __m128 xy = _mm_mul_ps(qx, qy);
+    __m128 xz = _mm_mul_ps(qx, qz);
+    __m128 yz = _mm_mul_ps(qy, qz);
+    __m128 wx = _mm_mul_ps(qw, qx);
+    __m128 wy = _mm_mul_ps(qw, qy);
+    __m128 wz = _mm_mul_ps(qw, qz);
+
+    /* axes[column][row] of the rotation */
+    __m128 axes[3][3] = {
+      { _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), _mm_mul_ps(two, _mm_add_ps(xy, wz)), _mm_mul_ps(two, _mm_sub_ps(xz, wy)) },
+      { _mm_mul_ps(two, _mm_sub_ps(xy, wz)), _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), _mm_mul_ps(two, _mm_add_ps(yz, wx)) },
+      { _mm_mul_ps(two, _mm_add_ps(xz, wy)), _mm_mul_ps(two, _mm_sub_ps(yz, wx)), _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))) }
+    };
+
+    __m128 swapMask = _mm_cmpgt_ps(_mm_load_ps(lanes.swapYZAxis), _mm_setzero_ps());
+    __m128 scale = _mm_load_ps(lanes.scale);
+    __m128 position[3];
+    for (int row = 0; row < 3; ++row) {
+      __m128 axisX = selectSse(swapMask, axes[2][row], axes[0][row]);
+      __m128 axisY = selectSse(swapMask, axes[0][row], axes[1][row]);
+      __m128 axisZ = selectSse(swapMask, axes[1][row], axes[2][row]);
+      axes[0][row] = _mm_mul_ps(axisX, scale);
+      axes[1][row] = _mm_mul_ps(axisY, scale);
+      axes[2][row] = _mm_mul_ps(axisZ, scale);
+      position[row] = _mm_load_ps(lanes.position[row]);
+    }
+
+    for (int col = 0; col < 4; ++col) {
+      const glm::vec4& root = modelRootMatrix[col];
+      __m128 rootX = _mm_set1_ps(root.x);
+      __m128 rootY = _mm_set1_ps(root.y);
+      __m128 rootZ = _mm_set1_ps(root.z);
+      __m128 rootW = _mm_set1_ps(root.w);
+
+      __m128 rows[4];
+      for (int row = 0; row < 3; ++row) {
+        rows[row] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(axes[0][row], rootX), _mm_mul_ps(axes[1][row], rootY)),
+          _mm_add_ps(_mm_mul_ps(axes[2][row], rootZ), _mm_mul_ps(position[row], rootW)));
+      }
+      rows[3] = rootW;
+
+      /* one column of the four matrices */
+      _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+      for (int lane = 0; lane < 4; ++lane) {
+        _mm_storeu_ps(&worldMatrices[getInstanceIndex(indices, i + lane)][col][0], rows[lane]);
+      }
+    }
+  }
+  buildWorldMatricesScalar(positions, rotations, scales, swapYZAxis, modelRootMatrix, indices, simdIndices, numIndices, worldMatrices);
+}
+
+TRANSFORM_TARGET_AVX2 static inline void sinCosAvx2(__m256 x, __m256& sinResult, __m256& cosResult) {
+  __m256i quadrant = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(0.63661977236758f)));
+  __m256 j = _mm256_cvtepi32_ps(quadrant);
+  __m256 r = _mm256_sub_ps(x, _mm256_mul_ps(j, _mm256_set1_ps(piOverTwoParts[0])));
+  r = _mm256_sub_ps(r, _mm256_mul_ps(j, _mm256_set1_ps(piOverTwoParts[1])));
+  r = _mm256_sub_ps(r, _mm256_mul_ps(j, _mm256_set1_ps(piOverTwoParts[2])));
+  __m256 r2 = _mm256_mul_ps(r, r);
+
+  __m256 sinPoly = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(sinPolyCoeffs[2]), r2), _mm256_set1_ps(sinPolyCoeffs[1]));
+  sinPoly = _mm256_add_ps(_mm256_mul_ps(sinPoly, r2), _mm256_set1_ps(sinPolyCoeffs[0]));
+  __m256 sinR = _mm256_add_ps(r, _mm256_mul_ps(_mm256_mul_ps(sinPoly, r2), r));
+
+  __m256 cosPoly = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(cosPolyCoeffs[2]), r2), _mm256_set1_ps(cosPolyCoeffs[1]));
+  cosPoly = _mm256_add_ps(_mm256_mul_ps(cosPoly, r2), _mm256_set1_ps(cosPolyCoeffs[0]));
+  __m256 cosR = _mm256_add_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(r2, _mm256_set1_ps(0.5f))),
+    _mm256_mul_ps(_mm256_mul_ps(cosPoly, r2), r2));
+
+  __m256 swapMask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+  __m256 sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(quadrant, _mm256_set1_epi32(2)), 30));
+  __m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(quadrant, _mm256_set1_epi32(1)),
+    _mm256_set1_epi32(2)), 30));
+  sinResult = _mm256_xor_ps(_mm256_blendv_ps(sinR, cosR, swapMask), sinSign);
+  cosResult = _mm256_xor_ps(_mm256_blendv_ps(cosR, sinR, swapMask), cosSign);
+}
+
+TRANSFORM_TARGET_AVX2 static void buildWorldMatricesAvx2(const glm::vec3* positions, const glm::vec3* rotations, const float* scales,
+    const uint8_t* swapYZAxis, const glm::mat4& modelRootMatrix, const uint32_t* indices, size_t numIndices, glm::mat4* worldMatrices) {
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 two = _mm256_set1_ps(2.0f);
+
+  TransformLanes lanes;
+  size_t simdIndices = numIndices & ~static_cast<size_t>(7);
+  for (size_t i = 0; i < simdIndices; i += 8) {
+    gatherLanes(positions, rotations, scales, swapYZAxis, indices, i, 8, lanes);
+
+    __m256 s[3];
+    __m256 c[3];
+    for (int axis = 0; axis < 3; ++axis) {
+      sinCosAvx2(_mm256_load_ps(lanes.halfAngle[axis]), s[axis], c[axis]);
+    }
+
+    __m256 qw = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(c[0], c[1]), c[2]), _mm256_mul_ps(_mm256_mul_ps(s[0], s[1]), s[2]));
+    __m256 qx = _mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(s[0], c[1]), c[2]), _mm256_mul_ps(_mm256_mul_ps(c[0], s[1]), s[2]));
+    __m256 qy = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(c[0], s[1]), c[2]), _mm256_mul_ps(_mm256_mul_ps(s[0], c[1]), s[2]));
+    __m256 qz = _mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(c[0], c[1]), s[2]), _mm256_mul_ps(_mm256_mul_ps(s[0], s[1]), c[2]));
+
+    __m256 xx = _mm256_mul_ps(qx, qx);
+    __m256 yy = _mm256_mul_ps(qy, qy);
+    __m256 zz = _mm256_mul_ps(qz, qz);
+    __m256 xy = _mm256_mul_ps(qx, qy);
+    __m256 xz = _mm256_mul_ps(qx, qz);
+    __m256 yz = _mm256_mul_ps(qy, qz);
+    __m256 wx = _mm256_mul_ps(qw, qx);
+    __m256 wy = _mm256_mul_ps(qw, qy);
+    __m256 wz = _mm256_mul_ps(qw, qz);
+
+    __m256 axes[3][3] = {
+      { _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), _mm256_mul_ps(two, _mm256_add_ps(xy, wz)),
+        _mm256_mul_ps(two, _mm256_sub_ps(xz, wy)) },
+      { _mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))),
+        _mm256_mul_ps(two, _mm256_add_ps(yz, wx)) },
+      { _mm256_mul_ps(two, _mm256_add_ps(xz, wy)), _mm256_mul_ps(two, _mm256_sub_ps(yz, wx)),
+        _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))) }
+    };
+
+    __m256 swapMask = _mm256_cmp_ps(_mm256_load_ps(lanes.swapYZAxis), _mm256_setzero_ps(), _CMP_GT_OQ);
+    __m256 scale = _mm256_load_ps(lanes.scale);
+    __m256 position[3];
+    for (int row = 0; row < 3; ++row) {
+      __m256 axisX = _mm256_blendv_ps(axes[0][row], axes[2][row], swapMask);
+      __m256 axisY = _mm256_blendv_ps(axes[1][row], axes[0][row], swapMask);
+      __m256 axisZ = _mm256_blendv_ps(axes[2][row], axes[1][row], swapMask);
+      axes[0][row] = _mm256_mul_ps(axisX, scale);
+      axes[1][row] = _mm256_mul_ps(axisY, scale);
+      axes[2][row] = _mm256_mul_ps(axisZ, scale);
+      position[row] = _mm256_load_ps(lanes.position[row]);
+    }
+
+    for (int col = 0; col < 4; ++col) {
+      const glm::vec4& root = modelRootMatrix[col];
+      __m256 rootX = _mm256_set1_ps(root.x);
+      __m256 rootY = _mm256_set1_ps(root.y);
+      __m256 rootZ = _mm256_set1_ps(root.z);
+      __m256 rootW = _mm256_set1_ps(root.w);
+
+      __m256 rows[4];
+      for (int row = 0; row < 3; ++row) {
+        rows[row] = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(axes[0][row], rootX), _mm256_mul_ps(axes[1][row], rootY)),
+          _mm256_add_ps(_mm256_mul_ps(axes[2][row], rootZ), _mm256_mul_ps(position[row], rootW)));
+      }
+      rows[3] = rootW;
+
+      /* 4x4 transposes in both 128 bit halves, the low half has the lanes 0-3, the high half the lanes 4-7 */
+      __m256 t0 = _mm256_unpacklo_ps(rows[0], rows[1]);
+      __m256 t1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+      __m256 t2 = _mm256_unpacklo_ps(rows[2], rows[3]);
+      __m256 t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+      __m256 columns[4] = {
+        _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)),
+        _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)),
+        _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)),
+        _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2))
+      };
+      for (int lane = 0; lane < 4; ++lane) {
+        _mm_storeu_ps(&worldMatrices[getInstanceIndex(indices, i + lane)][col][0], _mm256_castps256_ps128(columns[lane]));
+        _mm_storeu_ps(&worldMatrices[getInstanceIndex(indices, i + lane + 4)][col][0], _mm256_extractf128_ps(columns[lane], 1));
+      }
+    }
+  }
+  buildWorldMatricesScalar(positions, rotations, scales, swapYZAxis, modelRootMatrix, indices, simdIndices, numIndices, worldMatrices);
+}
+#endif
+
+void AssimpTransformKernels::buildWorldMatrices(const glm::vec3* positions, const glm::vec3* rotations, const float* scales,
+    const uint8_t* swapYZAxis, const glm::mat4& modelRootMatrix, const uint32_t* indices, size_t numIndices, glm::mat4* worldMatrices) {
+  switch (AssimpAnimKernels::getSimdLevel()) {
+#if defined(TRANSFORM_KERNELS_X86)
+    case simdLevel::avx2:
+      buildWorldMatricesAvx2(positions, rotations, scales, swapYZAxis, modelRootMatrix, indices, numIndices, worldMatrices);
+      break;
+    case simdLevel::sse:
+      buildWorldMatricesSse(positions, rotations, scales, swapYZAxis, modelRootMatrix, indices, numIndices, worldMatrices);
+      break;
+#endif
+    default:
+      buildWorldMatricesScalar(positions, rotations, scales, swapYZAxis, modelRootMatrix, indices, 0, numIndices, worldMatrices);
+      break;
+  }
+}
@@ -10,8 +10,11 @@
 #include <LoadShaders.hpp>
 #include "OpenGL/OGLRenderer.hpp"
 #include "Model/InstanceSettings.hpp"
+#include "Model/AssimpAnimSampler.hpp"
+#include "Model/AssimpPoseCache.hpp"
 #include "Tools/Logger.hpp"
 #include "Tools/Camera.hpp"
+#include "Tools/AllocationCounter.hpp"
 
 OGLRenderer::OGLRenderer(GLFWwindow *window)
 {
@@ -60,6 +63,8 @@ bool OGLRenderer::init(unsigned int width, unsigned int height)
 
   mAssimpSkinningShader.loadShaders("../resources/assimp_skinning.vert", "../resources/assimp_skinning.frag");
 
+  mAssimpBakedSkinningShader.loadShaders("../resources/assimp_skinning_baked.vert", "../resources/assimp_skinning.frag");
+
   mAssimpShader.setInt("numLights", 0);
 
 
@@ -76,6 +81,11 @@ Logger::log(1, "%s: Assimp GPU node transform compute shader loading failed\n",
 mAssimpMatrixComputeShader.loadComputerShader("../resources/assimp_instance_matrix_mult.comp"); 
     Logger::log(1, "%s: Assimp GPU matrix compute shader loading failed\n", __FUNCTION__);
 
+  mAssimpTransformLevelsComputeShader.loadComputerShader("../resources/assimp_instance_transform_levels.comp");
+
+  mAssimpPreSkinningComputeShader.loadComputerShader("../resources/assimp_pre_skinning.comp");
+  mAssimpPreSkinnedShader.loadShaders("../resources/assimp_pre_skinned.vert", "../resources/assimp_skinning.frag");
+
 
 
   Logger::log(1, "%s: shaders successfully loaded\n", __FUNCTION__);
@@ -89,9 +99,20 @@ mAssimpMatrixComputeShader.loadComputerShader("../resources/assimp_instance_matr
   glLineWidth(3.0);
   Logger::log(1, "%s: rendering defaults set\n", __FUNCTION__);
 
+  /* the job system uses all hardware threads, the UI can send some of them to sleep */
+  JobSystem::init();
+  mRenderData.rdJobMaxThreadCount = JobSystem::getThreadCount();
+  mRenderData.rdJobThreadCount = mRenderData.rdJobMaxThreadCount;
+
   /* SSBO init */
   mShaderBoneMatrixBuffer.init(256);
+  mPreSkinnedVertexBuffer.init(256);
   mWorldPosBuffer.init(256);
+  if (!mFrameDataBuffer.init(mFrameDataStartSize))
+  {
+    Logger::log(1, "%s error: could not create the per-frame SSBO ring\n", __FUNCTION__);
+    return false;
+  }
   Logger::log(1, "%s: SSBOs initialized\n", __FUNCTION__);
 
   /* register callbacks */
@@ -112,6 +133,9 @@ mAssimpMatrixComputeShader.loadComputerShader("../resources/assimp_instance_matr
   mModelInstData.miInstanceCloneCallbackFunction = [this](std::shared_ptr<AssimpInstance> instance)
   { cloneInstance(instance); };
 
+  mModelInstData.miBenchmarkRunCallbackFunction = [this](benchmarkType type, std::shared_ptr<AssimpModel> model)
+  { runBenchmark(type, model); };
+
   mFrameTimer.start();
 
   return true;
@@ -160,17 +184,23 @@ void OGLRenderer::deleteModel(std::string modelFileName)
         std::remove_if(
             mModelInstData.miAssimpInstances.begin(),
             mModelInstData.miAssimpInstances.end(),
-            [shortModelFileName](std::shared_ptr<AssimpInstance> instance)
+            [shortModelFileName](const std::shared_ptr<AssimpInstance> &instance)
             { return instance->getModel()->getModelFileName() == shortModelFileName; }),
         mModelInstData.miAssimpInstances.end());
-  }
 
-  if (mModelInstData.miAssimpInstancesPerModel.count(shortModelFileName) > 0)
-  {
-    mModelInstData.miAssimpInstancesPerModel[shortModelFileName].clear();
-    mModelInstData.miAssimpInstancesPerModel.erase(shortModelFileName);
+    for (size_t i = 0; i < mModelInstData.miAssimpInstances.size(); ++i)
+    {
+      mModelInstData.miAssimpInstances[i]->setInstanceListIndex(i);
+    }
   }
 
+  /* the instances still referenced somewhere else keep a copy of their data */
+  mModelInstData.miInstanceStores.erase(shortModelFileName);
+  /* a new store may get the address of the deleted one */
+  mWorldPosRegionStores.clear();
+  mWorldPosRegionSizes.clear();
+  mWorldPosRegionOffsets.clear();
+
   /* add models to pending delete list */
   for (const auto &model : mModelInstData.miModelList)
   {
@@ -190,11 +220,26 @@ void OGLRenderer::deleteModel(std::string modelFileName)
   updateTriangleCount();
 }
 
+std::shared_ptr<AssimpInstanceStore> OGLRenderer::getInstanceStore(std::shared_ptr<AssimpModel> model)
+{
+  std::shared_ptr<AssimpInstanceStore> &store = mModelInstData.miInstanceStores[model->getModelFileName()];
+  if (!store)
+  {
+    store = std::make_shared<AssimpInstanceStore>(model);
+  }
+  return store;
+}
+
+void OGLRenderer::appendInstance(std::shared_ptr<AssimpInstance> instance)
+{
+  instance->setInstanceListIndex(mModelInstData.miAssimpInstances.size());
+  mModelInstData.miAssimpInstances.emplace_back(std::move(instance));
+}
+
 std::shared_ptr<AssimpInstance> OGLRenderer::addInstance(std::shared_ptr<AssimpModel> model)
 {
-  std::shared_ptr<AssimpInstance> newInstance = std::make_shared<AssimpInstance>(model);
-  mModelInstData.miAssimpInstances.emplace_back(newInstance);
-  mModelInstData.miAssimpInstancesPerModel[model->getModelFileName()].emplace_back(newInstance);
+  std::shared_ptr<AssimpInstance> newInstance = getInstanceStore(model)->addInstance();
+  appendInstance(newInstance);
 
   updateTriangleCount();
 
@@ -203,6 +248,10 @@ std::shared_ptr<AssimpInstance> OGLRenderer::addInstance(std::shared_ptr<AssimpM
 
 void OGLRenderer::addInstances(std::shared_ptr<AssimpModel> model, int numInstances)
 {
+  std::shared_ptr<AssimpInstanceStore> store = getInstanceStore(model);
+  store->reserve(store->size() + numInstances);
+  mModelInstData.miAssimpInstances.reserve(mModelInstData.miAssimpInstances.size() + numInstances);
+
   size_t animClipNum = model->getAnimClips().size();
   for (int i = 0; i < numInstances; ++i)
   {
@@ -211,7 +260,7 @@ void OGLRenderer::addInstances(std::shared_ptr<AssimpModel> model, int numInstan
     int rotation = std::rand() % 360 - 180;
     int clipNr = std::rand() % animClipNum;
 
-    std::shared_ptr<AssimpInstance> newInstance = std::make_shared<AssimpInstance>(model, glm::vec3(xPos, 0.0f, zPos), glm::vec3(0.0f, rotation, 0.0f));
+    std::shared_ptr<AssimpInstance> newInstance = store->addInstance(glm::vec3(xPos, 0.0f, zPos), glm::vec3(0.0f, rotation, 0.0f));
     if (animClipNum > 0)
     {
       InstanceSettings instSettings = newInstance->getInstanceSettings();
@@ -219,30 +268,31 @@ void OGLRenderer::addInstances(std::shared_ptr<AssimpModel> model, int numInstan
       newInstance->setInstanceSettings(instSettings);
     }
 
-    mModelInstData.miAssimpInstances.emplace_back(newInstance);
-    mModelInstData.miAssimpInstancesPerModel[model->getModelFileName()].emplace_back(newInstance);
+    appendInstance(newInstance);
   }
   updateTriangleCount();
 }
 
 void OGLRenderer::deleteInstance(std::shared_ptr<AssimpInstance> instance)
 {
-  std::shared_ptr<AssimpModel> currentModel = instance->getModel();
-  std::string currentModelName = currentModel->getModelFileName();
+  std::vector<std::shared_ptr<AssimpInstance>> &instances = mModelInstData.miAssimpInstances;
+  size_t listIndex = instance->getInstanceListIndex();
+  AssimpInstanceStore *store = instance->getInstanceStore();
+  if (listIndex >= instances.size() || instances.at(listIndex) != instance || !store)
+  {
+    Logger::log(1, "%s error: instance is not in the instance list\n", __FUNCTION__);
+    return;
+  }
 
-  mModelInstData.miAssimpInstances.erase(
-      std::remove_if(
-          mModelInstData.miAssimpInstances.begin(),
-          mModelInstData.miAssimpInstances.end(),
-          [instance](std::shared_ptr<AssimpInstance> inst)
-          { return inst == instance; }));
+  /* both removals are O(1), the last instance takes the place of the deleted one */
+  if (listIndex + 1 != instances.size())
+  {
+    instances.at(listIndex) = std::move(instances.back());
+    instances.at(listIndex)->setInstanceListIndex(listIndex);
+  }
+  instances.pop_back();
 
-  mModelInstData.miAssimpInstancesPerModel[currentModelName].erase(
-      std::remove_if(
-          mModelInstData.miAssimpInstancesPerModel[currentModelName].begin(),
-          mModelInstData.miAssimpInstancesPerModel[currentModelName].end(),
-          [instance](std::shared_ptr<AssimpInstance> inst)
-          { return inst == instance; }));
+  store->removeInstance(instance->getInstanceHandle());
 
   updateTriangleCount();
 }
@@ -250,25 +300,83 @@ void OGLRenderer::deleteInstance(std::shared_ptr<AssimpInstance> instance)
 void OGLRenderer::cloneInstance(std::shared_ptr<AssimpInstance> instance)
 {
   std::shared_ptr<AssimpModel> currentModel = instance->getModel();
-  std::shared_ptr<AssimpInstance> newInstance = std::make_shared<AssimpInstance>(currentModel);
+  std::shared_ptr<AssimpInstance> newInstance = getInstanceStore(currentModel)->addInstance();
   InstanceSettings newInstanceSettings = instance->getInstanceSettings();
 
   /* slight offset to see new instance */
   newInstanceSettings.isWorldPosition += glm::vec3(1.0f, 0.0f, -1.0f);
   newInstance->setInstanceSettings(newInstanceSettings);
 
-  mModelInstData.miAssimpInstances.emplace_back(newInstance);
-  mModelInstData.miAssimpInstancesPerModel[currentModel->getModelFileName()].emplace_back(newInstance);
+  appendInstance(newInstance);
 
   updateTriangleCount();
 }
 
+void OGLRenderer::runBenchmark(benchmarkType type, std::shared_ptr<AssimpModel> model)
+{
+  switch (type)
+  {
+  case benchmarkType::animSampling:
+    mModelInstData.miBenchmarkResults.emplace_back(Benchmark::animSampling(model, 1000, 300));
+    break;
+  case benchmarkType::animBatchSampling:
+    mModelInstData.miBenchmarkResults.emplace_back(Benchmark::animBatchSampling(model, 1000, 300));
+    break;
+  case benchmarkType::animSimdInterpolation:
+    mModelInstData.miBenchmarkResults.emplace_back(Benchmark::animSimdInterpolation(model, 1000, 300));
+    break;
+  case benchmarkType::animPoseCache:
+    mModelInstData.miBenchmarkResults.emplace_back(Benchmark::animPoseCache(model, 10000, 100, mRenderData.rdPoseCacheStep));
+    break;
+  case benchmarkType::animKeyCompression:
+    mModelInstData.miBenchmarkResults.emplace_back(Benchmark::animKeyCompression(model, 1000, 300));
+    break;
+  case benchmarkType::boneHierarchy:
+    mModelInstData.miBenchmarkResults.emplace_back(Benchmark::boneHierarchy(1000, 256, 64, 10));
+    break;
+  case benchmarkType::jobSystemStress:
+    mModelInstData.miBenchmarkResults.emplace_back(Benchmark::jobSystemStress(100000));
+    break;
+  case benchmarkType::worldMatrixBuild:
+    for (unsigned int numInstances : { 10000u, 100000u, 1000000u })
+    {
+      mModelInstData.miBenchmarkResults.emplace_back(Benchmark::worldMatrixBuild(numInstances, 10));
+    }
+    break;
+  default:
+    Logger::log(1, "%s error: unknown benchmark type %i\n", __FUNCTION__, static_cast<int>(type));
+    break;
+  }
+}
+
+void OGLRenderer::uploadWorldPosRanges(AssimpInstanceStore &store, size_t regionOffset)
+{
+  /* runs of dirty records are merged if the gap between them is small */
+  const std::vector<uint32_t> &dirtyIndices = store.getDirtyIndices();
+  const std::vector<InstanceTransformRecord> &transformRecords = store.getTransformRecords();
+  size_t i = 0;
+  while (i < dirtyIndices.size())
+  {
+    size_t rangeStart = dirtyIndices.at(i);
+    size_t rangeEnd = rangeStart + 1;
+    ++i;
+    while (i < dirtyIndices.size() && dirtyIndices.at(i) <= rangeEnd + mWorldPosMergeGap)
+    {
+      rangeEnd = dirtyIndices.at(i) + 1;
+      ++i;
+    }
+
+    mWorldPosBuffer.uploadSsboRange(transformRecords.data() + rangeStart, rangeEnd - rangeStart, regionOffset + rangeStart);
+    mRenderData.rdMatricesSize += (rangeEnd - rangeStart) * sizeof(InstanceTransformRecord);
+  }
+}
+
 void OGLRenderer::updateTriangleCount()
 {
   mRenderData.rdTriangleCount = 0;
-  for (const auto &instance : mModelInstData.miAssimpInstances)
+  for (const auto &store : mModelInstData.miInstanceStores)
   {
-    mRenderData.rdTriangleCount += instance->getModel()->getTriangleCount();
+    mRenderData.rdTriangleCount += static_cast<unsigned int>(store.second->size()) * store.second->getModel()->getTriangleCount();
   }
 }
 
@@ -409,6 +517,49 @@ void OGLRenderer::handleMovementKeys()
   }
 }
 
+void OGLRenderer::updateFrustumPlanes()
+{
+  /* rows of the view projection matrix, see Gribb/Hartmann */
+  glm::mat4 viewProjectionMatrix = glm::transpose(mProjectionMatrix * mViewMatrix);
+
+  mFrustumPlanes[0] = viewProjectionMatrix[3] + viewProjectionMatrix[0];
+  mFrustumPlanes[1] = viewProjectionMatrix[3] - viewProjectionMatrix[0];
+  mFrustumPlanes[2] = viewProjectionMatrix[3] + viewProjectionMatrix[1];
+  mFrustumPlanes[3] = viewProjectionMatrix[3] - viewProjectionMatrix[1];
+  mFrustumPlanes[4] = viewProjectionMatrix[3] + viewProjectionMatrix[2];
+  mFrustumPlanes[5] = viewProjectionMatrix[3] - viewProjectionMatrix[2];
+
+  for (auto &plane : mFrustumPlanes)
+  {
+    plane /= glm::length(glm::vec3(plane));
+  }
+}
+
+size_t OGLRenderer::getBonePaletteVectors(bonePaletteFormat format)
+{
+  switch (format)
+  {
+    case bonePaletteFormat::affine3x4:
+      return 3;
+    case bonePaletteFormat::dualQuaternion:
+      return 2;
+    default:
+      return 4;
+  }
+}
+
+bool OGLRenderer::isSphereInFrustum(glm::vec3 center, float radius)
+{
+  for (const auto &plane : mFrustumPlanes)
+  {
+    if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
 bool OGLRenderer::draw(float deltaTime)
 {
   /* no update on zero diff */
@@ -427,13 +578,42 @@ bool OGLRenderer::draw(float deltaTime)
   mRenderData.rdFrameTime = mFrameTimer.stop();
   mFrameTimer.start();
 
+  uint64_t frameStartAllocations = AllocationCounter::getAllocations();
+  mRenderData.rdFrameAllocations = static_cast<unsigned int>(frameStartAllocations - mFrameStartAllocations);
+  mFrameStartAllocations = frameStartAllocations;
+
+  /* the part of the ring for this frame may still be read by the GPU */
+  mFrameDataBuffer.beginFrame();
+
   /* reset timers and other values */
   mRenderData.rdMatricesSize = 0;
+  mRenderData.rdPreSkinnedSize = 0;
   mRenderData.rdUploadToUBOTime = 0.0f;
   mRenderData.rdUploadToVBOTime = 0.0f;
   mRenderData.rdMatrixGenerateTime = 0.0f;
+  mRenderData.rdAnimUpdateTime = 0.0f;
+  mRenderData.rdAnimUpdateWorkTime = 0.0f;
+  mRenderData.rdAnimAllocations = 0;
+  mRenderData.rdPoseCacheLookups = 0;
+  mRenderData.rdAnimLodNearInstances = 0;
+  mRenderData.rdAnimLodMidInstances = 0;
+  mRenderData.rdAnimLodFarInstances = 0;
+  mRenderData.rdAnimLodSampledInstances = 0;
+  mRenderData.rdCulledInstances = 0;
+  mRenderData.rdDirtyInstances = 0;
+  mRenderData.rdPoseCacheHits = 0;
+  mRenderData.rdAnimBlendedInstances = 0;
+  mRenderData.rdAnimBlendLayers = 0;
+  mPoseCache.resetStatistics();
+  mAnimBlender.resetStatistics();
   mRenderData.rdUIGenerateTime = 0.0f;
 
+  /* thread count may have been changed in the UI */
+  if (static_cast<unsigned int>(mRenderData.rdJobThreadCount) != JobSystem::getActiveThreadCount())
+  {
+    JobSystem::setActiveThreadCount(mRenderData.rdJobThreadCount);
+  }
+
   handleMovementKeys();
 
   /* draw to framebuffer */
@@ -453,6 +633,7 @@ bool OGLRenderer::draw(float deltaTime)
       0.1f, 500.0f);
 
   mViewMatrix = mCamera.getViewMatrix(mRenderData);
+  updateFrustumPlanes();
 
   mRenderData.rdMatrixGenerateTime += mMatrixGenerateTimer.stop();
 
@@ -470,101 +651,701 @@ bool OGLRenderer::draw(float deltaTime)
   }
   mAssimpShader.setVec3("viewPos", mRenderData.rdCameraWorldPosition);
 
+  /* the animated models are collected, and computed and drawn after the other models */
+  mNodeTransFormData.clear();
+  mAnimBatchModels.clear();
+  mAnimBatchDraws.clear();
+  mAnimBatchRecords.clear();
+  mAnimBatchFrameTableModels.clear();
+  mAnimBatchFrameTableVersions.clear();
+  mAnimBatchWorkGroups = 0;
+  size_t animBatchBoneMatrices = 0;
+  size_t preSkinnedVertices = 0;
+  size_t animBatchBoneTableSize = 0;
+  size_t animBatchClipTableSize = 0;
+  size_t animBatchLevelOrderSize = 0;
+  size_t animBatchLevelOffsetSize = 0;
+
+  /* the transform records of the static models stay in the buffer, the regions are uploaded again after a resize only */
+  size_t staticInstances = 0;
+  size_t animatedInstances = 0;
+  for (const auto &modelType : mModelInstData.miInstanceStores)
+  {
+    std::shared_ptr<AssimpModel> model = modelType.second->getModel();
+    if (!model->hasAnimations() || model->getBoneList().empty())
+    {
+      staticInstances += modelType.second->size();
+    }
+    else if (!model->getUseBakedAnimations() || !model->hasBakedAnimations())
+    {
+      animatedInstances += modelType.second->size();
+    }
+  }
+  if (mWorldPosBuffer.checkForResize(staticInstances * sizeof(InstanceTransformRecord)))
+  {
+    mWorldPosRegionStores.clear();
+    mWorldPosRegionSizes.clear();
+    mWorldPosRegionOffsets.clear();
+  }
+  size_t worldPosRegion = 0;
+  size_t worldPosOffset = 0;
+
+  /* the culled instances are not written, but the ranges are reserved for all animated instances */
+  glm::mat4 *animWorldPosMatrices = mFrameDataBuffer.allocate<glm::mat4>(animatedInstances, mAnimWorldPosRange);
+  AnimInstanceRecord *animInstanceRecords = nullptr;
+  mAnimInstanceRecordRange = SsboRingRange{};
+  if (mRenderData.rdFusedBoneMatrices && mRenderData.rdGpuAnimSampling)
+  {
+    animInstanceRecords = mFrameDataBuffer.allocate<AnimInstanceRecord>(animatedInstances, mAnimInstanceRecordRange);
+  }
+  size_t animWorldPosCount = 0;
+
   /* draw the models */
-  for (const auto &modelType : mModelInstData.miAssimpInstancesPerModel)
+  for (const auto &modelType : mModelInstData.miInstanceStores)
   {
-    size_t numberOfInstances = modelType.second.size();
+    AssimpInstanceStore &store = *modelType.second;
+    size_t numberOfInstances = store.size();
+    bool isStaticModel = !store.getModel()->hasAnimations() || store.getModel()->getBoneList().empty();
+
+    /* only the instances with a changed transform get a new world matrix, or a new record for the static models */
+    mMatrixGenerateTimer.start();
+    if (isStaticModel)
+    {
+      store.updateTransformRecords();
+    }
+    else
+    {
+      store.updateWorldMatrices();
+    }
+    mRenderData.rdDirtyInstances += static_cast<unsigned int>(store.getDirtyIndices().size());
+    mRenderData.rdMatrixGenerateTime += mMatrixGenerateTimer.stop();
+
     if (numberOfInstances > 0)
     {
-      std::shared_ptr<AssimpModel> model = modelType.second.at(0)->getModel();
+      std::shared_ptr<AssimpModel> model = store.getModel();
+      const std::vector<std::shared_ptr<AssimpInstance>> &instances = store.getInstances();
+      const std::vector<glm::mat4> &worldMatrices = store.getWorldMatrices();
+      size_t numberOfDrawnInstances = numberOfInstances;
+
+      /* animated models with baked clips, no sampling and no compute passes */
+      if (model->hasAnimations() && !model->getBoneList().empty() && model->getUseBakedAnimations() && model->hasBakedAnimations())
+      {
+        size_t numberOfBones = model->getBoneList().size();
+
+        uint64_t animStartAllocations = AllocationCounter::getAllocations();
+        mMatrixGenerateTimer.start();
 
+        SsboRingRange worldPosRange{};
+        SsboRingRange bakedAnimRecordRange{};
+        glm::mat4 *worldPosMatrices = mFrameDataBuffer.allocate<glm::mat4>(numberOfInstances, worldPosRange);
+        BakedAnimRecord *bakedAnimRecords = mFrameDataBuffer.allocate<BakedAnimRecord>(numberOfInstances, bakedAnimRecordRange);
+
+        mAnimUpdateTimer.start();
+        const std::vector<unsigned int> &animClipNrs = store.getAnimClipNrs();
+        const std::vector<float> &animPlayTimes = store.getAnimPlayTimes();
+        mRenderData.rdAnimUpdateWorkTime += JobSystem::parallelFor(numberOfInstances, mAnimUpdateGrainSize, [&](size_t begin, size_t end)
+        {
+          for (size_t i = begin; i < end; ++i)
+          {
+            instances[i]->updateAnimationTime(deltaTime);
+            instances[i]->invalidateAnimLodPose();
+            bakedAnimRecords[i] = model->getBakedAnimRecord(animClipNrs[i], animPlayTimes[i]);
+            worldPosMatrices[i] = worldMatrices[i];
+          }
+        });
+        mRenderData.rdAnimUpdateTime += mAnimUpdateTimer.stop();
+        mRenderData.rdMatrixGenerateTime += mMatrixGenerateTimer.stop();
+        mRenderData.rdMatricesSize += numberOfInstances * (sizeof(glm::mat4) + sizeof(BakedAnimRecord));
+
+        mAssimpBakedSkinningShader.use();
+
+        mUploadToUBOTimer.start();
+        mAssimpBakedSkinningShader.setInt("aModelStride", numberOfBones);
+        model->bindBakedBoneMatrixBuffer(1);
+        mFrameDataBuffer.bind(worldPosRange, 2);
+        mFrameDataBuffer.bind(bakedAnimRecordRange, 3);
+        model->bindBakedClipBuffer(4);
+        mRenderData.rdUploadToUBOTime += mUploadToUBOTimer.stop();
+
+        mRenderData.rdAnimAllocations += static_cast<unsigned int>(AllocationCounter::getAllocations() - animStartAllocations);
+      }
       /* animated models */
-       if (model->hasAnimations() && !model->getBoneList().empty())
+      else if (model->hasAnimations() && !model->getBoneList().empty())
       {
         size_t numberOfBones = model->getBoneList().size();
 
+        /* the fused pass needs all bone matrices of an instance in shared memory, the GPU sampling needs the fused pass */
+        bool fusedBoneMatrices = mRenderData.rdFusedBoneMatrices && numberOfBones <= mMaxLevelOrderBones;
+        bool gpuSampling = fusedBoneMatrices && mRenderData.rdGpuAnimSampling;
+
+        /* nothing in here should allocate memory once the buffers have their final size */
+        uint64_t animStartAllocations = AllocationCounter::getAllocations();
         mMatrixGenerateTimer.start();
 
-        mNodeTransFormData.resize(numberOfInstances * numberOfBones);
-        mWorldPosMatrices.resize(numberOfInstances);
+        mAnimInstanceCulled.resize(numberOfInstances);
+        mAnimPlayTimes.resize(numberOfInstances);
+        mAnimChannelCursors.resize(numberOfInstances);
+        mAnimSlotIndices.resize(numberOfInstances);
+        mAnimSlotBlending.resize(numberOfInstances);
+
+        mAnimUpdateTimer.start();
+
+        /* advance the play time of all instances, every instance is touched by one thread only.
+         * the frustum culling and the animation LOD decide here if the instance is sampled in this frame */
+        const std::vector<glm::vec3> &positions = store.getPositions();
+        const std::vector<unsigned int> &animClipNrs = store.getAnimClipNrs();
+        const std::vector<float> &animPlayTimes = store.getAnimPlayTimes();
+        bool useAnimLod = mRenderData.rdAnimLodEnabled && !gpuSampling;
+        bool useFrustumCulling = mRenderData.rdFrustumCullingEnabled;
+        glm::vec4 boundingSphereCenter = glm::vec4(model->getBoundingSphereCenter(), 1.0f);
+        float boundingSphereRadius = model->getBoundingSphereRadius() * mRenderData.rdFrustumCullingMargin;
+        mRenderData.rdAnimUpdateWorkTime += JobSystem::parallelFor(numberOfInstances, mAnimUpdateGrainSize, [&](size_t begin, size_t end)
+        {
+          for (size_t i = begin; i < end; ++i)
+          {
+            instances[i]->updateAnimationTime(deltaTime);
+
+            /* the pose of a culled instance is sampled again once it is visible */
+            bool culled = false;
+            if (useFrustumCulling)
+            {
+              const glm::mat4 &worldMatrix = worldMatrices[i];
+              float maxScale = std::max(std::max(glm::length(glm::vec3(worldMatrix[0])), glm::length(glm::vec3(worldMatrix[1]))),
+                                        glm::length(glm::vec3(worldMatrix[2])));
+              culled = !isSphereInFrustum(glm::vec3(worldMatrix * boundingSphereCenter), boundingSphereRadius * maxScale);
+            }
+            mAnimInstanceCulled[i] = culled ? 1 : 0;
+
+            if (culled)
+            {
+              instances[i]->invalidateAnimLodPose();
+              instances[i]->setAnimLod(0, false);
+            }
+            else if (useAnimLod)
+            {
+              float distance = glm::length(positions[i] - mRenderData.rdCameraWorldPosition);
+              unsigned int lodLevel = 0;
+              unsigned int updateInterval = 1;
+              if (distance > mRenderData.rdAnimLodFarDistance)
+              {
+                lodLevel = 2;
+                updateInterval = mRenderData.rdAnimLodFarInterval;
+              }
+              else if (distance > mRenderData.rdAnimLodNearDistance)
+              {
+                lodLevel = 1;
+                updateInterval = mRenderData.rdAnimLodMidInterval;
+              }
+
+              bool skipUpdate = mAnimLodPosesValid && instances[i]->hasAnimLodPose() && (mAnimLodFrame + i) % updateInterval != 0;
+              instances[i]->setAnimLod(lodLevel, skipUpdate);
+            }
+            else
+            {
+              /* no pose is stored without the animation LOD */
+              instances[i]->invalidateAnimLodPose();
+              instances[i]->setAnimLod(0, false);
+            }
+          }
+        });
+
+        /* count the instances per clip, the skipped instances of a clip are placed behind the sampled ones.
+         * the culled instances are collected in a last group after all clips, they are not drawn */
+        const std::vector<std::shared_ptr<AssimpAnimClip>> &animClips = model->getAnimClips();
+        size_t culledGroup = animClips.size() * 2;
+        mAnimClipOffsets.assign(culledGroup + 2, 0);
+        for (size_t i = 0; i < numberOfInstances; ++i)
+        {
+          const std::shared_ptr<AssimpInstance> &instance = instances[i];
+          if (mAnimInstanceCulled[i])
+          {
+            ++mAnimClipOffsets.at(culledGroup + 1);
+            continue;
+          }
+
+          unsigned int group = animClipNrs[i] * 2 + (instance->getAnimLodSkip() ? 1 : 0);
+          ++mAnimClipOffsets.at(group + 1);
+
+          if (useAnimLod)
+          {
+            switch (instance->getAnimLodLevel())
+            {
+              case 0:
+                ++mRenderData.rdAnimLodNearInstances;
+                break;
+              case 1:
+                ++mRenderData.rdAnimLodMidInstances;
+                break;
+              default:
+                ++mRenderData.rdAnimLodFarInstances;
+                break;
+            }
+          }
+        }
+        for (size_t group = 1; group < mAnimClipOffsets.size(); ++group)
+        {
+          mAnimClipOffsets.at(group) += mAnimClipOffsets.at(group - 1);
+        }
+
+        /* the drawing order of the instances does not matter, group them by clip */
+        mAnimClipFillPositions.assign(mAnimClipOffsets.begin(), mAnimClipOffsets.end() - 1);
+        for (size_t i = 0; i < numberOfInstances; ++i)
+        {
+          size_t group = culledGroup;
+          if (!mAnimInstanceCulled[i])
+          {
+            group = animClipNrs[i] * 2 + (instances[i]->getAnimLodSkip() ? 1 : 0);
+          }
+          mAnimSlotIndices.at(mAnimClipFillPositions.at(group)++) = static_cast<unsigned int>(i);
+        }
+
+        /* only the visible instances are sampled, uploaded and drawn */
+        size_t numberOfVisibleInstances = mAnimClipOffsets.at(culledGroup);
+        mRenderData.rdCulledInstances += static_cast<unsigned int>(numberOfInstances - numberOfVisibleInstances);
+
+        /* the poses and world matrices are appended to the data of the previous animated models.
+         * models sampled on the GPU upload only the clip and the play time of the instances */
+        size_t boneDataOffset = animBatchBoneMatrices;
+        animBatchBoneMatrices += numberOfVisibleInstances * numberOfBones;
+        size_t nodeDataOffset = mNodeTransFormData.size();
+        size_t firstInstance = animWorldPosCount;
+        if (!gpuSampling)
+        {
+          mNodeTransFormData.resize(nodeDataOffset + numberOfVisibleInstances * numberOfBones);
+        }
+        animWorldPosCount += numberOfVisibleInstances;
+        NodeTransformData *nodeTransformData = mNodeTransFormData.data() + nodeDataOffset;
+        AnimInstanceRecord *instanceRecords = gpuSampling ? animInstanceRecords + mAnimBatchWorkGroups : nullptr;
+        glm::mat4 *worldPosMatrices = animWorldPosMatrices + firstInstance;
+
+        /* sample the clips in chunks of instances, each chunk writes only to its own slots.
+         * a chunk may span more than one group, split it at the group borders */
+        bool usePoseCache = mRenderData.rdPoseCacheEnabled && !gpuSampling;
+        mRenderData.rdAnimUpdateWorkTime += JobSystem::parallelFor(numberOfVisibleInstances, mAnimSampleGrainSize, [&](size_t begin, size_t end)
+        {
+          size_t group = std::upper_bound(mAnimClipOffsets.begin(), mAnimClipOffsets.end(), begin) - mAnimClipOffsets.begin() - 1;
+          size_t rangeStart = begin;
+          while (rangeStart < end)
+          {
+            size_t rangeEnd = std::min(end, static_cast<size_t>(mAnimClipOffsets.at(group + 1)));
+            bool skippedGroup = (group % 2) == 1;
+            for (size_t slot = rangeStart; slot < rangeEnd; ++slot)
+            {
+              unsigned int index = mAnimSlotIndices[slot];
+              AssimpInstance *instance = instances[index].get();
+              mAnimPlayTimes[slot] = animPlayTimes[index];
+              mAnimChannelCursors[slot] = instance->getAnimChannelCursors();
+              mAnimSlotBlending[slot] = !gpuSampling && !skippedGroup && instance->hasAnimBlending() ? 1 : 0;
+              worldPosMatrices[slot] = worldMatrices[index];
+              if (gpuSampling)
+              {
+                instanceRecords[slot].airClip = static_cast<int32_t>(group / 2);
+                instanceRecords[slot].airTime = mAnimPlayTimes[slot];
+              }
+              else if (skippedGroup)
+              {
+                instance->loadAnimLodPose(nodeTransformData + slot * numberOfBones);
+              }
+            }
+
+            if (!gpuSampling && !usePoseCache && !skippedGroup && rangeEnd > rangeStart)
+            {
+              AssimpAnimSampler::sampleClip(animClips.at(group / 2), mAnimPlayTimes.data() + rangeStart, rangeEnd - rangeStart, numberOfBones,
+                                            nodeTransformData + rangeStart * numberOfBones, mAnimChannelCursors.data() + rangeStart,
+                                            mRenderData.rdAnimUseNlerp);
+            }
+            rangeStart = rangeEnd;
+            ++group;
+          }
+        });
+
+        /* instances with the same clip and (nearly) the same play time share one sampled pose */
+        if (usePoseCache)
+        {
+          mPoseCache.setQuantizationStep(mRenderData.rdPoseCacheStep);
+          for (size_t clip = 0; clip < animClips.size(); ++clip)
+          {
+            size_t clipStart = mAnimClipOffsets.at(clip * 2);
+            size_t clipEnd = mAnimClipOffsets.at(clip * 2 + 1);
+            mRenderData.rdAnimUpdateWorkTime += mPoseCache.sampleClip(animClips.at(clip), mAnimPlayTimes.data() + clipStart, clipEnd - clipStart,
+                                                                      numberOfBones, nodeTransformData + clipStart * numberOfBones,
+                                                                      mRenderData.rdAnimUseNlerp);
+          }
+          mRenderData.rdPoseCacheLookups = mPoseCache.getStatistics().pcLookups;
+          mRenderData.rdPoseCacheHits = mPoseCache.getStatistics().pcHits;
+        }
+
+        /* blend the crossfades and layers over the sampled base clips, instances playing a single clip are not touched again */
+        mAnimBlender.clear();
+        for (size_t slot = 0; slot < numberOfVisibleInstances; ++slot)
+        {
+          if (mAnimSlotBlending[slot])
+          {
+            mAnimBlender.addInstance(instances[mAnimSlotIndices[slot]]->getInstanceSettings(), nodeTransformData + slot * numberOfBones);
+          }
+        }
+        mRenderData.rdAnimUpdateWorkTime += mAnimBlender.blendLayers(model, numberOfBones, mRenderData.rdAnimUseNlerp);
+        mRenderData.rdAnimBlendedInstances = mAnimBlender.getStatistics().absBlendedInstances;
+        mRenderData.rdAnimBlendLayers = mAnimBlender.getStatistics().absSampledLayers;
 
+        /* keep the sampled poses for the frames the instances are skipped */
+        if (useAnimLod)
+        {
+          mRenderData.rdAnimUpdateWorkTime += JobSystem::parallelFor(numberOfVisibleInstances, mAnimUpdateGrainSize, [&](size_t begin, size_t end)
+          {
+            for (size_t slot = begin; slot < end; ++slot)
+            {
+              AssimpInstance *instance = instances[mAnimSlotIndices[slot]].get();
+              if (!instance->getAnimLodSkip())
+              {
+                instance->storeAnimLodPose(nodeTransformData + slot * numberOfBones);
+              }
+            }
+          });
+        }
 
-        for (unsigned int i = 0; i < numberOfInstances; ++i)
+        unsigned int skippedInstances = 0;
+        for (size_t clip = 0; clip < animClips.size(); ++clip)
         {
-          modelType.second.at(i)->updateAnimation(deltaTime);
-          std::vector<NodeTransformData> instanceNodeTransform = modelType.second.at(i)->getNodeTransformData();
-          std::copy(instanceNodeTransform.begin(), instanceNodeTransform.end(), mNodeTransFormData.begin() + i * numberOfBones);
-          mWorldPosMatrices.at(i) = modelType.second.at(i)->getWorldTransformMatrix();
-          
+          skippedInstances += mAnimClipOffsets.at(clip * 2 + 2) - mAnimClipOffsets.at(clip * 2 + 1);
         }
+        mRenderData.rdAnimLodSampledInstances += static_cast<unsigned int>(numberOfVisibleInstances) - skippedInstances;
+        mRenderData.rdAnimUpdateTime += mAnimUpdateTimer.stop();
         mRenderData.rdMatrixGenerateTime += mMatrixGenerateTimer.stop();
 
-        size_t trsMatrixSize = numberOfBones * numberOfInstances * sizeof(glm::mat4);
-        mRenderData.rdMatricesSize += trsMatrixSize;
+        /* the bone and clip tables of all models that can use the fused compute pass, in the order of the models */
+        AnimBatchRecord batchRecord{};
+        if (fusedBoneMatrices)
+        {
+          batchRecord.abrNumberOfBones = static_cast<int32_t>(numberOfBones);
+          batchRecord.abrNumberOfLevels = static_cast<int32_t>(model->getBoneLevelCount());
+          batchRecord.abrBoneTableOffset = static_cast<int32_t>(animBatchBoneTableSize);
+          batchRecord.abrLevelOrderOffset = static_cast<int32_t>(animBatchLevelOrderSize);
+          batchRecord.abrLevelOffsetOffset = static_cast<int32_t>(animBatchLevelOffsetSize);
+          batchRecord.abrClipTableOffset = static_cast<int32_t>(animBatchClipTableSize);
+          animBatchBoneTableSize += numberOfBones;
+          animBatchLevelOrderSize += model->getBoneLevelOrder().size();
+          animBatchLevelOffsetSize += model->getBoneLevelOffsets().size();
+          animBatchClipTableSize += model->getGpuAnimClipTable().size();
+          mAnimBatchFrameTableModels.emplace_back(model);
+          mAnimBatchFrameTableVersions.emplace_back(model->getGpuAnimClipVersion());
+        }
 
-        /* we may have to resize the buffers (uploadSsboData() checks for the size automatically, bind() not) */
-        mShaderBoneMatrixBuffer.checkForResize(trsMatrixSize);
-        mShaderTRSMatrixBuffer.checkForResize(trsMatrixSize);
+        /* nothing to compute if all instances are culled */
+        if (numberOfVisibleInstances > 0)
+        {
+          if (fusedBoneMatrices)
+          {
+            batchRecord.abrFirstWorkGroup = static_cast<int32_t>(mAnimBatchWorkGroups);
+            batchRecord.abrBoneDataOffset = static_cast<int32_t>(boneDataOffset);
+            batchRecord.abrNodeDataOffset = gpuSampling ? -1 : static_cast<int32_t>(nodeDataOffset);
+            mAnimBatchRecords.emplace_back(batchRecord);
+            mAnimBatchWorkGroups += numberOfVisibleInstances;
+          }
+
+          AnimBatchDraw batchDraw{};
+          batchDraw.abdNumberOfInstances = numberOfVisibleInstances;
+          batchDraw.abdFirstInstance = firstInstance;
+          batchDraw.abdBoneDataOffset = boneDataOffset;
+          batchDraw.abdNodeDataOffset = nodeDataOffset;
+          batchDraw.abdNumberOfBones = numberOfBones;
+          batchDraw.abdFused = fusedBoneMatrices;
+          if (model->getPreSkinning())
+          {
+            batchDraw.abdPreSkinned = true;
+            batchDraw.abdSkinnedVertexOffset = preSkinnedVertices;
+            preSkinnedVertices += numberOfVisibleInstances * model->getVertexCount();
+          }
+          mAnimBatchModels.emplace_back(model);
+          mAnimBatchDraws.emplace_back(batchDraw);
+        }
 
-        /* calculate TRS matrices from node transforms */
-        mAssimpTransformComputeShader.use();
+        /* drawn after the compute pass of all animated models */
+        numberOfDrawnInstances = 0;
 
+        mRenderData.rdAnimAllocations += static_cast<unsigned int>(AllocationCounter::getAllocations() - animStartAllocations);
+      }
+      else
+      {
+        /* non-animated models, a region is uploaded completely if it is new, has moved or has changed its size */
         mUploadToUBOTimer.start();
-        mNodeTransformBuffer.uploadSsboData(mNodeTransFormData, 0);
-        mShaderTRSMatrixBuffer.bind(1);
+        if (worldPosRegion < mWorldPosRegionStores.size() && mWorldPosRegionStores.at(worldPosRegion) == &store &&
+            mWorldPosRegionSizes.at(worldPosRegion) == numberOfInstances &&
+            mWorldPosRegionOffsets.at(worldPosRegion) == worldPosOffset)
+        {
+          uploadWorldPosRanges(store, worldPosOffset);
+        }
+        else
+        {
+          mWorldPosRegionStores.resize(worldPosRegion + 1);
+          mWorldPosRegionSizes.resize(worldPosRegion + 1);
+          mWorldPosRegionOffsets.resize(worldPosRegion + 1);
+          mWorldPosRegionStores.at(worldPosRegion) = &store;
+          mWorldPosRegionSizes.at(worldPosRegion) = numberOfInstances;
+          mWorldPosRegionOffsets.at(worldPosRegion) = worldPosOffset;
+          /* all records of the store are valid, the dirty ones were rebuilt above */
+          mWorldPosBuffer.uploadSsboRange(store.getTransformRecords().data(), numberOfInstances, worldPosOffset);
+          mRenderData.rdMatricesSize += numberOfInstances * sizeof(InstanceTransformRecord);
+        }
         mRenderData.rdUploadToUBOTime += mUploadToUBOTimer.stop();
 
-        /* do the computation - in groups of 32 invocations */
-        glDispatchCompute(numberOfBones, std::ceil(numberOfInstances / 32.0f), 1);
-        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        mAssimpShader.use();
+        mAssimpShader.setInt("aWorldPosOffset", static_cast<int>(worldPosOffset));
+        mAssimpShader.setMat4("aModelRootMatrix", model->getRootTranformationMatrix());
+        mWorldPosBuffer.bind(1);
 
-        /* multiply every bone TRS matrix with its parent bones TRS matrices, until the root bone has been reached
-         * also, multiply the bone TRS and the bone offset matrix */
-        mAssimpMatrixComputeShader.use();
+        ++worldPosRegion;
+        worldPosOffset += numberOfInstances;
+      }
 
-        mUploadToUBOTimer.start();
-        mShaderTRSMatrixBuffer.bind(0);
-        model->bindBoneParentBuffer(1);
-        model->bindBoneMatrixOffsetBuffer(2);
-        mShaderBoneMatrixBuffer.bind(3);
-        mRenderData.rdUploadToUBOTime += mUploadToUBOTimer.stop();
+      if (numberOfDrawnInstances > 0)
+      {
+        model->drawInstanced(numberOfDrawnInstances);
+      }
+    }
 
-        /* do the computation - in groups of 32 invocations */
-        glDispatchCompute(numberOfBones, std::ceil(numberOfInstances / 32.0f), 1);
-        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    /* the animated models copy all world matrices in every frame */
+    store.clearDirty();
+  }
 
-        /* now bind the final bone transforms to the vertex skinning shader */
-        mAssimpSkinningShader.use();
+  /* models deleted or switched to an animated path */
+  mWorldPosRegionStores.resize(std::min(mWorldPosRegionStores.size(), worldPosRegion));
+  mWorldPosRegionSizes.resize(std::min(mWorldPosRegionSizes.size(), worldPosRegion));
+  mWorldPosRegionOffsets.resize(std::min(mWorldPosRegionOffsets.size(), worldPosRegion));
 
-        mUploadToUBOTimer.start();
-        mAssimpSkinningShader.setInt("aModelStride",numberOfBones);
-        mShaderBoneMatrixBuffer.bind(1);
-        mShaderModelRootMatrixBuffer.uploadSsboData(mWorldPosMatrices, 2);
-        mRenderData.rdUploadToUBOTime += mUploadToUBOTimer.stop();
+  /* compute the bone matrices of all animated models at once, and draw the models */
+  if (!mAnimBatchDraws.empty())
+  {
+    /* the compute shaders write the bone matrices in the palette format the skinning shader reads */
+    int bonePalette = static_cast<int>(mRenderData.rdBonePaletteFormat);
+    size_t bonePaletteSize = animBatchBoneMatrices * getBonePaletteVectors(mRenderData.rdBonePaletteFormat) * sizeof(glm::vec4);
+    size_t boneMatrixSize = animBatchBoneMatrices * sizeof(glm::mat4);
+    mRenderData.rdMatricesSize += bonePaletteSize;
+
+    /* we may have to resize the buffers (uploadSsboData() checks for the size automatically, bind() not) */
+    mShaderBoneMatrixBuffer.checkForResize(bonePaletteSize);
+
+    /* a single copy of the poses and the batch records to the mapped memory */
+    mUploadToUBOTimer.start();
+    SsboRingRange nodeTransformRange{};
+    SsboRingRange batchRecordRange{};
+    NodeTransformData *nodeTransformData = mFrameDataBuffer.allocate<NodeTransformData>(mNodeTransFormData.size(), nodeTransformRange);
+    std::copy(mNodeTransFormData.begin(), mNodeTransFormData.end(), nodeTransformData);
+    AnimBatchRecord *batchRecords = mFrameDataBuffer.allocate<AnimBatchRecord>(mAnimBatchRecords.size(), batchRecordRange);
+    std::copy(mAnimBatchRecords.begin(), mAnimBatchRecords.end(), batchRecords);
+
+    /* the tables only change if models are added, removed, switched between the compute paths or recompressed */
+    if (mAnimBatchFrameTableModels != mAnimBatchTableModels || mAnimBatchFrameTableVersions != mAnimBatchTableVersions)
+    {
+      mAnimBatchTableModels = mAnimBatchFrameTableModels;
+      mAnimBatchTableVersions = mAnimBatchFrameTableVersions;
+      mAnimBatchParentIndices.clear();
+      mAnimBatchBoneOffsets.clear();
+      mAnimBatchLevelOrder.clear();
+      mAnimBatchLevelOffsets.clear();
+      mAnimBatchClipTable.clear();
+      mAnimBatchChannels.clear();
+      mAnimBatchKeyTimes.clear();
+      mAnimBatchKeyValues.clear();
+      for (const auto &model : mAnimBatchTableModels)
+      {
+        mAnimBatchParentIndices.insert(mAnimBatchParentIndices.end(), model->getBoneParentIndices().begin(), model->getBoneParentIndices().end());
+        mAnimBatchBoneOffsets.insert(mAnimBatchBoneOffsets.end(), model->getBoneOffsetMatrices().begin(), model->getBoneOffsetMatrices().end());
+        mAnimBatchLevelOrder.insert(mAnimBatchLevelOrder.end(), model->getBoneLevelOrder().begin(), model->getBoneLevelOrder().end());
+        mAnimBatchLevelOffsets.insert(mAnimBatchLevelOffsets.end(), model->getBoneLevelOffsets().begin(), model->getBoneLevelOffsets().end());
+
+        /* the clip data of the model uses local offsets, move them behind the data of the previous models */
+        int32_t clipTableBase = static_cast<int32_t>(mAnimBatchClipTable.size());
+        int32_t channelBase = static_cast<int32_t>(mAnimBatchChannels.size());
+        int32_t keyBase = static_cast<int32_t>(mAnimBatchKeyTimes.size());
+        const std::vector<int32_t> &clipTable = model->getGpuAnimClipTable();
+        size_t numberOfClips = model->getAnimClips().size();
+        for (size_t i = 0; i < clipTable.size(); ++i)
+        {
+          if (i < numberOfClips)
+          {
+            mAnimBatchClipTable.emplace_back(clipTable.at(i) + clipTableBase);
+          }
+          else
+          {
+            mAnimBatchClipTable.emplace_back(clipTable.at(i) < 0 ? -1 : clipTable.at(i) + channelBase);
+          }
+        }
+        for (GpuAnimChannel channel : model->getGpuAnimChannels())
+        {
+          channel.gchTranslationKey += keyBase;
+          channel.gchRotationKey += keyBase;
+          channel.gchScaleKey += keyBase;
+          mAnimBatchChannels.emplace_back(channel);
+        }
+        mAnimBatchKeyTimes.insert(mAnimBatchKeyTimes.end(), model->getGpuAnimKeyTimes().begin(), model->getGpuAnimKeyTimes().end());
+        mAnimBatchKeyValues.insert(mAnimBatchKeyValues.end(), model->getGpuAnimKeyValues().begin(), model->getGpuAnimKeyValues().end());
       }
-      else
+      mAnimBatchParentBuffer.uploadSsboData(mAnimBatchParentIndices);
+      mAnimBatchBoneOffsetBuffer.uploadSsboData(mAnimBatchBoneOffsets);
+      mAnimBatchLevelOrderBuffer.uploadSsboData(mAnimBatchLevelOrder);
+      mAnimBatchLevelOffsetBuffer.uploadSsboData(mAnimBatchLevelOffsets);
+      mAnimBatchClipTableBuffer.uploadSsboData(mAnimBatchClipTable);
+      mAnimBatchChannelBuffer.uploadSsboData(mAnimBatchChannels);
+      mAnimBatchKeyTimeBuffer.uploadSsboData(mAnimBatchKeyTimes);
+      mAnimBatchKeyValueBuffer.uploadSsboData(mAnimBatchKeyValues);
+    }
+    mRenderData.rdUploadToUBOTime += mUploadToUBOTimer.stop();
+
+    /* build the TRS matrices and resolve the bone hierarchy level by level for all instances of all models,
+     * the TRS matrices stay in shared memory. also, multiply the global bone matrix and the bone offset matrix */
+    if (!mAnimBatchRecords.empty())
+    {
+      mAssimpTransformLevelsComputeShader.use();
+
+      mUploadToUBOTimer.start();
+      mAssimpTransformLevelsComputeShader.setInt("aNumberOfRecords", mAnimBatchRecords.size());
+      mAssimpTransformLevelsComputeShader.setInt("aNumberOfWorkGroups", mAnimBatchWorkGroups);
+      mAssimpTransformLevelsComputeShader.setBool("aUseNlerp", mRenderData.rdAnimUseNlerp);
+      mAssimpTransformLevelsComputeShader.setInt("aBonePalette", bonePalette);
+      mFrameDataBuffer.bind(nodeTransformRange, 0);
+      mAnimBatchParentBuffer.bind(1);
+      mAnimBatchBoneOffsetBuffer.bind(2);
+      mShaderBoneMatrixBuffer.bind(3);
+      mAnimBatchLevelOrderBuffer.bind(4);
+      mAnimBatchLevelOffsetBuffer.bind(5);
+      mFrameDataBuffer.bind(batchRecordRange, 6);
+      mFrameDataBuffer.bind(mAnimInstanceRecordRange, 7);
+      mAnimBatchClipTableBuffer.bind(8);
+      mAnimBatchChannelBuffer.bind(9);
+      mAnimBatchKeyTimeBuffer.bind(10);
+      mAnimBatchKeyValueBuffer.bind(11);
+      mRenderData.rdUploadToUBOTime += mUploadToUBOTimer.stop();
+
+      /* one work group per instance */
+      size_t workGroupsX = std::min(mAnimBatchWorkGroups, mMaxComputeWorkGroups);
+      glDispatchCompute(workGroupsX, (mAnimBatchWorkGroups + workGroupsX - 1) / workGroupsX, 1);
+    }
+
+    /* models with too many bones for the shared memory, or all models if the fused pass is disabled */
+    for (size_t i = 0; i < mAnimBatchDraws.size(); ++i)
+    {
+      const AnimBatchDraw &batchDraw = mAnimBatchDraws.at(i);
+      if (batchDraw.abdFused)
       {
-        /* non-animated models */
-        mMatrixGenerateTimer.start();
-        mWorldPosMatrices.clear();
+        continue;
+      }
+
+      mShaderTRSMatrixBuffer.checkForResize(boneMatrixSize);
+
+      /* calculate TRS matrices from node transforms */
+      mAssimpTransformComputeShader.use();
+
+      mUploadToUBOTimer.start();
+      mAssimpTransformComputeShader.setInt("aNodeDataOffset", batchDraw.abdNodeDataOffset);
+      mAssimpTransformComputeShader.setInt("aBoneDataOffset", batchDraw.abdBoneDataOffset);
+      mAssimpTransformComputeShader.setInt("aNumberOfInstances", batchDraw.abdNumberOfInstances);
+      mFrameDataBuffer.bind(nodeTransformRange, 0);
+      mShaderTRSMatrixBuffer.bind(1);
+      mRenderData.rdUploadToUBOTime += mUploadToUBOTimer.stop();
+
+      /* do the computation - in groups of 32 invocations */
+      glDispatchCompute(batchDraw.abdNumberOfBones, std::ceil(batchDraw.abdNumberOfInstances / 32.0f), 1);
+      glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+      /* multiply every bone TRS matrix with its parent bones TRS matrices, until the root bone has been reached */
+      mAssimpMatrixComputeShader.use();
+
+      mUploadToUBOTimer.start();
+      mAssimpMatrixComputeShader.setInt("aBoneDataOffset", batchDraw.abdBoneDataOffset);
+      mAssimpMatrixComputeShader.setInt("aNumberOfInstances", batchDraw.abdNumberOfInstances);
+      mAssimpMatrixComputeShader.setInt("aBonePalette", bonePalette);
+      mShaderTRSMatrixBuffer.bind(0);
+      mAnimBatchModels.at(i)->bindBoneParentBuffer(1);
+      mAnimBatchModels.at(i)->bindBoneMatrixOffsetBuffer(2);
+      mShaderBoneMatrixBuffer.bind(3);
+      mRenderData.rdUploadToUBOTime += mUploadToUBOTimer.stop();
+
+      /* do the computation - in groups of 32 invocations */
+      glDispatchCompute(batchDraw.abdNumberOfBones, std::ceil(batchDraw.abdNumberOfInstances / 32.0f), 1);
+    }
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    /* skin the vertices of the pre-skinned models once, the draws below only read the world space vertices */
+    if (preSkinnedVertices > 0)
+    {
+      size_t preSkinnedSize = preSkinnedVertices * sizeof(PreSkinnedVertex);
+      mRenderData.rdPreSkinnedSize = preSkinnedSize;
+      mPreSkinnedVertexBuffer.checkForResize(preSkinnedSize);
+
+      mAssimpPreSkinningComputeShader.use();
+      mAssimpPreSkinningComputeShader.setInt("aBonePalette", bonePalette);
+      mShaderBoneMatrixBuffer.bind(1);
+      mFrameDataBuffer.bind(mAnimWorldPosRange, 2);
+      mPreSkinnedVertexBuffer.bind(3);
 
-        for (const auto &instance : modelType.second)
+      for (size_t i = 0; i < mAnimBatchDraws.size(); ++i)
+      {
+        const AnimBatchDraw &batchDraw = mAnimBatchDraws.at(i);
+        if (!batchDraw.abdPreSkinned)
         {
-          mWorldPosMatrices.emplace_back(instance->getWorldTransformMatrix());
+          continue;
         }
-        mRenderData.rdMatrixGenerateTime += mMatrixGenerateTimer.stop();
-        mRenderData.rdMatricesSize += mWorldPosMatrices.size() * sizeof(glm::mat4);
 
-        mAssimpShader.use();
-        mUploadToUBOTimer.start();
-        mWorldPosBuffer.uploadSsboData(mWorldPosMatrices, 1);
-        mRenderData.rdUploadToUBOTime += mUploadToUBOTimer.stop();
+        unsigned int numberOfVertices = mAnimBatchModels.at(i)->getVertexCount();
+        mAssimpPreSkinningComputeShader.setInt("aNumberOfVertices", numberOfVertices);
+        mAssimpPreSkinningComputeShader.setInt("aNumberOfInstances", batchDraw.abdNumberOfInstances);
+        mAssimpPreSkinningComputeShader.setInt("aModelStride", batchDraw.abdNumberOfBones);
+        mAssimpPreSkinningComputeShader.setInt("aBoneMatrixOffset", batchDraw.abdBoneDataOffset);
+        mAssimpPreSkinningComputeShader.setInt("aWorldPosOffset", batchDraw.abdFirstInstance);
+        mAssimpPreSkinningComputeShader.setInt("aSkinnedVertexOffset", batchDraw.abdSkinnedVertexOffset);
+        mAnimBatchModels.at(i)->bindSkinVertexBuffer(0);
+
+        /* 64 vertices per work group, the instances in y */
+        glDispatchCompute(std::ceil(numberOfVertices / 64.0f), std::min(batchDraw.abdNumberOfInstances, mMaxComputeWorkGroups), 1);
       }
+      glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+      mAssimpPreSkinnedShader.use();
+      mPreSkinnedVertexBuffer.bind(1);
+      for (size_t i = 0; i < mAnimBatchDraws.size(); ++i)
+      {
+        const AnimBatchDraw &batchDraw = mAnimBatchDraws.at(i);
+        if (!batchDraw.abdPreSkinned)
+        {
+          continue;
+        }
 
-      model->drawInstanced(numberOfInstances);
+        mAssimpPreSkinnedShader.setInt("aNumberOfVertices", mAnimBatchModels.at(i)->getVertexCount());
+        mAssimpPreSkinnedShader.setInt("aSkinnedVertexOffset", batchDraw.abdSkinnedVertexOffset);
+        mAnimBatchModels.at(i)->drawInstanced(batchDraw.abdNumberOfInstances, true);
+      }
+    }
+
+    /* now bind the final bone transforms to the vertex skinning shader */
+    mAssimpSkinningShader.use();
+
+    mAssimpSkinningShader.setInt("aBonePalette", bonePalette);
+    mShaderBoneMatrixBuffer.bind(1);
+    mFrameDataBuffer.bind(mAnimWorldPosRange, 2);
+
+    for (size_t i = 0; i < mAnimBatchDraws.size(); ++i)
+    {
+      const AnimBatchDraw &batchDraw = mAnimBatchDraws.at(i);
+      if (batchDraw.abdPreSkinned)
+      {
+        continue;
+      }
+
+      mAssimpSkinningShader.setInt("aModelStride", batchDraw.abdNumberOfBones);
+      mAssimpSkinningShader.setInt("aBoneMatrixOffset", batchDraw.abdBoneDataOffset);
+      mAssimpSkinningShader.setInt("aWorldPosOffset", batchDraw.abdFirstInstance);
+      mAnimBatchModels.at(i)->drawInstanced(batchDraw.abdNumberOfInstances);
     }
   }
 
+  /* the next frames write to the other parts of the ring */
+  mFrameDataBuffer.endFrame();
+
+  /* the poses stored in this frame can be reused in the next one */
+  mAnimLodPosesValid = mRenderData.rdAnimLodEnabled;
+  ++mAnimLodFrame;
+
   mFramebuffer.unbind();
 
   /* blit color buffer to screen */
@@ -598,8 +1379,12 @@ void OGLRenderer::cleanup()
     model->cleanup();
   }
 
+  JobSystem::cleanup();
+
   mShaderBoneMatrixBuffer.cleanup();
+  mPreSkinnedVertexBuffer.cleanup();
   mWorldPosBuffer.cleanup();
+  mFrameDataBuffer.cleanup();
 
   mUserInterface.cleanup();
 
@@ -1,5 +1,7 @@
 #include "OpenGL/ShaderStorageBuffer.hpp"
 
+#include <algorithm>
+
 void ShaderStorageBuffer::init(size_t bufferSize) {
   mBufferSize = bufferSize;
 
@@ -20,12 +22,16 @@ void ShaderStorageBuffer::bind(int bindingPoint) {
   glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 }
 
-void ShaderStorageBuffer::checkForResize(size_t newBufferSize) {
+bool ShaderStorageBuffer::checkForResize(size_t newBufferSize) {
   if (newBufferSize > mBufferSize) {
-    Logger::log(1, "%s: resizing SSBO %i from %i to %i bytes\n", __FUNCTION__, mShaderStorageBuffer, mBufferSize, newBufferSize);
+    /* avoid a new buffer for every small increase */
+    size_t bufferSize = std::max(newBufferSize, mBufferSize * 2);
+    Logger::log(1, "%s: resizing SSBO %i from %i to %i bytes\n", __FUNCTION__, mShaderStorageBuffer, mBufferSize, bufferSize);
     cleanup();
-    init(newBufferSize);
+    init(bufferSize);
+    return true;
   }
+  return false;
 }
 
 void ShaderStorageBuffer::cleanup() {
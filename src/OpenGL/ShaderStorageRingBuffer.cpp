@@ -0,0 +1,123 @@
+#include "OpenGL/ShaderStorageRingBuffer.hpp"
+
+#include <algorithm>
+
+#include "Tools/Logger.hpp"
+
+bool ShaderStorageRingBuffer::init(size_t frameSize) {
+  GLint offsetAlignment = 0;
+  glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+  if (offsetAlignment > 0) {
+    mOffsetAlignment = static_cast<size_t>(offsetAlignment);
+  }
+
+  mFrame = 0;
+  mFrameOffset = 0;
+  return createBuffer(frameSize);
+}
+
+bool ShaderStorageRingBuffer::createBuffer(size_t frameSize) {
+  /* the parts must start at an aligned offset, too */
+  mFrameSize = (std::max(frameSize, mOffsetAlignment) + mOffsetAlignment - 1) / mOffsetAlignment * mOffsetAlignment;
+  size_t bufferSize = mFrameSize * mFramesInFlight;
+
+  GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  glGenBuffers(1, &mBuffer);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, mBuffer);
+  glBufferStorage(GL_SHADER_STORAGE_BUFFER, bufferSize, nullptr, flags);
+  mMappedData = static_cast<uint8_t*>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, bufferSize, flags));
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+  if (!mMappedData) {
+    Logger::log(1, "%s error: could not map SSBO %i (%i bytes)\n", __FUNCTION__, mBuffer, bufferSize);
+    return false;
+  }
+  return true;
+}
+
+void ShaderStorageRingBuffer::cleanup() {
+  for (GLsync& fence : mFences) {
+    if (fence) {
+      glDeleteSync(fence);
+      fence = nullptr;
+    }
+  }
+  for (auto& buffers : mRetiredBuffers) {
+    glDeleteBuffers(buffers.size(), buffers.data());
+    buffers.clear();
+  }
+
+  /* deleting a buffer unmaps it */
+  glDeleteBuffers(1, &mBuffer);
+  mBuffer = 0;
+  mMappedData = nullptr;
+}
+
+void ShaderStorageRingBuffer::beginFrame() {
+  mFrame = (mFrame + 1) % mFramesInFlight;
+  mFrameOffset = 0;
+
+  GLsync& fence = mFences.at(mFrame);
+  if (fence) {
+    GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+    while (result == GL_TIMEOUT_EXPIRED) {
+      result = glClientWaitSync(fence, 0, 1000000000);
+    }
+    if (result == GL_WAIT_FAILED) {
+      Logger::log(1, "%s error: waiting for the fence of frame %i failed\n", __FUNCTION__, mFrame);
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+  }
+
+  std::vector<GLuint>& retiredBuffers = mRetiredBuffers.at(mFrame);
+  if (!retiredBuffers.empty()) {
+    glDeleteBuffers(retiredBuffers.size(), retiredBuffers.data());
+    retiredBuffers.clear();
+  }
+}
+
+void ShaderStorageRingBuffer::endFrame() {
+  GLsync& fence = mFences.at(mFrame);
+  if (fence) {
+    glDeleteSync(fence);
+  }
+  fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+SsboRingRange ShaderStorageRingBuffer::allocate(size_t size) {
+  SsboRingRange range{};
+  if (size == 0) {
+    return range;
+  }
+
+  size_t offset = (mFrameOffset + mOffsetAlignment - 1) / mOffsetAlignment * mOffsetAlignment;
+  if (offset + size > mFrameSize) {
+    /* the GPU may still read the old buffer, it is deleted once this frame is done */
+    size_t newFrameSize = std::max(mFrameSize * 2, size);
+    Logger::log(1, "%s: growing SSBO ring %i from %i to %i bytes per frame\n", __FUNCTION__, mBuffer, mFrameSize, newFrameSize);
+    mRetiredBuffers.at(mFrame).emplace_back(mBuffer);
+    if (!createBuffer(newFrameSize)) {
+      return range;
+    }
+    offset = 0;
+  }
+
+  range.srrBuffer = mBuffer;
+  range.srrOffset = mFrame * mFrameSize + offset;
+  range.srrSize = size;
+  range.srrData = mMappedData + range.srrOffset;
+  mFrameOffset = offset + size;
+  return range;
+}
+
+void ShaderStorageRingBuffer::bind(const SsboRingRange& range, int bindingPoint) {
+  if (range.srrSize == 0) {
+    return;
+  }
+  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, bindingPoint, range.srrBuffer, range.srrOffset, range.srrSize);
+}
+
+size_t ShaderStorageRingBuffer::getFrameSize() {
+  return mFrameSize;
+}
@@ -5,49 +5,75 @@
 #include "Tools/Logger.hpp"
 
 void Texture::cleanup() {
+  stbi_image_free(mTextureData);
+  mTextureData = nullptr;
+
   glDeleteTextures(1, &mTexture);
 }
 
 bool Texture::loadTexture(std::string textureFilename, bool flipImage) {
+  if (!decodeTexture(textureFilename, flipImage)) {
+    return false;
+  }
+  return uploadTexture();
+}
+
+bool Texture::loadTexture(std::string textureName, aiTexel* textureData, int width, int height, bool flipImage) {
+  if (!decodeTexture(textureName, textureData, width, height, flipImage)) {
+    return false;
+  }
+  return uploadTexture();
+}
+
+bool Texture::decodeTexture(std::string textureFilename, bool flipImage) {
   mTextureName = textureFilename;
 
-  stbi_set_flip_vertically_on_load(flipImage);
+  /* the flip flag must be per thread, decoding may run in parallel */
+  stbi_set_flip_vertically_on_load_thread(flipImage);
   /* always load as RGBA */
-  unsigned char *textureData = stbi_load(textureFilename.c_str(), &mTexWidth, &mTexHeight, &mNumberOfChannels, STBI_rgb_alpha);
+  mTextureData = stbi_load(textureFilename.c_str(), &mTexWidth, &mTexHeight, &mNumberOfChannels, STBI_rgb_alpha);
 
-  if (!textureData) {
+  if (!mTextureData) {
     Logger::log(1, "%s error: could not load file '%s'\n", __FUNCTION__, mTextureName.c_str());
-    stbi_image_free(textureData);
     return false;
   }
+  return true;
+}
 
-  glGenTextures(1, &mTexture);
-  glBindTexture(GL_TEXTURE_2D, mTexture);
+bool Texture::decodeTexture(std::string textureName, aiTexel* textureData, int width, int height, bool flipImage) {
+  mTextureName = textureName;
 
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  if (!textureData) {
+    Logger::log(1, "%s error: could not load texture '%s'\n", __FUNCTION__, textureName.c_str());
+    return false;
+  }
 
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, mTexWidth, mTexHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, textureData);
+  Logger::log(1, "%s: texture file '%s' has width %i and height %i\n", __FUNCTION__, textureName.c_str(), width, height);
 
-  glGenerateMipmap(GL_TEXTURE_2D);
-  glBindTexture(GL_TEXTURE_2D, 0);
+  /* allow to flip the image, similar to file loaded from disk */
+  stbi_set_flip_vertically_on_load_thread(flipImage);
 
-  stbi_image_free(textureData);
+  /* we use stbi to detect the in-memory format, but always request RGBA */
+  if (height == 0)   {
+    mTextureData = stbi_load_from_memory(reinterpret_cast<unsigned char*>(textureData), width, &mTexWidth, &mTexHeight, &mNumberOfChannels, STBI_rgb_alpha);
+  }
+  else   {
+    mTextureData = stbi_load_from_memory(reinterpret_cast<unsigned char*>(textureData), width * height, &mTexWidth, &mTexHeight, &mNumberOfChannels, STBI_rgb_alpha);
+  }
 
-  Logger::log(1, "%s: texture '%s' loaded (%dx%d, %d channels)\n", __FUNCTION__, mTextureName.c_str(), mTexWidth, mTexHeight, mNumberOfChannels);
+  if (!mTextureData) {
+    Logger::log(1, "%s error: could not decode texture '%s'\n", __FUNCTION__, textureName.c_str());
+    return false;
+  }
   return true;
 }
 
-bool Texture::loadTexture(std::string textureName, aiTexel* textureData, int width, int height, bool flipImage) {
-  if (!textureData) {
-    Logger::log(1, "%s error: could not load texture '%s'\n", __FUNCTION__, textureName.c_str());
+bool Texture::uploadTexture() {
+  if (!mTextureData) {
+    Logger::log(1, "%s error: texture '%s' was not decoded\n", __FUNCTION__, mTextureName.c_str());
     return false;
   }
 
-  Logger::log(1, "%s: texture file '%s' has width %i and height %i\n", __FUNCTION__, textureName.c_str(), width, height);
-
   glGenTextures(1, &mTexture);
   glBindTexture(GL_TEXTURE_2D, mTexture);
 
@@ -56,26 +82,15 @@ bool Texture::loadTexture(std::string textureName, aiTexel* textureData, int wid
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-  /* allow to flip the image, similar to file loaded from disk */
-  stbi_set_flip_vertically_on_load(flipImage);
-
-  /* we use stbi to detect the in-memory format, but always request RGBA */
-  unsigned char *data = nullptr;
-  if (height == 0)   {
-    data = stbi_load_from_memory(reinterpret_cast<unsigned char*>(textureData), width, &mTexWidth, &mTexHeight, &mNumberOfChannels, STBI_rgb_alpha);
-  }
-  else   {
-    data = stbi_load_from_memory(reinterpret_cast<unsigned char*>(textureData), width * height, &mTexWidth, &mTexHeight, &mNumberOfChannels, STBI_rgb_alpha);
-  }
-
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, mTexWidth, mTexHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-
-  stbi_image_free(data);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, mTexWidth, mTexHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, mTextureData);
 
   glGenerateMipmap(GL_TEXTURE_2D);
   glBindTexture(GL_TEXTURE_2D, 0);
 
-  Logger::log(1, "%s: texture '%s' loaded (%dx%d, %d channels)\n", __FUNCTION__, textureName.c_str(), mTexWidth, mTexHeight, mNumberOfChannels);
+  stbi_image_free(mTextureData);
+  mTextureData = nullptr;
+
+  Logger::log(1, "%s: texture '%s' loaded (%dx%d, %d channels)\n", __FUNCTION__, mTextureName.c_str(), mTexWidth, mTexHeight, mNumberOfChannels);
   return true;
 }
 
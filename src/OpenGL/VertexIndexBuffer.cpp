@@ -90,3 +90,13 @@ void VertexIndexBuffer::bindAndDrawIndirectInstanced(GLuint mode, unsigned int n
   unbind();
 }
 
+void VertexIndexBuffer::drawIndirectInstancedBaseInstance(GLuint mode, unsigned int num, int instanceCount, unsigned int baseInstance) {
+  glDrawElementsInstancedBaseInstance(mode, num, GL_UNSIGNED_INT, 0, instanceCount, baseInstance);
+}
+
+void VertexIndexBuffer::bindAndDrawIndirectInstancedBaseInstance(GLuint mode, unsigned int num, int instanceCount, unsigned int baseInstance) {
+  bind();
+  drawIndirectInstancedBaseInstance(mode, num, instanceCount, baseInstance);
+  unbind();
+}
+
@@ -0,0 +1,110 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "Tools/AllocationCounter.hpp"
+
+/* a plain global, the counter must work before any static object is constructed */
+static std::atomic<uint64_t> allocationCount{0};
+
+uint64_t AllocationCounter::getAllocations() {
+  return allocationCount.load(std::memory_order_relaxed);
+}
+
+static void* countedAlloc(std::size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  /* malloc(0) may return a null pointer */
+  return std::malloc(size > 0 ? size : 1);
+}
+
+static void* countedAlignedAlloc(std::size_t size, std::align_val_t alignment) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  std::size_t align = static_cast<std::size_t>(alignment);
+#ifdef _MSC_VER
+  return _aligned_malloc(size > 0 ? size : 1, align);
+#else
+  /* aligned_alloc() needs a multiple of the alignment as size */
+  std::size_t alignedSize = ((size > 0 ? size : 1) + align - 1) / align * align;
+  return std::aligned_alloc(align, alignedSize);
+#endif
+}
+
+static void alignedFree(void* ptr) {
+#ifdef _MSC_VER
+  _aligned_free(ptr);
+#else
+  std::free(ptr);
+#endif
+}
+
+void* operator new(std::size_t size) {
+  void* ptr = countedAlloc(size);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void* operator new[](std::size_t size) {
+  void* ptr = countedAlloc(size);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return countedAlloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return countedAlloc(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  void* ptr = countedAlignedAlloc(size, alignment);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+  void* ptr = countedAlignedAlloc(size, alignment);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+  alignedFree(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+  alignedFree(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+  alignedFree(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+  alignedFree(ptr);
+}
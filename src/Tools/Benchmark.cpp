@@ -0,0 +1,877 @@
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Tools/Benchmark.hpp"
+#include "Tools/Timer.hpp"
+#include "Tools/Logger.hpp"
+#include "Tools/JobSystem.hpp"
+#include "Model/AssimpModel.hpp"
+#include "Model/AssimpBone.hpp"
+#include "Model/AssimpAnimClip.hpp"
+#include "Model/AssimpAnimSampler.hpp"
+#include "Model/AssimpAnimKernels.hpp"
+#include "Model/AssimpPoseCache.hpp"
+#include "Model/AssimpBoneHierarchy.hpp"
+#include "Model/AssimpTransformKernels.hpp"
+#include "Model/AssimpInstanceStore.hpp"
+#include "OpenGL/OGLRenderData.hpp"
+
+/* replays the clips with the batched sampler, the instances must be grouped by clip */
+static float runBatchedSampling(const std::vector<std::shared_ptr<AssimpAnimClip>>& animClips, const std::vector<unsigned int>& clipNrs,
+    const std::vector<float>& startTimes, size_t numBones, unsigned int numFrames, bool useNlerp, std::vector<NodeTransformData>& batchData) {
+  const float deltaTime = 1.0f / 60.0f;
+  unsigned int numInstances = static_cast<unsigned int>(clipNrs.size());
+
+  std::vector<float> playTimes = startTimes;
+  std::vector<std::vector<AnimChannelCursor>> batchCursors(numInstances);
+  std::vector<AnimChannelCursor*> cursorPtrs(numInstances);
+  for (unsigned int i = 0; i < numInstances; ++i) {
+    batchCursors[i].resize(animClips[clipNrs[i]]->getPackedClip().numChannels);
+    cursorPtrs[i] = batchCursors[i].data();
+  }
+  batchData.resize(numInstances * numBones);
+
+  Timer benchmarkTimer;
+  benchmarkTimer.start();
+  for (unsigned int frame = 0; frame < numFrames; ++frame) {
+    for (unsigned int i = 0; i < numInstances; ++i) {
+      const auto& clip = animClips[clipNrs[i]];
+      playTimes[i] = std::fmod(playTimes[i] + deltaTime * clip->getClipTicksPerSecond(), clip->getClipDuration());
+    }
+
+    unsigned int clipStart = 0;
+    while (clipStart < numInstances) {
+      unsigned int clipEnd = clipStart;
+      while (clipEnd < numInstances && clipNrs[clipEnd] == clipNrs[clipStart]) {
+        ++clipEnd;
+      }
+      AssimpAnimSampler::sampleClip(animClips[clipNrs[clipStart]], playTimes.data() + clipStart, clipEnd - clipStart, numBones,
+        batchData.data() + clipStart * numBones, cursorPtrs.data() + clipStart, useNlerp);
+      clipStart = clipEnd;
+    }
+  }
+  return benchmarkTimer.stop();
+}
+
+/* instances are grouped by clip, like in the renderer */
+static void createBenchmarkInstances(const std::vector<std::shared_ptr<AssimpAnimClip>>& animClips, unsigned int numInstances,
+    std::vector<unsigned int>& clipNrs, std::vector<float>& startTimes) {
+  clipNrs.resize(numInstances);
+  startTimes.resize(numInstances);
+  for (unsigned int i = 0; i < numInstances; ++i) {
+    clipNrs.at(i) = static_cast<unsigned int>(static_cast<size_t>(i) * animClips.size() / numInstances);
+    startTimes.at(i) = static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX) * animClips.at(clipNrs.at(i))->getClipDuration();
+  }
+}
+
+/* copy of the key lookup of AssimpAnimChannel before the playback cursors, the baseline of animSampling().
+ * std::lower_bound and checked access on every sample */
+struct BinarySearchChannel {
+  std::vector<float> bscTranslationTimings;
+  std::vector<float> bscInverseTranslationTimeDiffs;
+  std::vector<glm::vec3> bscTranslations;
+  std::vector<float> bscRotationTimings;
+  std::vector<float> bscInverseRotationTimeDiffs;
+  std::vector<glm::quat> bscRotations;
+  std::vector<float> bscScaleTimings;
+  std::vector<float> bscInverseScaleTimeDiffs;
+  std::vector<glm::vec3> bscScalings;
+  unsigned int bscPreState = 0;
+  unsigned int bscPostState = 0;
+};
+
+static std::vector<float> createInverseTimeDiffs(const std::vector<float>& timings) {
+  std::vector<float> inverseTimeDiffs;
+  for (size_t i = 0; i + 1 < timings.size(); ++i) {
+    inverseTimeDiffs.emplace_back(1.0f / (timings.at(i + 1) - timings.at(i)));
+  }
+  return inverseTimeDiffs;
+}
+
+static BinarySearchChannel createBinarySearchChannel(const std::shared_ptr<AssimpAnimChannel>& channel) {
+  BinarySearchChannel searchChannel;
+  searchChannel.bscTranslationTimings = channel->getTranslationTimings();
+  searchChannel.bscInverseTranslationTimeDiffs = createInverseTimeDiffs(searchChannel.bscTranslationTimings);
+  searchChannel.bscTranslations = channel->getTranslations();
+  searchChannel.bscRotationTimings = channel->getRotationTimings();
+  searchChannel.bscInverseRotationTimeDiffs = createInverseTimeDiffs(searchChannel.bscRotationTimings);
+  searchChannel.bscRotations = channel->getRotations();
+  searchChannel.bscScaleTimings = channel->getScaleTimings();
+  searchChannel.bscInverseScaleTimeDiffs = createInverseTimeDiffs(searchChannel.bscScaleTimings);
+  searchChannel.bscScalings = channel->getScalings();
+  searchChannel.bscPreState = channel->getPreState();
+  searchChannel.bscPostState = channel->getPostState();
+  return searchChannel;
+}
+
+static int findKeyBinarySearch(const std::vector<float>& timings, float time) {
+  auto timeIndexPos = std::lower_bound(timings.begin(), timings.end(), time);
+  /* catch rare cases where time is exaclty zero */
+  return std::max(static_cast<int>(std::distance(timings.begin(), timeIndexPos)) - 1, 0);
+}
+
+/* translations and scalings */
+static glm::vec4 sampleVec3BinarySearch(const std::vector<float>& timings, const std::vector<float>& inverseTimeDiffs,
+    const std::vector<glm::vec3>& keys, unsigned int preState, unsigned int postState, float time, const glm::vec4& emptyValue) {
+  if (keys.empty()) {
+    return emptyValue;
+  }
+
+  if (time < timings.at(0)) {
+    if (preState == 0) {
+      return glm::vec4(0.0f);
+    }
+    if (preState == 1) {
+      return glm::vec4(keys.at(0), 1.0f);
+    }
+  }
+  if (postState == 0 && time > timings.at(timings.size() - 1)) {
+    return glm::vec4(0.0f);
+  }
+  if (postState == 1 && time >= timings.at(timings.size() - 1)) {
+    return glm::vec4(keys.at(keys.size() - 1), 1.0f);
+  }
+  if (keys.size() == 1) {
+    return glm::vec4(keys.at(0), 1.0f);
+  }
+
+  int timeIndex = findKeyBinarySearch(timings, time);
+  float interpolatedTime = (time - timings.at(timeIndex)) * inverseTimeDiffs.at(timeIndex);
+  return glm::vec4(glm::mix(keys.at(timeIndex), keys.at(timeIndex + 1), interpolatedTime), 1.0f);
+}
+
+static glm::vec4 sampleRotationBinarySearch(const BinarySearchChannel& channel, float time) {
+  const std::vector<float>& timings = channel.bscRotationTimings;
+  const std::vector<glm::quat>& keys = channel.bscRotations;
+  const glm::vec4 identityValue = glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
+  if (keys.empty()) {
+    return identityValue;
+  }
+
+  if (time < timings.at(0) && channel.bscPreState == 0) {
+    return identityValue;
+  }
+  if (time > timings.at(timings.size() - 1) && channel.bscPostState == 0) {
+    return identityValue;
+  }
+
+  glm::quat rotation;
+  if (time < timings.at(0) && channel.bscPreState == 1) {
+    rotation = keys.at(0);
+  } else if (time >= timings.at(timings.size() - 1) && channel.bscPostState == 1) {
+    rotation = keys.at(keys.size() - 1);
+  } else if (keys.size() == 1) {
+    rotation = keys.at(0);
+  } else {
+    int timeIndex = findKeyBinarySearch(timings, time);
+    float interpolatedTime = (time - timings.at(timeIndex)) * channel.bscInverseRotationTimeDiffs.at(timeIndex);
+    rotation = glm::normalize(glm::slerp(keys.at(timeIndex), keys.at(timeIndex + 1), interpolatedTime));
+  }
+  return glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w);
+}
+
+BenchmarkResult Benchmark::animSampling(std::shared_ptr<AssimpModel> model, unsigned int numInstances, unsigned int numFrames) {
+  BenchmarkResult result;
+  result.brName = "Animation Sampling";
+  result.brBaselineName = "binary search";
+  result.brOptimizedName = "playback cursor";
+
+  if (!model || !model->hasAnimations()) {
+    Logger::log(1, "%s error: model has no animations\n", __FUNCTION__);
+    result.brDetails = "no animated model selected";
+    return result;
+  }
+
+  const std::vector<std::shared_ptr<AssimpAnimClip>>& animClips = model->getAnimClips();
+
+  /* same random start times and clips for both runs */
+  std::vector<unsigned int> clipNrs(numInstances);
+  std::vector<float> startTimes(numInstances);
+  for (unsigned int i = 0; i < numInstances; ++i) {
+    clipNrs.at(i) = i % animClips.size();
+    startTimes.at(i) = static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX) * animClips.at(clipNrs.at(i))->getClipDuration();
+  }
+
+  /* 60 fps replay */
+  const float deltaTime = 1.0f / 60.0f;
+
+  std::vector<std::vector<BinarySearchChannel>> searchChannels(animClips.size());
+  for (size_t clipNr = 0; clipNr < animClips.size(); ++clipNr) {
+    for (const auto& channel : animClips.at(clipNr)->getChannels()) {
+      searchChannels.at(clipNr).emplace_back(createBinarySearchChannel(channel));
+    }
+  }
+
+  std::vector<NodeTransformData> baselineData;
+  std::vector<NodeTransformData> cursorData;
+  std::vector<std::vector<AnimChannelCursor>> cursors(numInstances);
+
+  Timer benchmarkTimer;
+  size_t numSamples = 0;
+
+  std::vector<float> playTimes = startTimes;
+  benchmarkTimer.start();
+  for (unsigned int frame = 0; frame < numFrames; ++frame) {
+    baselineData.clear();
+    for (unsigned int i = 0; i < numInstances; ++i) {
+      const auto& clip = animClips[clipNrs[i]];
+      playTimes[i] = std::fmod(playTimes[i] + deltaTime * clip->getClipTicksPerSecond(), clip->getClipDuration());
+
+      for (const auto& channel : searchChannels[clipNrs[i]]) {
+        NodeTransformData nodeTransform;
+        nodeTransform.translation = sampleVec3BinarySearch(channel.bscTranslationTimings, channel.bscInverseTranslationTimeDiffs,
+          channel.bscTranslations, channel.bscPreState, channel.bscPostState, playTimes[i], glm::vec4(0.0f));
+        nodeTransform.rotation = sampleRotationBinarySearch(channel, playTimes[i]);
+        nodeTransform.scale = sampleVec3BinarySearch(channel.bscScaleTimings, channel.bscInverseScaleTimeDiffs,
+          channel.bscScalings, channel.bscPreState, channel.bscPostState, playTimes[i], glm::vec4(1.0f));
+        baselineData.emplace_back(nodeTransform);
+      }
+    }
+    numSamples += baselineData.size();
+  }
+  result.brBaselineTime = benchmarkTimer.stop();
+
+  playTimes = startTimes;
+  benchmarkTimer.start();
+  for (unsigned int frame = 0; frame < numFrames; ++frame) {
+    cursorData.clear();
+    for (unsigned int i = 0; i < numInstances; ++i) {
+      const auto& clip = animClips[clipNrs[i]];
+      const auto& channels = clip->getChannels();
+      playTimes[i] = std::fmod(playTimes[i] + deltaTime * clip->getClipTicksPerSecond(), clip->getClipDuration());
+
+      if (cursors[i].size() != channels.size()) {
+        cursors[i].resize(channels.size());
+      }
+
+      for (size_t c = 0; c < channels.size(); ++c) {
+        AnimChannelCursor& cursor = cursors[i][c];
+        NodeTransformData nodeTransform;
+        nodeTransform.translation = channels[c]->getTranslation(playTimes[i], cursor.translationKey);
+        nodeTransform.rotation = channels[c]->getRotation(playTimes[i], cursor.rotationKey);
+        nodeTransform.scale = channels[c]->getScaling(playTimes[i], cursor.scaleKey);
+        cursorData.emplace_back(nodeTransform);
+      }
+    }
+  }
+  result.brOptimizedTime = benchmarkTimer.stop();
+
+  /* both paths must deliver the same pose */
+  float maxDiff = 0.0f;
+  for (size_t i = 0; i < baselineData.size(); ++i) {
+    maxDiff = std::max(maxDiff, glm::length(baselineData[i].translation - cursorData[i].translation));
+    maxDiff = std::max(maxDiff, glm::length(baselineData[i].rotation - cursorData[i].rotation));
+    maxDiff = std::max(maxDiff, glm::length(baselineData[i].scale - cursorData[i].scale));
+  }
+
+  result.brDetails = std::to_string(numInstances) + " instances, " + std::to_string(numFrames) + " frames, " +
+    std::to_string(numSamples) + " channel samples, max difference " + std::to_string(maxDiff);
+
+  Logger::log(1, "%s: %s: %f ms, %s: %f ms (%s)\n", __FUNCTION__, result.brBaselineName.c_str(), result.brBaselineTime,
+    result.brOptimizedName.c_str(), result.brOptimizedTime, result.brDetails.c_str());
+
+  return result;
+}
+
+BenchmarkResult Benchmark::animBatchSampling(std::shared_ptr<AssimpModel> model, unsigned int numInstances, unsigned int numFrames) {
+  BenchmarkResult result;
+  result.brName = "Batched Clip Sampling";
+  result.brBaselineName = "per channel";
+  result.brOptimizedName = "packed batch";
+
+  if (!model || !model->hasAnimations() || model->getBoneList().empty()) {
+    Logger::log(1, "%s error: model has no animations\n", __FUNCTION__);
+    result.brDetails = "no animated model selected";
+    return result;
+  }
+
+  const std::vector<std::shared_ptr<AssimpAnimClip>>& animClips = model->getAnimClips();
+  size_t numBones = model->getBoneList().size();
+
+  std::vector<unsigned int> clipNrs;
+  std::vector<float> startTimes;
+  createBenchmarkInstances(animClips, numInstances, clipNrs, startTimes);
+
+  const float deltaTime = 1.0f / 60.0f;
+
+  std::vector<NodeTransformData> channelData(numInstances * numBones);
+  std::vector<NodeTransformData> batchData;
+
+  Timer benchmarkTimer;
+
+  std::vector<float> playTimes = startTimes;
+  std::vector<std::vector<AnimChannelCursor>> cursors(numInstances);
+  benchmarkTimer.start();
+  for (unsigned int frame = 0; frame < numFrames; ++frame) {
+    std::fill(channelData.begin(), channelData.end(), NodeTransformData{});
+    for (unsigned int i = 0; i < numInstances; ++i) {
+      const auto& clip = animClips[clipNrs[i]];
+      const auto& channels = clip->getChannels();
+      playTimes[i] = std::fmod(playTimes[i] + deltaTime * clip->getClipTicksPerSecond(), clip->getClipDuration());
+
+      if (cursors[i].size() != channels.size()) {
+        cursors[i].resize(channels.size());
+      }
+
+      for (size_t c = 0; c < channels.size(); ++c) {
+        int boneId = channels[c]->getBoneId();
+        if (boneId < 0) {
+          continue;
+        }
+        AnimChannelCursor& cursor = cursors[i][c];
+        NodeTransformData& nodeTransform = channelData[i * numBones + boneId];
+        nodeTransform.translation = channels[c]->getTranslation(playTimes[i], cursor.translationKey);
+        nodeTransform.rotation = channels[c]->getRotation(playTimes[i], cursor.rotationKey);
+        nodeTransform.scale = channels[c]->getScaling(playTimes[i], cursor.scaleKey);
+      }
+    }
+  }
+  result.brBaselineTime = benchmarkTimer.stop();
+
+  result.brOptimizedTime = runBatchedSampling(animClips, clipNrs, startTimes, numBones, numFrames, false, batchData);
+
+  /* the sampling is compared on uncompressed copies of the clips, the compression error is reported separately */
+  AnimCompressionSettings uncompressedSettings{};
+  uncompressedSettings.enabled = false;
+  std::vector<std::shared_ptr<AssimpAnimClip>> uncompressedClips{};
+  for (const auto& clip : animClips) {
+    std::shared_ptr<AssimpAnimClip> uncompressedClip = std::make_shared<AssimpAnimClip>(*clip);
+    uncompressedClip->compress(uncompressedSettings);
+    uncompressedClips.emplace_back(uncompressedClip);
+  }
+  std::vector<NodeTransformData> uncompressedData;
+  runBatchedSampling(uncompressedClips, clipNrs, startTimes, numBones, numFrames, false, uncompressedData);
+
+  float maxDiff = 0.0f;
+  float maxCompressionDiff = 0.0f;
+  for (size_t i = 0; i < channelData.size(); ++i) {
+    maxDiff = std::max(maxDiff, glm::length(channelData[i].translation - uncompressedData[i].translation));
+    maxDiff = std::max(maxDiff, glm::length(channelData[i].rotation - uncompressedData[i].rotation));
+    maxDiff = std::max(maxDiff, glm::length(channelData[i].scale - uncompressedData[i].scale));
+    maxCompressionDiff = std::max(maxCompressionDiff, glm::length(uncompressedData[i].translation - batchData[i].translation));
+    maxCompressionDiff = std::max(maxCompressionDiff, glm::length(uncompressedData[i].rotation - batchData[i].rotation));
+    maxCompressionDiff = std::max(maxCompressionDiff, glm::length(uncompressedData[i].scale - batchData[i].scale));
+  }
+
+  result.brDetails = std::to_string(numInstances) + " instances, " + std::to_string(numFrames) + " frames, " +
+    std::to_string(numBones) + " bones, max difference " + std::to_string(maxDiff) +
+    ", max compression difference " + std::to_string(maxCompressionDiff);
+
+  Logger::log(1, "%s: %s: %f ms, %s: %f ms (%s)\n", __FUNCTION__, result.brBaselineName.c_str(), result.brBaselineTime,
+    result.brOptimizedName.c_str(), result.brOptimizedTime, result.brDetails.c_str());
+
+  return result;
+}
+
+BenchmarkResult Benchmark::animSimdInterpolation(std::shared_ptr<AssimpModel> model, unsigned int numInstances, unsigned int numFrames) {
+  BenchmarkResult result;
+  result.brName = "SIMD Interpolation";
+  result.brBaselineName = "scalar kernels";
+  result.brOptimizedName = std::string(AssimpAnimKernels::getSimdLevelName(AssimpAnimKernels::getSupportedSimdLevel())) + " kernels";
+
+  if (!model || !model->hasAnimations() || model->getBoneList().empty()) {
+    Logger::log(1, "%s error: model has no animations\n", __FUNCTION__);
+    result.brDetails = "no animated model selected";
+    return result;
+  }
+
+  const std::vector<std::shared_ptr<AssimpAnimClip>>& animClips = model->getAnimClips();
+  size_t numBones = model->getBoneList().size();
+
+  std::vector<unsigned int> clipNrs;
+  std::vector<float> startTimes;
+  createBenchmarkInstances(animClips, numInstances, clipNrs, startTimes);
+
+  std::vector<NodeTransformData> scalarData;
+  std::vector<NodeTransformData> simdData;
+  std::vector<NodeTransformData> nlerpData;
+
+  simdLevel currentLevel = AssimpAnimKernels::getSimdLevel();
+
+  AssimpAnimKernels::setSimdLevel(simdLevel::scalar);
+  result.brBaselineTime = runBatchedSampling(animClips, clipNrs, startTimes, numBones, numFrames, false, scalarData);
+
+  AssimpAnimKernels::setSimdLevel(AssimpAnimKernels::getSupportedSimdLevel());
+  result.brOptimizedTime = runBatchedSampling(animClips, clipNrs, startTimes, numBones, numFrames, false, simdData);
+  float nlerpTime = runBatchedSampling(animClips, clipNrs, startTimes, numBones, numFrames, true, nlerpData);
+
+  AssimpAnimKernels::setSimdLevel(currentLevel);
+
+  /* compare the final poses: SIMD vs. scalar, and NLERP vs. SLERP as angle */
+  float maxDiff = 0.0f;
+  float maxNlerpAngle = 0.0f;
+  for (size_t i = 0; i < scalarData.size(); ++i) {
+    maxDiff = std::max(maxDiff, glm::length(scalarData[i].translation - simdData[i].translation));
+    maxDiff = std::max(maxDiff, glm::length(scalarData[i].rotation - simdData[i].rotation));
+    maxDiff = std::max(maxDiff, glm::length(scalarData[i].scale - simdData[i].scale));
+
+    float cosAngle = std::min(std::abs(glm::dot(scalarData[i].rotation, nlerpData[i].rotation)), 1.0f);
+    maxNlerpAngle = std::max(maxNlerpAngle, 2.0f * std::acos(cosAngle));
+  }
+
+  float maxClipError = 0.0f;
+  for (const auto& clip : animClips) {
+    maxClipError = std::max(maxClipError, clip->getPackedClip().maxNlerpError);
+  }
+
+  result.brDetails = std::to_string(numInstances) + " instances, " + std::to_string(numFrames) + " frames, max difference " +
+    std::to_string(maxDiff) + ", NLERP: " + std::to_string(nlerpTime) + " ms, max angle error " + std::to_string(glm::degrees(maxNlerpAngle)) +
+    " deg (measured at load: " + std::to_string(glm::degrees(maxClipError)) + " deg)";
+
+  Logger::log(1, "%s: %s: %f ms, %s: %f ms (%s)\n", __FUNCTION__, result.brBaselineName.c_str(), result.brBaselineTime,
+    result.brOptimizedName.c_str(), result.brOptimizedTime, result.brDetails.c_str());
+
+  return result;
+}
+
+/* about a microsecond of dependent floating point math */
+static float stressTask(unsigned int seed) {
+  float value = static_cast<float>(seed % 1024) * 0.001f;
+  for (unsigned int i = 0; i < 64; ++i) {
+    value = std::sin(value) * 0.75f + std::cos(value * 1.5f) * 0.25f;
+  }
+  return value;
+}
+
+BenchmarkResult Benchmark::jobSystemStress(unsigned int numTasks) {
+  BenchmarkResult result;
+  result.brName = "Job System Stress";
+  result.brBaselineName = "single thread";
+  result.brOptimizedName = "job system (" + std::to_string(JobSystem::getActiveThreadCount()) + " threads)";
+
+  std::vector<float> baselineValues(numTasks);
+  std::vector<float> jobValues(numTasks);
+  std::vector<float> parallelForValues(numTasks);
+
+  Timer benchmarkTimer;
+  benchmarkTimer.start();
+  for (unsigned int i = 0; i < numTasks; ++i) {
+    baselineValues[i] = stressTask(i);
+  }
+  result.brBaselineTime = benchmarkTimer.stop();
+
+  /* every task is a single job submitted by this thread, the other threads can only get work by stealing */
+  JobSystem::resetStatistics();
+  benchmarkTimer.start();
+  JobCounter stressJobs;
+  for (unsigned int i = 0; i < numTasks; ++i) {
+    JobSystem::submit([&jobValues, i]() { jobValues[i] = stressTask(i); }, &stressJobs);
+  }
+  JobSystem::wait(stressJobs);
+  result.brOptimizedTime = benchmarkTimer.stop();
+  JobSystemStats submitStats = JobSystem::getStatistics();
+
+  /* the same tasks as range jobs */
+  JobSystem::resetStatistics();
+  benchmarkTimer.start();
+  JobSystem::parallelFor(numTasks, 64, [&parallelForValues](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      parallelForValues[i] = stressTask(static_cast<unsigned int>(i));
+    }
+  });
+  float parallelForTime = benchmarkTimer.stop();
+  JobSystemStats parallelForStats = JobSystem::getStatistics();
+
+  bool resultsMatch = baselineValues == jobValues && baselineValues == parallelForValues;
+
+  float tasksPerSecond = 0.0f;
+  if (result.brOptimizedTime > 0.0f) {
+    tasksPerSecond = numTasks / result.brOptimizedTime * 1000.0f;
+  }
+  float stealRate = 0.0f;
+  if (submitStats.jsJobsExecuted > 0) {
+    stealRate = static_cast<float>(submitStats.jsSteals) / static_cast<float>(submitStats.jsJobsExecuted) * 100.0f;
+  }
+  float stealSuccess = 0.0f;
+  if (submitStats.jsStealAttempts > 0) {
+    stealSuccess = static_cast<float>(submitStats.jsSteals) / static_cast<float>(submitStats.jsStealAttempts) * 100.0f;
+  }
+  float parallelForStealRate = 0.0f;
+  if (parallelForStats.jsJobsExecuted > 0) {
+    parallelForStealRate = static_cast<float>(parallelForStats.jsSteals) / static_cast<float>(parallelForStats.jsJobsExecuted) * 100.0f;
+  }
+
+  result.brDetails = std::to_string(numTasks) + " tasks, " + std::to_string(static_cast<unsigned int>(tasksPerSecond)) + " tasks/s, " +
+    std::to_string(stealRate) + "% of the jobs stolen (" + std::to_string(stealSuccess) + "% of the attempts), " +
+    std::to_string(submitStats.jsJobsRunInline) + " run inline, parallelFor: " + std::to_string(parallelForTime) + " ms, " +
+    std::to_string(parallelForStats.jsJobsExecuted) + " jobs, " + std::to_string(parallelForStealRate) + "% stolen, results " +
+    (resultsMatch ? "match" : "DIFFER");
+
+  Logger::log(1, "%s: %s: %f ms, %s: %f ms (%s)\n", __FUNCTION__, result.brBaselineName.c_str(), result.brBaselineTime,
+    result.brOptimizedName.c_str(), result.brOptimizedTime, result.brDetails.c_str());
+
+  return result;
+}
+
+BenchmarkResult Benchmark::animPoseCache(std::shared_ptr<AssimpModel> model, unsigned int numInstances, unsigned int numFrames, float quantizationStep) {
+  BenchmarkResult result;
+  result.brName = "Pose Cache";
+  result.brBaselineName = "packed batch";
+  result.brOptimizedName = "pose cache";
+
+  if (!model || !model->hasAnimations() || model->getBoneList().empty()) {
+    Logger::log(1, "%s error: model has no animations\n", __FUNCTION__);
+    result.brDetails = "no animated model selected";
+    return result;
+  }
+
+  const std::vector<std::shared_ptr<AssimpAnimClip>>& animClips = model->getAnimClips();
+  size_t numBones = model->getBoneList().size();
+
+  std::vector<unsigned int> clipNrs;
+  std::vector<float> startTimes;
+  createBenchmarkInstances(animClips, numInstances, clipNrs, startTimes);
+
+  /* the pose cache uses the job system, compare single threaded */
+  unsigned int activeThreads = JobSystem::getActiveThreadCount();
+  JobSystem::setActiveThreadCount(1);
+
+  std::vector<NodeTransformData> batchData;
+  result.brBaselineTime = runBatchedSampling(animClips, clipNrs, startTimes, numBones, numFrames, false, batchData);
+
+  const float deltaTime = 1.0f / 60.0f;
+  std::vector<float> playTimes = startTimes;
+  std::vector<NodeTransformData> cacheData(numInstances * numBones);
+  AssimpPoseCache poseCache;
+  poseCache.setQuantizationStep(quantizationStep);
+
+  Timer benchmarkTimer;
+  benchmarkTimer.start();
+  for (unsigned int frame = 0; frame < numFrames; ++frame) {
+    for (unsigned int i = 0; i < numInstances; ++i) {
+      const auto& clip = animClips[clipNrs[i]];
+      playTimes[i] = std::fmod(playTimes[i] + deltaTime * clip->getClipTicksPerSecond(), clip->getClipDuration());
+    }
+
+    unsigned int clipStart = 0;
+    while (clipStart < numInstances) {
+      unsigned int clipEnd = clipStart;
+      while (clipEnd < numInstances && clipNrs[clipEnd] == clipNrs[clipStart]) {
+        ++clipEnd;
+      }
+      poseCache.sampleClip(animClips[clipNrs[clipStart]], playTimes.data() + clipStart, clipEnd - clipStart, numBones,
+        cacheData.data() + clipStart * numBones);
+      clipStart = clipEnd;
+    }
+  }
+  result.brOptimizedTime = benchmarkTimer.stop();
+
+  JobSystem::setActiveThreadCount(activeThreads);
+
+  /* the cached poses are off by up to half a step in time */
+  float maxTranslationDiff = 0.0f;
+  float maxAngle = 0.0f;
+  for (size_t i = 0; i < batchData.size(); ++i) {
+    maxTranslationDiff = std::max(maxTranslationDiff, glm::length(batchData[i].translation - cacheData[i].translation));
+    float cosAngle = std::min(std::abs(glm::dot(batchData[i].rotation, cacheData[i].rotation)), 1.0f);
+    maxAngle = std::max(maxAngle, 2.0f * std::acos(cosAngle));
+  }
+
+  const PoseCacheStats& stats = poseCache.getStatistics();
+  float hitRate = 0.0f;
+  if (stats.pcLookups > 0) {
+    hitRate = static_cast<float>(stats.pcHits) / static_cast<float>(stats.pcLookups) * 100.0f;
+  }
+
+  result.brDetails = std::to_string(numInstances) + " instances, " + std::to_string(numFrames) + " frames, step " +
+    std::to_string(quantizationStep) + " s, hit rate " + std::to_string(hitRate) + "%, " +
+    std::to_string((stats.pcLookups - stats.pcHits) / std::max(numFrames, 1u)) + " poses per frame, max translation difference " +
+    std::to_string(maxTranslationDiff) + ", max angle difference " + std::to_string(glm::degrees(maxAngle)) + " deg";
+
+  Logger::log(1, "%s: %s: %f ms, %s: %f ms (%s)\n", __FUNCTION__, result.brBaselineName.c_str(), result.brBaselineTime,
+    result.brOptimizedName.c_str(), result.brOptimizedTime, result.brDetails.c_str());
+
+  return result;
+}
+
+/* synthetic channel with 'numKeys' equal keys between 'startTime' and 'endTime', DEFAULT pre and post states */
+static aiNodeAnim* createConstantChannel(const std::string& nodeName, unsigned int numKeys, double startTime, double endTime) {
+  aiNodeAnim* nodeAnim = new aiNodeAnim();
+  nodeAnim->mNodeName = aiString(nodeName);
+  nodeAnim->mPreState = aiAnimBehaviour_DEFAULT;
+  nodeAnim->mPostState = aiAnimBehaviour_DEFAULT;
+
+  nodeAnim->mNumPositionKeys = numKeys;
+  nodeAnim->mNumRotationKeys = numKeys;
+  nodeAnim->mNumScalingKeys = numKeys;
+  nodeAnim->mPositionKeys = new aiVectorKey[numKeys];
+  nodeAnim->mRotationKeys = new aiQuatKey[numKeys];
+  nodeAnim->mScalingKeys = new aiVectorKey[numKeys];
+  for (unsigned int i = 0; i < numKeys; ++i) {
+    double time = numKeys > 1 ? startTime + (endTime - startTime) * i / (numKeys - 1) : startTime;
+    nodeAnim->mPositionKeys[i] = aiVectorKey(time, aiVector3D(1.0f, 2.0f, 3.0f));
+    nodeAnim->mRotationKeys[i] = aiQuatKey(time, aiQuaternion(0.0f, 0.6f, 0.0f, 0.8f));
+    nodeAnim->mScalingKeys[i] = aiVectorKey(time, aiVector3D(2.0f, 2.0f, 2.0f));
+  }
+  return nodeAnim;
+}
+
+/* a single-key track and a collapsed track with DEFAULT pre and post states must give the same poses
+ * with and without compression, also before the first and after the last key. returns the number of mismatches */
+static unsigned int checkConstantTrackStates() {
+  aiAnimation animation;
+  animation.mName = aiString("constant track check");
+  animation.mDuration = 30.0;
+  animation.mTicksPerSecond = 1.0;
+  animation.mNumChannels = 2;
+  animation.mChannels = new aiNodeAnim*[2];
+  animation.mChannels[0] = createConstantChannel("single key", 1, 10.0, 10.0);
+  animation.mChannels[1] = createConstantChannel("collapsed", 5, 10.0, 20.0);
+
+  std::vector<std::shared_ptr<AssimpBone>> boneList{};
+  boneList.emplace_back(std::make_shared<AssimpBone>(0, "single key", glm::mat4(1.0f)));
+  boneList.emplace_back(std::make_shared<AssimpBone>(1, "collapsed", glm::mat4(1.0f)));
+  const size_t numBones = boneList.size();
+
+  AnimCompressionSettings uncompressedSettings{};
+  uncompressedSettings.enabled = false;
+  AnimCompressionSettings resampledSettings{};
+  resampledSettings.resample = true;
+
+  std::shared_ptr<AssimpAnimClip> uncompressedClip = std::make_shared<AssimpAnimClip>();
+  uncompressedClip->addChannels(&animation, boneList, uncompressedSettings);
+
+  std::vector<std::shared_ptr<AssimpAnimClip>> compressedClips{};
+  compressedClips.emplace_back(std::make_shared<AssimpAnimClip>());
+  compressedClips.back()->addChannels(&animation, boneList);
+  compressedClips.emplace_back(std::make_shared<AssimpAnimClip>());
+  compressedClips.back()->addChannels(&animation, boneList, resampledSettings);
+
+  /* before, at, between and after the keys */
+  const std::vector<float> times = { 0.0f, 5.0f, 10.0f, 15.0f, 20.0f, 25.0f, 30.0f };
+  std::vector<NodeTransformData> expectedData(times.size() * numBones);
+  AssimpAnimSampler::sampleClip(uncompressedClip, times.data(), times.size(), numBones, expectedData.data());
+
+  unsigned int mismatches = 0;
+  for (const auto& clip : compressedClips) {
+    std::vector<NodeTransformData> sampledData(times.size() * numBones);
+    AssimpAnimSampler::sampleClip(clip, times.data(), times.size(), numBones, sampledData.data());
+    for (size_t i = 0; i < sampledData.size(); ++i) {
+      float diff = glm::length(expectedData[i].translation - sampledData[i].translation) + glm::length(expectedData[i].scale - sampledData[i].scale);
+      float cosAngle = std::abs(glm::dot(expectedData[i].rotation, sampledData[i].rotation));
+      bool bothZero = glm::length(expectedData[i].rotation) == 0.0f && glm::length(sampledData[i].rotation) == 0.0f;
+      if (diff > 0.01f || (!bothZero && cosAngle < 0.9999f)) {
+        Logger::log(1, "%s error: channel %i at time %f differs after compression\n", __FUNCTION__, i % numBones, times[i / numBones]);
+        ++mismatches;
+      }
+    }
+  }
+  return mismatches;
+}
+
+BenchmarkResult Benchmark::animKeyCompression(std::shared_ptr<AssimpModel> model, unsigned int numInstances, unsigned int numFrames) {
+  BenchmarkResult result;
+  result.brName = "Key Compression";
+  result.brBaselineName = "uncompressed";
+  result.brOptimizedName = "compressed";
+
+  if (!model || !model->hasAnimations() || model->getBoneList().empty()) {
+    Logger::log(1, "%s error: model has no animations\n", __FUNCTION__);
+    result.brDetails = "no animated model selected";
+    return result;
+  }
+
+  const std::vector<std::shared_ptr<AssimpAnimClip>>& animClips = model->getAnimClips();
+  size_t numBones = model->getBoneList().size();
+
+  /* copies of the clips, re-packed without compression */
+  AnimCompressionSettings uncompressedSettings{};
+  uncompressedSettings.enabled = false;
+
+  std::vector<std::shared_ptr<AssimpAnimClip>> uncompressedClips{};
+  size_t uncompressedSize = 0;
+  size_t compressedSize = 0;
+  unsigned int rawKeys = 0;
+  unsigned int packedKeys = 0;
+  for (const auto& clip : animClips) {
+    std::shared_ptr<AssimpAnimClip> uncompressedClip = std::make_shared<AssimpAnimClip>(*clip);
+    uncompressedClip->compress(uncompressedSettings);
+    uncompressedClips.emplace_back(uncompressedClip);
+
+    uncompressedSize += uncompressedClip->getCompressionStats().packedSize;
+    compressedSize += clip->getCompressionStats().packedSize;
+    rawKeys += clip->getCompressionStats().rawKeys;
+    packedKeys += clip->getCompressionStats().packedKeys;
+  }
+
+  std::vector<unsigned int> clipNrs;
+  std::vector<float> startTimes;
+  createBenchmarkInstances(animClips, numInstances, clipNrs, startTimes);
+
+  std::vector<NodeTransformData> uncompressedData;
+  std::vector<NodeTransformData> compressedData;
+  result.brBaselineTime = runBatchedSampling(uncompressedClips, clipNrs, startTimes, numBones, numFrames, false, uncompressedData);
+  result.brOptimizedTime = runBatchedSampling(animClips, clipNrs, startTimes, numBones, numFrames, false, compressedData);
+
+  float maxTranslationDiff = 0.0f;
+  float maxAngle = 0.0f;
+  float maxScaleDiff = 0.0f;
+  for (size_t i = 0; i < uncompressedData.size(); ++i) {
+    maxTranslationDiff = std::max(maxTranslationDiff, glm::length(uncompressedData[i].translation - compressedData[i].translation));
+    float cosAngle = std::min(std::abs(glm::dot(uncompressedData[i].rotation, compressedData[i].rotation)), 1.0f);
+    maxAngle = std::max(maxAngle, 2.0f * std::acos(cosAngle));
+    maxScaleDiff = std::max(maxScaleDiff, glm::length(uncompressedData[i].scale - compressedData[i].scale));
+  }
+
+  float ratio = 0.0f;
+  if (compressedSize > 0) {
+    ratio = static_cast<float>(uncompressedSize) / static_cast<float>(compressedSize);
+  }
+
+  result.brDetails = std::to_string(numInstances) + " instances, " + std::to_string(numFrames) + " frames, " +
+    std::to_string(packedKeys) + " of " + std::to_string(rawKeys) + " keys, " + std::to_string(uncompressedSize) + " -> " +
+    std::to_string(compressedSize) + " bytes (" + std::to_string(ratio) + "x), max translation difference " +
+    std::to_string(maxTranslationDiff) + ", max angle difference " + std::to_string(glm::degrees(maxAngle)) +
+    " deg, max scale difference " + std::to_string(maxScaleDiff);
+
+  unsigned int stateMismatches = checkConstantTrackStates();
+  result.brDetails += stateMismatches == 0 ? ", constant track states ok" :
+    ", constant track states: " + std::to_string(stateMismatches) + " mismatches";
+
+  Logger::log(1, "%s: %s: %f ms, %s: %f ms (%s)\n", __FUNCTION__, result.brBaselineName.c_str(), result.brBaselineTime,
+    result.brOptimizedName.c_str(), result.brOptimizedTime, result.brDetails.c_str());
+
+  return result;
+}
+
+BenchmarkResult Benchmark::boneHierarchy(unsigned int numInstances, unsigned int numBones, unsigned int chainLength, unsigned int numFrames) {
+  BenchmarkResult result;
+  result.brName = "Bone Hierarchy";
+  result.brBaselineName = "parent walk";
+  result.brOptimizedName = "level order";
+
+  numBones = std::max(numBones, 2u);
+  chainLength = std::max(chainLength, 2u);
+
+  /* bone 0 is the root, the chains start at the root */
+  std::vector<int32_t> parentIndices(numBones);
+  parentIndices.at(0) = -1;
+  for (unsigned int bone = 1; bone < numBones; ++bone) {
+    parentIndices.at(bone) = (bone - 1) % chainLength == 0 ? 0 : static_cast<int32_t>(bone - 1);
+  }
+
+  std::vector<int32_t> levelOrder;
+  std::vector<int32_t> levelOffsets;
+  AssimpBoneHierarchy::createLevelOrder(parentIndices, levelOrder, levelOffsets);
+
+  /* small random rotations and translations, to keep the global matrices in a sane range */
+  std::vector<glm::mat4> localMatrices(numInstances * numBones);
+  for (auto& localMatrix : localMatrices) {
+    glm::vec3 axis = glm::normalize(glm::vec3(std::rand() % 100 + 1, std::rand() % 100, std::rand() % 100));
+    float angle = static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX) * 0.2f;
+    localMatrix = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.1f, 0.0f)), angle, axis);
+  }
+  std::vector<glm::mat4> offsetMatrices(numBones, glm::mat4(1.0f));
+
+  std::vector<glm::mat4> walkMatrices(numInstances * numBones);
+  std::vector<glm::mat4> levelMatrices(numInstances * numBones);
+  std::vector<glm::mat4> globalMatrices(numBones);
+
+  Timer benchmarkTimer;
+  benchmarkTimer.start();
+  for (unsigned int frame = 0; frame < numFrames; ++frame) {
+    for (unsigned int i = 0; i < numInstances; ++i) {
+      AssimpBoneHierarchy::computeBoneMatricesParentWalk(localMatrices.data() + i * numBones, parentIndices.data(), offsetMatrices.data(),
+        numBones, walkMatrices.data() + i * numBones);
+    }
+  }
+  result.brBaselineTime = benchmarkTimer.stop();
+
+  benchmarkTimer.start();
+  for (unsigned int frame = 0; frame < numFrames; ++frame) {
+    for (unsigned int i = 0; i < numInstances; ++i) {
+      AssimpBoneHierarchy::computeBoneMatricesLevelOrder(localMatrices.data() + i * numBones, parentIndices.data(), levelOrder, offsetMatrices.data(),
+        numBones, globalMatrices.data(), levelMatrices.data() + i * numBones);
+    }
+  }
+  result.brOptimizedTime = benchmarkTimer.stop();
+
+  /* the order of the multiplications differs, allow for some rounding */
+  float maxDiff = 0.0f;
+  for (size_t i = 0; i < walkMatrices.size(); ++i) {
+    for (int c = 0; c < 4; ++c) {
+      maxDiff = std::max(maxDiff, glm::length(walkMatrices[i][c] - levelMatrices[i][c]));
+    }
+  }
+
+  result.brDetails = std::to_string(numInstances) + " instances, " + std::to_string(numFrames) + " frames, " + std::to_string(numBones) +
+    " bones in " + std::to_string(levelOffsets.size() - 1) + " levels, max difference " + std::to_string(maxDiff);
+
+  Logger::log(1, "%s: %s: %f ms, %s: %f ms (%s)\n", __FUNCTION__, result.brBaselineName.c_str(), result.brBaselineTime,
+    result.brOptimizedName.c_str(), result.brOptimizedTime, result.brDetails.c_str());
+
+  return result;
+}
+
+BenchmarkResult Benchmark::worldMatrixBuild(unsigned int numInstances, unsigned int numFrames) {
+  BenchmarkResult result;
+  result.brName = "World Matrices (" + std::to_string(numInstances) + " instances)";
+  result.brBaselineName = "glm per instance";
+  result.brOptimizedName = std::string(AssimpAnimKernels::getSimdLevelName(AssimpAnimKernels::getSimdLevel())) + " batch, " +
+    std::to_string(JobSystem::getActiveThreadCount()) + " threads";
+
+  /* same chunk size as the instance store */
+  const size_t grainSize = 1024;
+
+  std::vector<glm::vec3> positions(numInstances);
+  std::vector<glm::vec3> rotations(numInstances);
+  std::vector<float> scales(numInstances);
+  std::vector<uint8_t> swapYZAxis(numInstances);
+  for (unsigned int i = 0; i < numInstances; ++i) {
+    positions.at(i) = glm::vec3(std::rand() % 2000 - 1000, std::rand() % 100, std::rand() % 2000 - 1000);
+    rotations.at(i) = glm::vec3(std::rand() % 360 - 180, std::rand() % 360 - 180, std::rand() % 360 - 180);
+    scales.at(i) = static_cast<float>(std::rand() % 1000 + 1) / 100.0f;
+    swapYZAxis.at(i) = i % 2;
+  }
+  glm::mat4 modelRootMatrix = glm::scale(glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f)), glm::vec3(0.01f));
+
+  std::vector<glm::mat4> glmMatrices(numInstances);
+  std::vector<glm::mat4> batchMatrices(numInstances);
+
+  Timer benchmarkTimer;
+  benchmarkTimer.start();
+  for (unsigned int frame = 0; frame < numFrames; ++frame) {
+    for (unsigned int i = 0; i < numInstances; ++i) {
+      glmMatrices[i] = AssimpInstanceStore::createWorldMatrix(positions[i], rotations[i], scales[i], swapYZAxis[i] != 0, modelRootMatrix);
+    }
+  }
+  result.brBaselineTime = benchmarkTimer.stop();
+
+  benchmarkTimer.start();
+  for (unsigned int frame = 0; frame < numFrames; ++frame) {
+    AssimpTransformKernels::buildWorldMatrices(positions.data(), rotations.data(), scales.data(), swapYZAxis.data(), modelRootMatrix, nullptr,
+      numInstances, batchMatrices.data());
+  }
+  float singleThreadTime = benchmarkTimer.stop();
+
+  benchmarkTimer.start();
+  for (unsigned int frame = 0; frame < numFrames; ++frame) {
+    JobSystem::parallelFor(numInstances, grainSize, [&](size_t begin, size_t end) {
+      /* the chunk is passed as its own arrays, no index list needed */
+      AssimpTransformKernels::buildWorldMatrices(positions.data() + begin, rotations.data() + begin, scales.data() + begin,
+        swapYZAxis.data() + begin, modelRootMatrix, nullptr, end - begin, batchMatrices.data() + begin);
+    });
+  }
+  result.brOptimizedTime = benchmarkTimer.stop();
+
+  /* the polynomial sine and cosine differ in the last bits */
+  float maxDiff = 0.0f;
+  for (size_t i = 0; i < glmMatrices.size(); ++i) {
+    for (int c = 0; c < 4; ++c) {
+      maxDiff = std::max(maxDiff, glm::length(glmMatrices[i][c] - batchMatrices[i][c]));
+    }
+  }
+
+  result.brDetails = std::to_string(numFrames) + " frames, single thread batch: " + std::to_string(singleThreadTime) + " ms, max difference " +
+    std::to_string(maxDiff);
+
+  Logger::log(1, "%s: %s: %f ms, %s: %f ms (%s)\n", __FUNCTION__, result.brBaselineName.c_str(), result.brBaselineTime,
+    result.brOptimizedName.c_str(), result.brOptimizedTime, result.brDetails.c_str());
+
+  return result;
+}
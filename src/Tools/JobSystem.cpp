@@ -0,0 +1,321 @@
+#include <algorithm>
+#include <chrono>
+
+#include "Tools/JobSystem.hpp"
+#include "Tools/Logger.hpp"
+
+std::vector<std::unique_ptr<JobSystem::WorkerQueue>> JobSystem::mQueues{};
+std::vector<std::thread> JobSystem::mWorkers{};
+std::atomic<unsigned int> JobSystem::mActiveThreads{1};
+std::atomic<int> JobSystem::mQueuedJobs{0};
+
+std::mutex JobSystem::mSleepMutex{};
+std::condition_variable JobSystem::mWakeCondition{};
+std::atomic<int> JobSystem::mSleepingWorkers{0};
+std::atomic<bool> JobSystem::mShutdown{false};
+
+/* worker threads use their own queue, all other threads share the first queue */
+static thread_local unsigned int sQueueIndex = 0;
+static thread_local unsigned int sNextVictim = 0;
+
+void JobSystem::init(unsigned int numThreads) {
+  if (!mQueues.empty()) {
+    Logger::log(1, "%s warning: job system already running\n", __FUNCTION__);
+    return;
+  }
+
+  if (numThreads == 0) {
+    numThreads = getHardwareThreadCount();
+  }
+
+  for (unsigned int i = 0; i < numThreads; ++i) {
+    mQueues.emplace_back(std::make_unique<WorkerQueue>());
+  }
+  mActiveThreads = numThreads;
+  mShutdown = false;
+
+  /* the calling thread owns the first queue */
+  sQueueIndex = 0;
+  for (unsigned int i = 1; i < numThreads; ++i) {
+    mWorkers.emplace_back(&JobSystem::workerLoop, i);
+  }
+
+  Logger::log(1, "%s: job system started with %i threads\n", __FUNCTION__, numThreads);
+}
+
+void JobSystem::cleanup() {
+  {
+    std::lock_guard<std::mutex> lock(mSleepMutex);
+    mShutdown = true;
+  }
+  mWakeCondition.notify_all();
+
+  for (auto& worker : mWorkers) {
+    worker.join();
+  }
+  mWorkers.clear();
+  mQueues.clear();
+  mQueuedJobs = 0;
+}
+
+unsigned int JobSystem::getThreadCount() {
+  return std::max(static_cast<unsigned int>(mQueues.size()), 1u);
+}
+
+unsigned int JobSystem::getHardwareThreadCount() {
+  /* may return zero if the number is unknown */
+  return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+void JobSystem::setActiveThreadCount(unsigned int numThreads) {
+  mActiveThreads = std::clamp(numThreads, 1u, getThreadCount());
+  {
+    std::lock_guard<std::mutex> lock(mSleepMutex);
+  }
+  mWakeCondition.notify_all();
+}
+
+unsigned int JobSystem::getActiveThreadCount() {
+  return mActiveThreads;
+}
+
+unsigned int JobSystem::getQueueIndex() {
+  return sQueueIndex;
+}
+
+void JobSystem::submit(std::function<void()> job, JobCounter* counter) {
+  if (counter) {
+    ++counter->jcPending;
+  }
+
+  Job newJob;
+  newJob.jbFunction = std::move(job);
+  newJob.jbCounter = counter;
+  push(newJob);
+}
+
+void JobSystem::submitAfter(JobCounter& dependency, std::function<void()> job, JobCounter* counter) {
+  if (counter) {
+    ++counter->jcPending;
+  }
+
+  Job newJob;
+  newJob.jbFunction = std::move(job);
+  newJob.jbCounter = counter;
+
+  {
+    /* the counter is decremented with the lock held, no continuation can be missed */
+    std::lock_guard<std::mutex> lock(dependency.jcMutex);
+    if (dependency.jcPending > 0) {
+      dependency.jcContinuations.emplace_back(std::move(newJob));
+      return;
+    }
+  }
+  push(newJob);
+}
+
+void JobSystem::wait(JobCounter& counter) {
+  unsigned int queueIndex = getQueueIndex();
+
+  while (counter.jcPending > 0) {
+    Job job;
+    if (!mQueues.empty() && findJob(queueIndex, job)) {
+      execute(queueIndex, job);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+  /* the last job may still hold the lock, the counter is destroyed after we return */
+  std::lock_guard<std::mutex> lock(counter.jcMutex);
+}
+
+float JobSystem::runRange(size_t count, size_t grainSize, JobRangeFunction func, const void* context) {
+  if (count == 0) {
+    return 0.0f;
+  }
+
+  JobCounter counter;
+  counter.jcPending = 1;
+
+  Job job;
+  job.jbRangeFunction = func;
+  job.jbContext = context;
+  job.jbBegin = 0;
+  job.jbEnd = count;
+  job.jbGrainSize = std::max(grainSize, static_cast<size_t>(1));
+  job.jbCounter = &counter;
+
+  /* start splitting on this thread, the other threads steal the larger halves */
+  execute(getQueueIndex(), job);
+  wait(counter);
+
+  return counter.jcWorkTimeMicroSeconds / 1000.0f;
+}
+
+void JobSystem::push(Job& job) {
+  if (mQueues.empty()) {
+    execute(0, job);
+    return;
+  }
+
+  unsigned int queueIndex = getQueueIndex();
+  WorkerQueue& queue = *mQueues.at(queueIndex);
+
+  bool queued = false;
+  {
+    std::lock_guard<std::mutex> lock(queue.wqMutex);
+    if (queue.wqBottom - queue.wqTop < WorkerQueue::capacity) {
+      queue.wqJobs[queue.wqBottom % WorkerQueue::capacity] = std::move(job);
+      ++queue.wqBottom;
+      ++queue.wqSize;
+      queued = true;
+    }
+  }
+
+  if (!queued) {
+    ++queue.wqJobsRunInline;
+    execute(queueIndex, job);
+    return;
+  }
+
+  ++mQueuedJobs;
+  /* a sleeping worker has registered before checking the queued jobs, so the notify cannot get lost */
+  if (mSleepingWorkers > 0) {
+    {
+      std::lock_guard<std::mutex> lock(mSleepMutex);
+    }
+    mWakeCondition.notify_one();
+  }
+}
+
+bool JobSystem::findJob(unsigned int queueIndex, Job& job) {
+  WorkerQueue& ownQueue = *mQueues.at(queueIndex);
+
+  /* newest job of the own queue first, it is most likely still in the cache */
+  if (ownQueue.wqSize > 0) {
+    std::lock_guard<std::mutex> lock(ownQueue.wqMutex);
+    if (ownQueue.wqBottom > ownQueue.wqTop) {
+      --ownQueue.wqBottom;
+      job = std::move(ownQueue.wqJobs[ownQueue.wqBottom % WorkerQueue::capacity]);
+      --ownQueue.wqSize;
+      --mQueuedJobs;
+      return true;
+    }
+  }
+
+  /* steal the oldest job of another queue, for range jobs this is the largest part */
+  size_t numQueues = mQueues.size();
+  for (size_t i = 1; i < numQueues; ++i) {
+    WorkerQueue& victim = *mQueues.at((queueIndex + sNextVictim + i) % numQueues);
+    if (victim.wqSize == 0) {
+      continue;
+    }
+
+    ++ownQueue.wqStealAttempts;
+    std::lock_guard<std::mutex> lock(victim.wqMutex);
+    if (victim.wqBottom > victim.wqTop) {
+      job = std::move(victim.wqJobs[victim.wqTop % WorkerQueue::capacity]);
+      ++victim.wqTop;
+      --victim.wqSize;
+      --mQueuedJobs;
+      ++ownQueue.wqSteals;
+      sNextVictim = static_cast<unsigned int>(i - 1);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void JobSystem::execute(unsigned int queueIndex, Job& job) {
+  if (job.jbRangeFunction) {
+    size_t begin = job.jbBegin;
+    size_t end = job.jbEnd;
+
+    /* keep the lower half, leave the upper half for other threads */
+    while (end - begin > job.jbGrainSize) {
+      size_t middle = begin + (end - begin) / 2;
+
+      Job upperHalf;
+      upperHalf.jbRangeFunction = job.jbRangeFunction;
+      upperHalf.jbContext = job.jbContext;
+      upperHalf.jbBegin = middle;
+      upperHalf.jbEnd = end;
+      upperHalf.jbGrainSize = job.jbGrainSize;
+      upperHalf.jbCounter = job.jbCounter;
+
+      ++job.jbCounter->jcPending;
+      push(upperHalf);
+
+      end = middle;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    job.jbRangeFunction(job.jbContext, begin, end);
+    auto stopTime = std::chrono::steady_clock::now();
+    job.jbCounter->jcWorkTimeMicroSeconds += std::chrono::duration_cast<std::chrono::microseconds>(stopTime - startTime).count();
+  } else if (job.jbFunction) {
+    job.jbFunction();
+  }
+
+  if (!mQueues.empty()) {
+    ++mQueues.at(queueIndex)->wqJobsExecuted;
+  }
+  finishJob(job.jbCounter);
+}
+
+void JobSystem::finishJob(JobCounter* counter) {
+  if (!counter) {
+    return;
+  }
+
+  std::vector<Job> continuations;
+  {
+    std::lock_guard<std::mutex> lock(counter->jcMutex);
+    if (--counter->jcPending == 0) {
+      continuations.swap(counter->jcContinuations);
+    }
+  }
+
+  for (auto& job : continuations) {
+    push(job);
+  }
+}
+
+void JobSystem::workerLoop(unsigned int queueIndex) {
+  sQueueIndex = queueIndex;
+
+  while (!mShutdown) {
+    Job job;
+    if (queueIndex < mActiveThreads && findJob(queueIndex, job)) {
+      execute(queueIndex, job);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(mSleepMutex);
+    ++mSleepingWorkers;
+    mWakeCondition.wait(lock, [queueIndex]() { return mShutdown || (queueIndex < mActiveThreads && mQueuedJobs > 0); });
+    --mSleepingWorkers;
+  }
+}
+
+JobSystemStats JobSystem::getStatistics() {
+  JobSystemStats stats{};
+  for (const auto& queue : mQueues) {
+    stats.jsJobsExecuted += queue->wqJobsExecuted;
+    stats.jsStealAttempts += queue->wqStealAttempts;
+    stats.jsSteals += queue->wqSteals;
+    stats.jsJobsRunInline += queue->wqJobsRunInline;
+  }
+  return stats;
+}
+
+void JobSystem::resetStatistics() {
+  for (const auto& queue : mQueues) {
+    queue->wqJobsExecuted = 0;
+    queue->wqStealAttempts = 0;
+    queue->wqSteals = 0;
+    queue->wqJobsRunInline = 0;
+  }
+}